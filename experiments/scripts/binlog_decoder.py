@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+
+# Decodes the print_dbg binary log records dumped by the nodes when
+# BINARY_LOG_RAW_DUMP is enabled in debug_settings.h. The records only contain
+# the address of the format string, so the firmware elf file the node was
+# running is needed. Lines that are not binary log records are printed as is.
+
+import re
+import struct
+import sys
+
+if len(sys.argv) < 3:
+    print("Usage: {} firmware.elf log_path".format(sys.argv[0]))
+    quit()
+
+# Argument sizes on the ARM EABI, long double is the same as double
+INT_SIZE = 4
+POINTER_SIZE = 4
+SIZES = {'': 4, 'hh': 4, 'h': 4, 'l': 4, 'll': 8, 'z': 4, 'j': 8, 't': 4}
+
+SPECIFIER = re.compile(r'%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?(hh|h|ll|l|z|j|t|L)?([diuxXocfFeEgGaAspn%])')
+
+
+class Elf:
+    """Minimal reader of the allocated sections of a 32 bit little endian elf"""
+
+    def __init__(self, path):
+        with open(path, "rb") as file:
+            self.data = file.read()
+        if self.data[:4] != b'\x7fELF' or self.data[4] != 1 or self.data[5] != 1:
+            raise ValueError("{} is not a 32 bit little endian elf".format(path))
+        shoff, = struct.unpack_from('<I', self.data, 0x20)
+        shentsize, shnum = struct.unpack_from('<HH', self.data, 0x2e)
+        self.sections = []
+        for i in range(shnum):
+            (_, sh_type, sh_flags, sh_addr, sh_offset,
+             sh_size) = struct.unpack_from('<IIIIII', self.data, shoff + i * shentsize)
+            SHT_NOBITS = 8
+            SHF_ALLOC = 2
+            if sh_flags & SHF_ALLOC and sh_type != SHT_NOBITS:
+                self.sections.append((sh_addr, sh_size, sh_offset))
+
+    def string(self, address):
+        for addr, size, offset in self.sections:
+            if addr <= address < addr + size:
+                start = offset + address - addr
+                end = self.data.index(b'\0', start)
+                return self.data[start:end].decode('ascii', 'replace')
+        return None
+
+
+def unpack(fmt, args, pos, size):
+    if pos + size > len(args):
+        raise IndexError
+    return struct.unpack_from(fmt, args, pos)[0], pos + size
+
+
+def format_record(fmt, args, truncated):
+    result = []
+    pos = 0
+    last = 0
+    try:
+        for match in SPECIFIER.finditer(fmt):
+            result.append(fmt[last:match.start()])
+            last = match.end()
+            flags, width, precision, length, conv = match.groups()
+            length = length or ''
+            if conv == '%':
+                result.append('%')
+                continue
+            if width == '*':
+                width, pos = unpack('<i', args, pos, INT_SIZE)
+            if precision == '*':
+                precision, pos = unpack('<i', args, pos, INT_SIZE)
+            spec = '%' + flags + (str(width) if width is not None else '')
+            if precision is not None:
+                spec += '.' + str(precision)
+            if conv == 's':
+                if pos >= len(args):
+                    raise IndexError
+                end = args.index(b'\0', pos)
+                value = args[pos:end].decode('ascii', 'replace')
+                pos = end + 1
+                result.append((spec + 's') % value)
+            elif conv in 'pn':
+                value, pos = unpack('<I', args, pos, POINTER_SIZE)
+                if conv == 'p':
+                    result.append('0x%x' % value)
+            elif conv in 'fFeEgGaA':
+                value, pos = unpack('<d', args, pos, 8)
+                result.append(value.hex() if conv in 'aA' else (spec + conv) % value)
+            else:
+                size = SIZES[length]
+                signed = conv in 'di'
+                code = {4: 'i', 8: 'q'}[size]
+                value, pos = unpack('<' + (code if signed else code.upper()), args, pos, size)
+                if conv == 'c':
+                    result.append((spec + 'c') % chr(value & 0xff))
+                else:
+                    result.append((spec + conv.replace('u', 'd')) % value)
+        result.append(fmt[last:])
+        if truncated:
+            # A string argument was shortened, the record ends with ' t'
+            result.append('[truncated]\n')
+    except IndexError:
+        result.append('[truncated]\n')
+    return ''.join(result)
+
+
+elf = Elf(sys.argv[1])
+record = re.compile(r'\[BL\] (?P<hex>[0-9a-f]+)(?P<truncated> t)?')
+with open(sys.argv[2], "r") as file:
+    for line in file:
+        match = record.search(line)
+        if not match:
+            sys.stdout.write(line)
+            continue
+        raw = bytes.fromhex(match.group('hex'))
+        address, = struct.unpack_from('<I', raw, 0)
+        fmt = elf.string(address)
+        if fmt is None:
+            sys.stdout.write("[BL] unknown format string at 0x{:08x}\n".format(address))
+            continue
+        sys.stdout.write(format_record(fmt, raw[4:], match.group('truncated') is not None))
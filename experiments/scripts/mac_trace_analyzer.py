@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+
+# Analyzes the MAC trace printed by the nodes when ENABLE_MAC_TRACE_DBG is
+# enabled in debug_settings.h. Pass the logs of all the nodes (or the single
+# simulator log) to compute the per-stream packet reception ratio and latency,
+# and the histogram of the slot overruns.
+
+import re
+import sys
+from collections import defaultdict
+
+if len(sys.argv) < 2:
+    print("Usage: {} log_path [log_path...]".format(sys.argv[0]))
+    quit()
+
+record = re.compile(r'\[MT\] n=(?P<node>\d+) t=(?P<time>-?\d+) p=(?P<phase>\d) '
+                    r'e=(?P<event>\w+) sl=(?P<slack>-?\d+) '
+                    r's=(?P<src>\d+),(?P<dst>\d+),(?P<sport>\d+),(?P<dport>\d+) '
+                    r'nd=(?P<nd>\d+) r=(?P<rssi>-?\d+) err=(?P<err>-?\d+)')
+dropped_re = re.compile(r'\[MT\] n=(?P<node>\d+) dropped=(?P<dropped>\d+)')
+
+PHASES = ['data', 'uplink', 'downlink']
+# Upper bounds in microseconds of the overrun histogram buckets
+OVERRUN_BUCKETS = [10, 100, 1000, 10000]
+# Upper bounds in milliseconds of the latency histogram buckets
+LATENCY_BUCKETS = [10, 100, 1000, 10000]
+
+received = defaultdict(int)
+missed = defaultdict(int)
+sends = defaultdict(list)      # stream -> send times at the source
+receptions = defaultdict(list) # stream -> reception times at the destination
+slots = defaultdict(int)
+overruns = defaultdict(lambda: [0] * (len(OVERRUN_BUCKETS) + 1))
+dropped = dict()
+gaps = defaultdict(list)       # node -> (first dropped slot time, count)
+
+for path in sys.argv[1:]:
+    with open(path, "r") as file:
+        for line in file:
+            match = record.search(line)
+            if not match:
+                match = dropped_re.search(line)
+                if match:
+                    dropped[int(match.group('node'))] = int(match.group('dropped'))
+                continue
+            node = int(match.group('node'))
+            time = int(match.group('time'))
+            event = match.group('event')
+            if event == 'gap':
+                gaps[node].append((time, int(match.group('err'))))
+                continue
+            phase = PHASES[int(match.group('phase'))]
+            slack = int(match.group('slack'))
+            stream = tuple(int(match.group(k)) for k in ('src', 'dst', 'sport', 'dport'))
+            slots[phase] += 1
+            if slack < 0:
+                bucket = len(OVERRUN_BUCKETS)
+                for i, bound in enumerate(OVERRUN_BUCKETS):
+                    if -slack < bound * 1000:
+                        bucket = i
+                        break
+                overruns[phase][bucket] += 1
+            if event == 'dsend' and node == stream[0]:
+                sends[stream].append(time)
+            elif event == 'drecv' and node == stream[1]:
+                received[stream] += 1
+                receptions[stream].append(time)
+            elif event == 'dmiss' and node == stream[1]:
+                missed[stream] += 1
+
+
+def histogram(values, bounds, unit):
+    counts = [0] * (len(bounds) + 1)
+    for v in values:
+        counts[next((i for i, b in enumerate(bounds) if v < b), len(bounds))] += 1
+    labels = ["<{}{}".format(b, unit) for b in bounds] + [">={}{}".format(bounds[-1], unit)]
+    return ' '.join("{}:{}".format(l, c) for l, c in zip(labels, counts))
+
+
+print("### Streams ###")
+for stream in sorted(set(received) | set(missed)):
+    total = received[stream] + missed[stream]
+    prr = 100.0 * received[stream] / total
+    # The latency of a packet is from its last send at the source to its
+    # reception at the destination, both as slot start network times
+    latencies = []
+    sendTimes = sorted(sends[stream])
+    i = 0
+    for t in sorted(receptions[stream]):
+        while i < len(sendTimes) and sendTimes[i] <= t:
+            i += 1
+        if i > 0:
+            latencies.append((t - sendTimes[i - 1]) / 1e6)
+    print("({},{},{},{}) PRR={:.2f}% ({}/{})".format(*stream, prr, received[stream], total))
+    if latencies:
+        print("  latency min={:.3f}ms avg={:.3f}ms max={:.3f}ms".format(
+              min(latencies), sum(latencies) / len(latencies), max(latencies)))
+        print("  " + histogram(latencies, LATENCY_BUCKETS, "ms"))
+    else:
+        print("  latency unknown, the log of the source node is missing")
+
+print("\n### Slot overruns ###")
+labels = ["<{}us".format(b) for b in OVERRUN_BUCKETS] + [">={}us".format(OVERRUN_BUCKETS[-1])]
+for phase in PHASES:
+    if slots[phase] == 0:
+        continue
+    counts = overruns[phase]
+    print("{}: {} overruns in {} traced slots".format(phase, sum(counts), slots[phase]))
+    print("  " + ' '.join("{}:{}".format(l, c) for l, c in zip(labels, counts)))
+
+for node in sorted(dropped):
+    print("Node {} dropped {} trace records".format(node, dropped[node]))
+    for time, count in gaps[node]:
+        print("  {} from t={:.3f}s".format(count, time / 1e9))
@@ -44,6 +44,7 @@ using namespace std;
 using namespace mxnet;
 using namespace miosix;
 
+// Also see network_module/util/network_size.h to fix the network size at build time
 const int maxNodes = 16;
 const int maxHops = 6;
 
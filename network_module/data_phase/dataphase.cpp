@@ -27,6 +27,7 @@
 
 #include "dataphase.h"
 #include "../util/debug_settings.h"
+#include "../util/event_log.h"
 #include <unistd.h>
 
 using namespace std;
@@ -35,6 +36,7 @@ using namespace miosix;
 namespace mxnet {
 
 void DataPhase::execute(long long slotStart) {
+    lastPacketSize = 0;
     // Empty schedule
     if(scheduleTiles == 0) {
         this->sleep(slotStart);
@@ -75,6 +77,7 @@ void DataPhase::execute(long long slotStart) {
 }
 
 void DataPhase::advance(long long slotStart) {
+    lastPacketSize = 0;
     // Empty schedule
     if(scheduleTiles == 0) {
         this->sleep(slotStart);
@@ -115,6 +118,8 @@ void DataPhase::sendFromStream(long long slotStart, StreamId id) {
         ctx.configureTransceiver(ctx.getTransceiverConfig());
         pkt.send(ctx, slotStart);
         ctx.transceiverIdle();
+        lastPacketSize = pkt.size();
+        ctx.getMACTrace().event(MACTraceEvent::DATA_SEND, id);
         if(ENABLE_DATA_INFO_DBG) {
             auto nt = NetworkTime::fromLocalTime(slotStart);
             if(COMPRESSED_DBG==false)
@@ -132,11 +137,16 @@ void DataPhase::receiveToStream(long long slotStart, StreamId id) {
     ctx.configureTransceiver(ctx.getTransceiverConfig());
     auto rcvResult = pkt.recv(ctx, slotStart);
     ctx.transceiverIdle();
+    if(rcvResult.error != RecvResult::ErrorCode::TIMEOUT)
+        lastPacketSize = rcvResult.size;
     bool periodEnd = false;
     if(rcvResult.error == RecvResult::ErrorCode::OK &&
        pkt.checkPanHeader(panId) == true &&
        checkStreamId(pkt, id) == true) {
-        periodEnd = stream.receivePacket(id, pkt);
+        periodEnd = stream.receivePacket(id, pkt, slotIndex);
+        ctx.getMACTrace().event(MACTraceEvent::DATA_RECV, id, 0, rcvResult.rssi);
+        EventLog::record(EventType::PACKET_RECV, NetworkTime::fromLocalTime(slotStart).get(),
+                         id.getKey(), rcvResult.rssi);
         if(ENABLE_DATA_INFO_DBG) {
             auto nt = NetworkTime::fromLocalTime(slotStart);
             if(COMPRESSED_DBG==false)
@@ -148,6 +158,9 @@ void DataPhase::receiveToStream(long long slotStart, StreamId id) {
     // Avoid overwriting valid data
     else {
         periodEnd = stream.missPacket(id);
+        ctx.getMACTrace().event(MACTraceEvent::DATA_MISS, id);
+        EventLog::record(EventType::PACKET_MISS, NetworkTime::fromLocalTime(slotStart).get(),
+                         id.getKey());
         if(ENABLE_DATA_ERROR_DBG) {
             auto nt = NetworkTime::fromLocalTime(slotStart);
             if(COMPRESSED_DBG==false)
@@ -177,6 +190,8 @@ void DataPhase::sendFromBuffer(long long slotStart,
         ctx.configureTransceiver(ctx.getTransceiverConfig());
         buffer->send(ctx, slotStart);
         ctx.transceiverIdle();
+        lastPacketSize = buffer->size();
+        ctx.getMACTrace().event(MACTraceEvent::DATA_FORWARD, id);
 
         incrementBufCtr(id);
         if(lastTransmission(id)) {
@@ -202,9 +217,14 @@ void DataPhase::receiveToBuffer(long long slotStart,
     ctx.configureTransceiver(ctx.getTransceiverConfig());
     auto rcvResult = buffer->recv(ctx, slotStart);
     ctx.transceiverIdle();
+    if(rcvResult.error != RecvResult::ErrorCode::TIMEOUT)
+        lastPacketSize = rcvResult.size;
     if(rcvResult.error != RecvResult::ErrorCode::OK || buffer->checkPanHeader(panId) == false) {
         // Delete received packet if pan header doesn't match with our network
         buffer->clear();
+        ctx.getMACTrace().event(MACTraceEvent::DATA_BUFFER_MISS, id);
+    } else {
+        ctx.getMACTrace().event(MACTraceEvent::DATA_BUFFER, id, 0, rcvResult.rssi);
     }
 }
 bool DataPhase::checkStreamId(Packet pkt, StreamId streamId) {
@@ -33,6 +33,8 @@
 #include "../downlink_phase/timesync/networktime.h"
 #include "../stream/stream_manager.h"
 #include "../util/align.h"
+#include "../util/packet.h"
+#include <algorithm>
 
 namespace mxnet {
 /**
@@ -60,10 +62,60 @@ public:
     void advanceBy(unsigned int slots) {
         incrementSlot(slots);
     }
-    static unsigned long long getDuration() {
-        long long processingTime=1500000; //TODO: benchmark
-        return align(MACContext::radioTime(MediumAccessController::maxDataPktSize)+processingTime,1000000LL);
+    /**
+     * \return the duration of a data slot, or of a mini-slot if
+     * NetworkConfiguration::getMiniSlotPayloadSize() is not zero
+     */
+    static unsigned long long getDuration(const NetworkConfiguration& config) {
+        long long processingTime=config.getSlotTimings().getDataProcessing();
+        int pktSize=MediumAccessController::maxDataPktSize;
+        if(config.getMiniSlotPayloadSize() != 0)
+            pktSize=config.getMiniSlotPayloadSize() + dataPacketOverhead;
+        return align(MACContext::radioTime(pktSize)+processingTime,1000000LL);
+    }
+    /**
+     * \return the number of consecutive data slots needed to transmit a
+     * stream packet with the given payload size, always 1 unless mini-slots
+     * are enabled
+     */
+    static unsigned int getSlotsForPayload(const NetworkConfiguration& config,
+                                           unsigned int payloadSize) {
+        if(config.getMiniSlotPayloadSize() == 0) return 1;
+        long long processingTime=config.getSlotTimings().getDataProcessing();
+        long long needed=MACContext::radioTime(payloadSize + dataPacketOverhead)+processingTime;
+        long long slot=getDuration(config);
+        return std::max<long long>(1, (needed + slot - 1) / slot);
+    }
+    /**
+     * \return the number of data slots given to the transmission of the last
+     * data slot, more than one only with mini-slots. The following slots are
+     * sleeps, so the transmission can take all of them
+     */
+    unsigned int getLastSlotCount() const {
+        if(lastPacketSize == 0) return 1;
+        return getSlotsForPayload(ctx.getNetworkConfig(),
+                                  std::max(0, lastPacketSize - dataPacketOverhead));
+    }
+    /**
+     * \return the size of the packet the slots given to the transmission of
+     * the last data slot were sized for. The time taken by the slot minus the
+     * radio time of this packet is the processing time
+     */
+    int getLastSlotPacketSize() const {
+        const auto& config = ctx.getNetworkConfig();
+        if(config.getMiniSlotPayloadSize() == 0)
+            return MediumAccessController::maxDataPktSize;
+        return std::max<int>(lastPacketSize,
+                             config.getMiniSlotPayloadSize() + dataPacketOverhead);
+    }
+    /**
+     * \return the maximum payload of a stream packet
+     */
+    static int getMaxPayloadSize() {
+        return MediumAccessController::maxDataPktSize - dataPacketOverhead;
     }
+    /// Bytes added by the stream to every data packet: panHeader and StreamId
+    static const int dataPacketOverhead = panHeaderSize + sizeof(StreamId);
     /**
      * Reset the internal status of the DataPhase after resynchronization
      * to avoid playback of an old schedule
@@ -153,6 +205,8 @@ private:
     // Reference to Stream class, to get packets from stream buffers
     StreamManager& stream;
     unsigned short slotIndex = 0;
+    /* Size of the packet sent or received in the last data slot, 0 if none */
+    int lastPacketSize = 0;
     unsigned long scheduleID = 0;
     unsigned long scheduleTiles = 0;
     unsigned long scheduleSlots = 0;
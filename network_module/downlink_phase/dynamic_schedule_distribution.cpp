@@ -30,6 +30,7 @@
 #include "../tdmh.h"
 #include "../util/packet.h"
 #include "../util/debug_settings.h"
+#include <algorithm>
 
 using namespace miosix;
 
@@ -46,6 +47,7 @@ void DynamicScheduleDownlinkPhase::execute(long long slotStart)
         {
             if(isScheduleComplete())
             {
+                if(header.isDelta()) mergeDelta();
                 applySchedule(slotStart);
                 if(ENABLE_SCHEDULE_DIST_DBG)
                     print_dbg("[SD] full schedule %s\n",scheduleStatusAsString().c_str());
@@ -144,6 +146,7 @@ void DynamicScheduleDownlinkPhase::advance(long long slotStart)
         {
             if(isScheduleComplete())
             {
+                if(header.isDelta()) mergeDelta();
                 applySchedule(slotStart);
                 if(ENABLE_SCHEDULE_DIST_DBG)
                     print_dbg("[SD] full schedule %s\n",scheduleStatusAsString().c_str());
@@ -165,6 +168,8 @@ void DynamicScheduleDownlinkPhase::desync()
     header = ScheduleHeader();
     schedule.clear();
     received.clear();
+    baseSchedule.clear();
+    removedStreams.clear();
     incompleteScheduleCounter = 0;
     
     status = ScheduleDownlinkStatus::APPLIED_SCHEDULE;
@@ -180,14 +185,19 @@ bool DynamicScheduleDownlinkPhase::recvPkt(long long slotStart, Packet& pkt)
     // Received a valid schedule packet
     if(rcvResult.error == RecvResult::ErrorCode::OK && pkt.checkPanHeader(panId) == true)
     {
+        ctx.getMACTrace().event(MACTraceEvent::SCHEDULE_RECV, StreamId(), 0, rcvResult.rssi);
         // Retransmit the schedule packet unless you belong to maximum hop
         if(ctx.getHop() < ctx.getNetworkConfig().getMaxHops()) {
+            if(ENABLE_SLOT_CALIBRATION)
+                ctx.getSlotCalibration().record(SlotCalibration::DOWNLINK_REBROADCAST,
+                    getTime() - SlotCalibration::receptionEnd(rcvResult.timestamp, pkt.size()));
             ctx.configureTransceiver(ctx.getTransceiverConfig());
             pkt.send(ctx, rcvResult.timestamp + rebroadcastInterval);
             ctx.transceiverIdle();
         }
         return true;
     }
+    ctx.getMACTrace().event(MACTraceEvent::SCHEDULE_MISS);
     return false;
 #elif FLOOD_TYPE == 1
     Packet tempPkt;
@@ -199,6 +209,9 @@ bool DynamicScheduleDownlinkPhase::recvPkt(long long slotStart, Packet& pkt)
     {
         if(send)
         {
+            if(ENABLE_SLOT_CALIBRATION)
+                ctx.getSlotCalibration().record(SlotCalibration::DOWNLINK_REBROADCAST,
+                    getTime() - SlotCalibration::receptionEnd(slotStart - rebroadcastInterval, tempPkt.size()));
             tempPkt.send(ctx, slotStart);
             slotStart += rebroadcastInterval;
             send = false; //Sent: next time, receive
@@ -208,6 +221,9 @@ bool DynamicScheduleDownlinkPhase::recvPkt(long long slotStart, Packet& pkt)
             {
                 slotStart = rcvResult.timestamp + rebroadcastInterval;
                 pkt = tempPkt;
+                if(!receivedAtLeastOnce)
+                    ctx.getMACTrace().event(MACTraceEvent::SCHEDULE_RECV,
+                                            StreamId(), 0, rcvResult.rssi);
                 receivedAtLeastOnce = true;
                 send = true; //Received successfully: next time, send
             } else slotStart += rebroadcastInterval;
@@ -215,6 +231,7 @@ bool DynamicScheduleDownlinkPhase::recvPkt(long long slotStart, Packet& pkt)
         
     }
     ctx.transceiverIdle();
+    if(!receivedAtLeastOnce) ctx.getMACTrace().event(MACTraceEvent::SCHEDULE_MISS);
     return receivedAtLeastOnce;
 #else
 #error
@@ -246,9 +263,26 @@ void DynamicScheduleDownlinkPhase::initSchedule(SchedulePacket& spkt)
     if(ENABLE_SCHEDULE_DIST_DYN_INFO_DBG)
         print_dbg("[SD] Node:%d New schedule received!\n", myId);
 
+    // A delta schedule can only be applied to the schedule it was computed
+    // from, which has to be the one currently applied by this node
+    auto newHeader = spkt.getHeader();
+    baseAvailable = false;
+    baseSchedule.clear();
+    removedStreams.clear();
+    if(newHeader.isDelta())
+    {
+        baseAvailable = status == ScheduleDownlinkStatus::APPLIED_SCHEDULE &&
+                        header.getScheduleID() == newHeader.getBaseScheduleID();
+        if(baseAvailable) baseSchedule = std::move(schedule);
+        else if(ENABLE_SCHEDULE_DIST_DBG)
+            print_dbg("[SD] delta schedule from %lu but have %lu\n",
+                      newHeader.getBaseScheduleID(), header.getScheduleID());
+    }
+
     // Replace old schedule header and elements
-    header = spkt.getHeader();
-    schedule = spkt.getElements();
+    header = newHeader;
+    schedule.clear();
+    addElements(spkt);
     // Resize the received bool vector to the size of the new schedule
     received.clear();
     received.resize(header.getTotalPacket(), 0);
@@ -256,6 +290,27 @@ void DynamicScheduleDownlinkPhase::initSchedule(SchedulePacket& spkt)
     received.at(header.getCurrentPacket()) = 1;
 }
 
+void DynamicScheduleDownlinkPhase::addElements(SchedulePacket& spkt)
+{
+    std::vector<ScheduleElement> elements = spkt.getElements();
+    schedule.insert(schedule.end(), elements.begin(), elements.end());
+    for(auto& e : spkt.getRemovedStreams()) removedStreams.push_back(e.getStreamId());
+}
+
+void DynamicScheduleDownlinkPhase::mergeDelta()
+{
+    auto removed = [this](const ScheduleElement& e) {
+        return std::find(removedStreams.begin(), removedStreams.end(),
+                         e.getStreamId()) != removedStreams.end();
+    };
+    baseSchedule.erase(std::remove_if(baseSchedule.begin(), baseSchedule.end(), removed),
+                       baseSchedule.end());
+    baseSchedule.insert(baseSchedule.end(), schedule.begin(), schedule.end());
+    schedule = std::move(baseSchedule);
+    baseSchedule.clear();
+    removedStreams.clear();
+}
+
 void DynamicScheduleDownlinkPhase::appendToSchedule(SchedulePacket& spkt, bool beginResend)
 {
     applyInfoElements(spkt); //Must be done first as it removes them
@@ -269,6 +324,7 @@ void DynamicScheduleDownlinkPhase::appendToSchedule(SchedulePacket& spkt, bool b
     if(header.getTotalPacket()   != newHeader.getTotalPacket()   ||
        header.getScheduleID()    != newHeader.getScheduleID()    ||
        header.getScheduleTiles() != newHeader.getScheduleTiles() ||
+       header.getBaseScheduleID() != newHeader.getBaseScheduleID() ||
        (beginResend==false && header.getActivationTile() != newHeader.getActivationTile()))
     {
         if(ENABLE_SCHEDULE_DIST_DBG)
@@ -279,10 +335,7 @@ void DynamicScheduleDownlinkPhase::appendToSchedule(SchedulePacket& spkt, bool b
 
     // Add elements from received packet to new schedule only if this is the
     // first time these elements are being received
-    if(received.at(newHeader.getCurrentPacket()) == 0) {
-        std::vector<ScheduleElement> elements = spkt.getElements();
-        schedule.insert(schedule.end(), elements.begin(), elements.end());
-    }
+    if(received.at(newHeader.getCurrentPacket()) == 0) addElements(spkt);
     // Set current packet as received
     received.at(newHeader.getCurrentPacket())++;
 }
@@ -291,6 +344,9 @@ bool DynamicScheduleDownlinkPhase::isScheduleComplete()
 {
     // If no packet was received, the schedule is not complete
     if(received.size() == 0) return false;
+    // Nor if it is a delta from a schedule we don't have, resetAndDisableSchedule()
+    // will then ask for the full schedule with a RESEND_SCHEDULE
+    if(header.isDelta() && baseAvailable == false) return false;
     for(auto pkt : received) if(pkt==0) return false;
     return true;
 }
@@ -303,6 +359,8 @@ void DynamicScheduleDownlinkPhase::resetAndDisableSchedule(long long slotStart)
     header = ScheduleHeader();
     schedule.clear();
     received.clear();
+    baseSchedule.clear();
+    removedStreams.clear();
     incompleteScheduleCounter = 0;
 
     auto currentTile = ctx.getCurrentTile(slotStart);
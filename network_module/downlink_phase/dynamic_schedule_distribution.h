@@ -54,6 +54,17 @@ private:
     void initSchedule(SchedulePacket& spkt);
     
     void appendToSchedule(SchedulePacket& spkt, bool beginResend = false);
+
+    /**
+     * Add the elements of a received packet to the schedule, and the
+     * streams it removes if it is part of a delta schedule
+     */
+    void addElements(SchedulePacket& spkt);
+
+    /**
+     * Build the complete schedule from a delta and the schedule it is from
+     */
+    void mergeDelta();
     
     bool isScheduleComplete();
     
@@ -72,6 +83,12 @@ private:
     std::vector<unsigned char> received;
     
     int incompleteScheduleCounter = 0;
+
+    // When receiving a delta schedule, the schedule it is from
+    std::vector<ScheduleElement> baseSchedule;
+    bool baseAvailable = false;
+    // Streams removed by the delta schedule being received
+    std::vector<StreamId> removedStreams;
 };
 
 }
@@ -27,11 +27,14 @@
 
 #include "master_schedule_distribution.h"
 #include "../scheduler/schedule_computation.h"
+#include "../scheduler/schedule_capture.h"
 #include "../tdmh.h"
 #include "../util/packet.h"
 #include "../util/debug_settings.h"
 #include "../util/align.h"
 #include "timesync/networktime.h"
+#include <cstring>
+#include <map>
 
 using namespace miosix;
 
@@ -66,7 +69,6 @@ void MasterScheduleDownlinkPhase::execute(long long slotStart)
                 header.incrementPacketCounter();
                 if(header.getCurrentPacket() >= header.getTotalPacket())
                 {
-                    position = 0;
                     header.resetPacketCounter();
                     header.incrementRepetition();
                 }
@@ -76,6 +78,8 @@ void MasterScheduleDownlinkPhase::execute(long long slotStart)
                 {
                     applySchedule(slotStart);
                     schedule_comp.scheduleSentAndApplied();
+                    ScheduleCapture::scheduleApplied(currentTile);
+                    delta.clear();
                     status = ScheduleDownlinkStatus::APPLIED_SCHEDULE;
                     //No packet sent in this downlink slot
                 } else {
@@ -92,6 +96,8 @@ void MasterScheduleDownlinkPhase::execute(long long slotStart)
             {
                 applySchedule(slotStart);
                 schedule_comp.scheduleSentAndApplied();
+                ScheduleCapture::scheduleApplied(currentTile);
+                delta.clear();
                 status = ScheduleDownlinkStatus::APPLIED_SCHEDULE;
                 //No packet sent in this downlink slot
             } else {
@@ -108,10 +114,30 @@ void MasterScheduleDownlinkPhase::getScheduleAndComputeActivation(long long slot
 {
     unsigned long id;
     unsigned int tiles;
-    schedule_comp.getSchedule(schedule,id,tiles);
+    std::vector<ScheduleElement> newSchedule;
+    schedule_comp.getSchedule(newSchedule,id,tiles);
+    updateScheduleRepetitions();
     unsigned int currentTile = ctx.getCurrentTile(slotStart);
+
+    // Send only the differences from the last schedule if they are smaller,
+    // but not when resending the same schedule since some node asked for it
+    unsigned long baseScheduleID = 0;
+    unsigned int removedStreams = 0;
+    if(header.getScheduleID() != 0 && id != header.getScheduleID())
+    {
+        removedStreams = computeDelta(newSchedule);
+        if(delta.size() < newSchedule.size()) baseScheduleID = header.getScheduleID();
+    }
+    if(baseScheduleID == 0)
+    {
+        delta.clear();
+        removedStreams = 0;
+    }
+    schedule = std::move(newSchedule);
+
     //NOTE: An empty schedule still requires 1 packet to send the scheduleHeader
-    unsigned int numPackets = std::max<unsigned int>(1,(schedule.size()+packetCapacity-1) / packetCapacity);
+    unsigned int numPackets = paginate(baseScheduleID != 0 ? delta : schedule,
+                                       baseScheduleID, removedStreams);
     
     // Get the earliest tile when we can activate the schedule, not considering
     // that it must be aligned to the end of the previous schedule, if there is one
@@ -160,22 +186,91 @@ void MasterScheduleDownlinkPhase::getScheduleAndComputeActivation(long long slot
         0,                  // currentPacket
         id,                 // scheduleID
         activationTile,     // activationTile
-        tiles);             // scheduleTiles
+        tiles,              // scheduleTiles
+        0,                  // repetition
+        baseScheduleID,     // baseScheduleID
+        removedStreams,     // removedStreams
+        compactScheduleEncoding); // compact
     
     if(ENABLE_SCHEDULE_DIST_MAS_INFO_DBG)
     {
         // Print schedule packet report
         print_dbg("[SD] Schedule Packet structure:\n");
-        print_dbg("[SD] %d packet capacity\n", packetCapacity);
+        print_dbg("[SD] %d packets\n", numPackets);
         print_dbg("[SD] %d schedule element\n", schedule.size());
+        if(baseScheduleID != 0)
+            print_dbg("[SD] delta from %lu: %u streams removed, %u elements added\n",
+                      baseScheduleID, removedStreams, delta.size() - removedStreams);
     }
-
-    position = 0;
     
     if(ENABLE_SCHEDULE_DIST_MAS_INFO_DBG)        
         printCompleteSchedule();
 }
 
+/**
+ * \return true if two lists of elements of a stream are the same
+ */
+static bool sameStreamElements(const std::vector<ScheduleElement>& a,
+                               const std::vector<ScheduleElement>& b)
+{
+    if(a.size() != b.size()) return false;
+    for(unsigned int i = 0; i < a.size(); i++)
+    {
+        StreamParameters pa = a[i].getParams(), pb = b[i].getParams();
+        if(a[i].getKey()    != b[i].getKey() ||
+           a[i].getTx()     != b[i].getTx()  ||
+           a[i].getRx()     != b[i].getRx()  ||
+           a[i].getOffset() != b[i].getOffset() ||
+           memcmp(&pa, &pb, sizeof(StreamParameters)) != 0) return false;
+    }
+    return true;
+}
+
+unsigned int MasterScheduleDownlinkPhase::computeDelta(const std::vector<ScheduleElement>& newSchedule)
+{
+    // Group the elements of both schedules by stream, keeping their order
+    std::map<unsigned int, std::vector<ScheduleElement>> oldStreams, newStreams;
+    for(auto& e : schedule) oldStreams[e.getKey()].push_back(e);
+    for(auto& e : newSchedule) newStreams[e.getKey()].push_back(e);
+
+    // A stream whose elements changed is removed and added back as a whole,
+    // as the nodes need its hops in order to allocate forwarding buffers
+    delta.clear();
+    for(auto& s : oldStreams)
+    {
+        auto it = newStreams.find(s.first);
+        if(it == newStreams.end() || !sameStreamElements(s.second, it->second))
+            delta.push_back(s.second.front());
+    }
+    unsigned int removedStreams = delta.size();
+    for(auto& s : newStreams)
+    {
+        auto it = oldStreams.find(s.first);
+        if(it == oldStreams.end() || !sameStreamElements(it->second, s.second))
+            delta.insert(delta.end(), s.second.begin(), s.second.end());
+    }
+    return removedStreams;
+}
+
+void MasterScheduleDownlinkPhase::updateScheduleRepetitions()
+{
+    // The requests come from nodes that missed part of a previous schedule,
+    // or got a delta from a schedule they didn't have
+    unsigned int requests = streamColl->takeResendRequests();
+    unsigned char old = scheduleRepetitions;
+    if(requests > 0)
+    {
+        schedulesWithoutResend = 0;
+        if(scheduleRepetitions < maxScheduleRepetitions) scheduleRepetitions++;
+    } else if(++schedulesWithoutResend >= schedulesBeforeDecrease) {
+        schedulesWithoutResend = 0;
+        if(scheduleRepetitions > minScheduleRepetitions) scheduleRepetitions--;
+    }
+    if(ENABLE_SCHEDULE_DIST_DBG && old != scheduleRepetitions)
+        print_dbg("[SD] schedule repetitions %d->%d, %u resend requests\n",
+                  old, scheduleRepetitions, requests);
+}
+
 unsigned int MasterScheduleDownlinkPhase::getActivationTile(unsigned int currentTile,
                                                             unsigned int numPackets)
 {
@@ -268,6 +363,45 @@ unsigned int MasterScheduleDownlinkPhase::getActivationTile(unsigned int current
     return activationTile;
 }
 
+unsigned int MasterScheduleDownlinkPhase::paginate(const std::vector<ScheduleElement>& elements,
+                                                   unsigned long baseScheduleID,
+                                                   unsigned int removedStreams)
+{
+    packetStart.clear();
+    unsigned int i = 0;
+    do {
+        packetStart.push_back(i);
+        if(compactScheduleEncoding == false)
+        {
+            i += SchedulePacket::getPacketCapacity(baseScheduleID != 0);
+            continue;
+        }
+        // Fill the packet, but move a stream that doesn't fit to the next
+        // one instead of splitting it, unless it is too long for any packet
+        SchedulePacket spkt(panId);
+        ScheduleHeader compactHeader(1,0,0,0,0,0,baseScheduleID,removedStreams,true);
+        spkt.setHeader(compactHeader);
+        const unsigned int first = i;
+        unsigned int streamStart = i;
+        for(; i < elements.size(); i++)
+        {
+            ScheduleElement e = elements[i];
+            bool removal = i < removedStreams;
+            if(removal) spkt.putRemovedStream(e);
+            else {
+                spkt.putElement(e);
+                if(i == removedStreams || elements[i - 1].getKey() != e.getKey())
+                    streamStart = i;
+            }
+            if(spkt.size() <= MediumAccessController::maxControlPktSize) continue;
+            if(removal == false && streamStart > first) i = streamStart;
+            break;
+        }
+        assert(i > first);
+    } while(i < elements.size());
+    return packetStart.size();
+}
+
 void MasterScheduleDownlinkPhase::sendSchedulePkt(long long slotStart)
 {
     if(ENABLE_SCHEDULE_DIST_MAS_INFO_DBG) printHeader(header);
@@ -277,15 +411,16 @@ void MasterScheduleDownlinkPhase::sendSchedulePkt(long long slotStart)
     spkt.setHeader(header);
 
     // Add schedule elements to SchedulePacket
-    unsigned int sched = 0;
-    for(sched = 0; (sched < packetCapacity) && (position < schedule.size()); sched++)
+    auto& elements = header.isDelta() ? delta : schedule;
+    unsigned int current = header.getCurrentPacket();
+    unsigned int end = current + 1 < packetStart.size() ? packetStart[current + 1] : elements.size();
+    for(unsigned int i = packetStart[current]; i < end; i++)
     {
-        spkt.putElement(schedule[position]);
-        position++;
+        if(i < header.getRemovedStreams()) spkt.putRemovedStream(elements[i]);
+        else spkt.putElement(elements[i]);
     }
     // Add info elements to SchedulePacket
-    unsigned char numInfo = packetCapacity - sched;
-    auto infos = streamColl->dequeueInfo(numInfo);
+    auto infos = streamColl->dequeueInfo(spkt.getInfoCapacity());
     for(auto& info : infos) spkt.putInfoElement(info);
 
     Packet pkt;
@@ -300,11 +435,11 @@ void MasterScheduleDownlinkPhase::sendInfoPkt(long long slotStart)
 {
     SchedulePacket spkt(panId);
     // Build Info packet header
-    ScheduleHeader infoHeader(0,0,header.getScheduleID());
+    ScheduleHeader infoHeader(0,0,header.getScheduleID(),0,0,0,0,0,compactScheduleEncoding);
     spkt.setHeader(infoHeader);
 
     // Add info elements to SchedulePacketacket
-    auto infos = streamColl->dequeueInfo(packetCapacity);
+    auto infos = streamColl->dequeueInfo(spkt.getInfoCapacity());
     for(auto& info : infos) spkt.putInfoElement(info);
 
     Packet pkt;
@@ -317,6 +452,7 @@ void MasterScheduleDownlinkPhase::sendInfoPkt(long long slotStart)
 
 void MasterScheduleDownlinkPhase::sendPkt(long long slotStart, Packet& pkt)
 {
+    ctx.getMACTrace().event(MACTraceEvent::SCHEDULE_SEND);
 #if FLOOD_TYPE == 0
     ctx.configureTransceiver(ctx.getTransceiverConfig());
     pkt.send(ctx, slotStart);
@@ -51,8 +51,33 @@ public:
 private:
     
     void getScheduleAndComputeActivation(long long slotStart);
+
+    /**
+     * Adapt the number of times each schedule is sent to the nodes that
+     * asked to resend a schedule since the last call. Any request adds a
+     * repetition, and each run of schedules with no requests removes one
+     */
+    void updateScheduleRepetitions();
+
+    /**
+     * Compute the differences between the last schedule and a new one into
+     * delta, at the granularity of streams
+     * \param newSchedule the new schedule
+     * \return the number of streams removed, that are at the beginning of delta
+     */
+    unsigned int computeDelta(const std::vector<ScheduleElement>& newSchedule);
     
     unsigned int getActivationTile(unsigned int currentTile, unsigned int numPackets);
+
+    /**
+     * Split the elements to send in packets, filling packetStart
+     * \param elements the schedule or the delta
+     * \param baseScheduleID the schedule the delta is from, 0 if not a delta
+     * \param removedStreams number of removed streams at the beginning of a delta
+     * \return the number of packets
+     */
+    unsigned int paginate(const std::vector<ScheduleElement>& elements,
+                          unsigned long baseScheduleID, unsigned int removedStreams);
     
     void sendSchedulePkt(long long slotstart);
     
@@ -62,9 +87,20 @@ private:
     
     void printHeader(ScheduleHeader& header);
     
-    // Last schedule element sent
-    unsigned position = 0;
-    const unsigned packetCapacity = SchedulePacket::getPacketCapacity();
+    // Index of the first element of each packet of the schedule being sent
+    std::vector<unsigned int> packetStart;
+    // Elements of the delta schedule being sent, if the header is a delta
+    std::vector<ScheduleElement> delta;
+    // Send the schedule with the compact encoding, the nodes decode both
+    static const bool compactScheduleEncoding = true;
+
+    static const unsigned char minScheduleRepetitions = 1;
+    static const unsigned char maxScheduleRepetitions = 8;
+    // Schedules sent without resend requests before removing a repetition
+    static const unsigned char schedulesBeforeDecrease = 4;
+    // Times each schedule is sent, set the activation tile
+    unsigned char scheduleRepetitions = 4;
+    unsigned char schedulesWithoutResend = 0;
 
     // Reference to ScheduleComputation class to get current schedule
     ScheduleComputation& schedule_comp;
@@ -29,6 +29,7 @@
 #include "timesync/networktime.h"
 #include "../data_phase/dataphase.h"
 #include "../tdmh.h"
+#include "../util/event_log.h"
 
 using namespace miosix;
 
@@ -133,6 +134,8 @@ void ScheduleDownlinkPhase::applySchedule(long long slotStart)
         printExplicitSchedule(myID, true, explicitSchedule);
     }
     
+    EventLog::record(EventType::SCHEDULE, NetworkTime::fromLocalTime(slotStart).get(), schId);
+
     // Apply schedule to DataPhase
     dataPhase->applySchedule(std::move(explicitSchedule),
                              std::move(forwardedStreamCtr), 
@@ -140,7 +143,7 @@ void ScheduleDownlinkPhase::applySchedule(long long slotStart)
                              header.getActivationTile(), currentTile);
     
     // Apply schedule to StreamManager
-    streamMgr->applySchedule(schedule);
+    streamMgr->applySchedule(schedule, ctx.getSlotsInTileCount());
     
     //NOTE: after we apply the schedule, we need to leave the time for connect() to return
     //in applications, and for them to call write(), otherwise the first transmission
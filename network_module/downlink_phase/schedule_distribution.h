@@ -32,7 +32,17 @@
 #include "../scheduler/schedule_element.h"
 #include "../util/debug_settings.h"
 
+/*
+ * Flooding strategy of the schedule downlink packets:
+ * 0: every node receives at the sub-slot given by its hop and rebroadcasts once
+ * 1: nodes alternate receiving and rebroadcasting for the whole slot
+ * A Glossy-style flood does not shorten the slot with this radio driver: the
+ * rebroadcast goes through Transceiver::sendAt() with the sender wakeup
+ * advance as in 0, where nodes at the same hop already transmit concurrently
+ */
+#ifndef FLOOD_TYPE
 #define FLOOD_TYPE 1
+#endif
 
 /**
  * Represents the phase in which the schedule is distributed to the entire network,
@@ -62,6 +72,18 @@ public:
      */
     void resync() override {}
 
+    /**
+     * \param activationTile set to the activation tile of the schedule being
+     * distributed, if any
+     * \return true if a schedule is being distributed and not yet applied
+     */
+    bool getPendingActivationTile(unsigned int& activationTile) const {
+        if(status != ScheduleDownlinkStatus::SENDING_SCHEDULE &&
+           status != ScheduleDownlinkStatus::AWAITING_ACTIVATION) return false;
+        activationTile = header.getActivationTile();
+        return true;
+    }
+
 
 protected:
     ScheduleDownlinkPhase(MACContext& ctx) : MACPhase(ctx),
@@ -108,7 +130,7 @@ protected:
 
     static int computeRebroadcastInterval(const NetworkConfiguration& cfg)
     {
-        const int computationTime=244000;
+        const int computationTime=cfg.getSlotTimings().getDownlinkRebroadcastProcessing();
         const int txTime=(MediumAccessController::maxControlPktSize+8)*32000;
 #if FLOOD_TYPE==0
         return txTime+computationTime+MediumAccessController::sendingNodeWakeupAdvance;
@@ -128,7 +150,6 @@ protected:
     };
     
     const int rebroadcastInterval;
-    static const int scheduleRepetitions = 4;
     
     ScheduleDownlinkStatus status = ScheduleDownlinkStatus::APPLIED_SCHEDULE;
 
@@ -30,6 +30,7 @@
 #include "../../uplink_phase/dynamic_uplink_phase.h"
 #include "../../data_phase/dataphase.h"
 #include "../../util/debug_settings.h"
+#include "../../util/event_log.h"
 #include <cassert>
 
 using namespace miosix;
@@ -47,7 +48,10 @@ void DynamicTimesyncDownlink::periodicSync() {
     if(rcvResult.error != RecvResult::ErrorCode::OK) {
         // Turn off the radio because we don't need it anymore this round
         ctx.transceiverIdle();
+        if(networkConfig.getUplinkDiscoveryInterval() != 0)
+            ctx.getUplink()->liveNodesUnknown();
         auto n = missedPacket();
+        ctx.getMACTrace().event(MACTraceEvent::TIMESYNC_MISS);
         if (ENABLE_TIMESYNC_DL_INFO_DBG) {
             auto nt = NetworkTime::fromLocalTime(getSlotframeStart());
             print_dbg("[T] miss NT=%lld u=%d w=%d\n", nt.get(), clockCorrection, receiverWindow);
@@ -63,18 +67,28 @@ void DynamicTimesyncDownlink::periodicSync() {
         rebroadcast(pkt, measuredFrameStart);
         ctx.transceiverIdle();
         // TODO: make a struct containing the packetCounter
-        packetCounter++;
+        unsigned int elapsedInterval = syncInterval;
+        advanceSyncCounter();
         auto newPacketCounter = *reinterpret_cast<unsigned int*>(&pkt[7]);
         if(newPacketCounter != packetCounter)
             print_dbg("[T] Received wrong packetCounter=%d (should be %d)", newPacketCounter, packetCounter);
+        if(networkConfig.getAdaptiveClockSync())
+            readSyncIntervals(pkt);
+        if(networkConfig.getUplinkDiscoveryInterval() != 0)
+            ctx.getUplink()->setLiveNodes(&pkt[getLiveNodesOffset(networkConfig)]);
 
         error = rcvResult.timestamp - computedFrameStart;
-        std::pair<int,int> clockCorrectionReceiverWindow = synchronizer->computeCorrection(error);
+        std::pair<int,int> clockCorrectionReceiverWindow =
+            synchronizer->computeCorrection(toMinSyncPeriod(error, elapsedInterval));
         missedPackets = 0;
-        clockCorrection = clockCorrectionReceiverWindow.first;
-        receiverWindow = clockCorrectionReceiverWindow.second;
+        clockCorrection = fromMinSyncPeriod(clockCorrectionReceiverWindow.first, syncInterval);
+        receiverWindow = fromMinSyncPeriod(clockCorrectionReceiverWindow.second, syncInterval);
         internalStatus = IN_SYNC;
         updateVt();
+        ctx.getMACTrace().event(MACTraceEvent::TIMESYNC_RECV, StreamId(), 0,
+                                rcvResult.rssi, error);
+        EventLog::record(EventType::TIMESYNC,
+                         NetworkTime::fromLocalTime(getSlotframeStart()).get(), 0, error);
         if (ENABLE_TIMESYNC_DL_INFO_DBG) {            
             auto nt = NetworkTime::fromLocalTime(getSlotframeStart());
             print_dbg("[T] hop=%u NT=%lld ets=%lld ats=%lld e=%lld u=%d w=%d rssi=%d\n",
@@ -130,10 +144,13 @@ void DynamicTimesyncDownlink::resyncTime() {
     resyncMAC();
 
     packetCounter = *reinterpret_cast<unsigned int*>(&pkt[7]);
-    NetworkTime::setLocalNodeToNetworkTimeOffset(packetCounter *
-                                                 networkConfig.getClockSyncPeriod() - slotframeStart);
+    if(networkConfig.getAdaptiveClockSync())
+        readSyncIntervals(pkt);
+    NetworkTime::setLocalNodeToNetworkTimeOffset(getSyncNetworkTime() - slotframeStart);
     auto ntNow = NetworkTime::fromLocalTime(slotframeStart);
     ctx.getUplink()->alignToNetworkTime(ntNow);
+    if(networkConfig.getUplinkDiscoveryInterval() != 0)
+        ctx.getUplink()->setLiveNodes(&pkt[getLiveNodesOffset(networkConfig)]);
 
     if (ENABLE_TIMESYNC_DL_INFO_DBG)      
         print_dbg("[T] hop=%d NT=%lld ats=%lld w=%d rssi=%d\n",
@@ -176,14 +193,29 @@ void DynamicTimesyncDownlink::reset(long long hookPktTime) {
     internalStatus = SYNCING;
 }
 
+void DynamicTimesyncDownlink::advanceSyncCounter() {
+    if(networkConfig.getAdaptiveClockSync() == false) {
+        packetCounter++;
+        return;
+    }
+    // The counter is in control superframes
+    packetCounter += syncInterval;
+    syncInterval = nextSyncInterval;
+}
+
+void DynamicTimesyncDownlink::readSyncIntervals(const Packet& pkt) {
+    syncInterval = pkt[syncPacketHeaderSize];
+    nextSyncInterval = pkt[syncPacketHeaderSize + 1];
+}
+
 void DynamicTimesyncDownlink::next() {
     //This an uncorrected clock! Good for Rtc, that doesn't correct by itself
     //needed because we ALWAYS need to consider the reference to be the first hook time,
     //otherwise we would build a second integrator without actually managing it.
-    theoreticalFrameStart += networkConfig.getClockSyncPeriod();
+    theoreticalFrameStart += getSyncPeriod();
     //This is the estimate of the next packet in our clock
     //using the FLOPSYNC-2 clock correction
-    computedFrameStart += networkConfig.getClockSyncPeriod() + clockCorrection;
+    computedFrameStart += getSyncPeriod() + clockCorrection;
 }
 
 long long DynamicTimesyncDownlink::correct(long long int uncorrected) {
@@ -194,8 +226,10 @@ long long DynamicTimesyncDownlink::correct(long long int uncorrected) {
 
 unsigned char DynamicTimesyncDownlink::missedPacket() {
     // We have not received the sync packet but we need to increment it
-    // to keep the NetworkTime up to date
-    packetCounter++;
+    // to keep the NetworkTime up to date. With the adaptive clock sync period
+    // the next interval was announced in the previous packet, if more than
+    // one packet in a row is missed it is assumed not to change
+    advanceSyncCounter();
     // NOTE: It is important that measuredFrameStart is a CORRECTED
     // time, because it is used as is in the NetworkTime
     measuredFrameStart = correct(computedFrameStart);
@@ -224,8 +258,8 @@ unsigned char DynamicTimesyncDownlink::missedPacket() {
         clockCorrection = 0;
     } else {
         std::pair<int,int> clockCorrectionReceiverWindow = synchronizer->lostPacket();
-        clockCorrection = clockCorrectionReceiverWindow.first;
-        receiverWindow = clockCorrectionReceiverWindow.second;
+        clockCorrection = fromMinSyncPeriod(clockCorrectionReceiverWindow.first, syncInterval);
+        receiverWindow = fromMinSyncPeriod(clockCorrectionReceiverWindow.second, syncInterval);
     }
     updateVt();
     return missedPackets;
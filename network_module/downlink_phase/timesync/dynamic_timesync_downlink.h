@@ -77,6 +77,13 @@ protected:
             && packet[3] == static_cast<unsigned char>(panId >> 8)
             && packet[4] == static_cast<unsigned char>(panId & 0xff)
             && packet[5] == 0xff && packet[6] == 0xff) == false) return false;
+        if(networkConfig.getAdaptiveClockSync()) {
+            const unsigned int minInterval = networkConfig.getNumSuperframesPerClockSync();
+            const unsigned int maxInterval = networkConfig.getMaxNumSuperframesPerClockSync();
+            for(unsigned int i = 0; i < syncIntervalsSize; i++)
+                if(packet[syncPacketHeaderSize + i] < minInterval ||
+                   packet[syncPacketHeaderSize + i] > maxInterval) return false;
+        }
         if(synchronized) {
             // If synchronized, the hop can't change
             if(ctx.getHop() != packet[2] + 1) return false;
@@ -110,6 +117,33 @@ protected:
      * Resets the data calculated by and useful for the controller
      */
     void reset(long long hookPktTime);
+
+    /**
+     * Called at every timesync, received or missed, advances the packet
+     * counter and moves to the sync interval announced for the next timesync.
+     * If the timesync is received, the intervals are then overwritten with
+     * the ones in the packet by readSyncIntervals()
+     */
+    void advanceSyncCounter();
+
+    /**
+     * Read the sync intervals announced in a timesync packet
+     */
+    void readSyncIntervals(const Packet& pkt);
+
+    /**
+     * With the adaptive clock sync period the FLOPSYNC-2 controller works as
+     * if the sync period was always the minimum one, so errors are scaled
+     * down to it and corrections and windows are scaled up to the next sync
+     * interval. Identities if the adaptive clock sync period is disabled.
+     */
+    int toMinSyncPeriod(long long value, unsigned int interval) const {
+        return value * networkConfig.getNumSuperframesPerClockSync() / interval;
+    }
+    int fromMinSyncPeriod(long long value, unsigned int interval) const {
+        return value * interval / networkConfig.getNumSuperframesPerClockSync();
+    }
+
     void next() override;
     long long correct(long long int uncorrected) override;
 
@@ -122,6 +156,9 @@ protected:
      * Updates the VirtualClock data to perform corrections based on the freshly calculated FLOPSYNC-2 data
      */
     void updateVt() {
+        // The correction is spread over the next sync period, which may change
+        if(networkConfig.getAdaptiveClockSync())
+            vt.setSyncPeriod(getSyncPeriod());
         vt.update(
                 tc->ns2tick(theoreticalFrameStart),
                 tc->ns2tick(computedFrameStart), clockCorrection
@@ -29,6 +29,11 @@
 #include "networktime.h"
 #include "../../util/debug_settings.h"
 #include "../../mac_context.h"
+#include "../../uplink_phase/uplink_phase.h"
+#include "../schedule_distribution.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
 
 using namespace miosix;
 
@@ -47,15 +52,38 @@ MasterTimesyncDownlink::MasterTimesyncDownlink(MACContext& ctx) : TimesyncDownli
             0,0,0,0                                   //32bit timesync packet counter for absolute network time
     };
     packet.put(&timesyncPkt, sizeof(timesyncPkt));
+    // Room for the sync intervals, filled in at every execute()
+    if(networkConfig.getAdaptiveClockSync())
+    {
+        unsigned char intervals[syncIntervalsSize] = {static_cast<unsigned char>(syncInterval),
+                                                      static_cast<unsigned char>(nextSyncInterval)};
+        packet.put(intervals, sizeof(intervals));
+    }
+    // Room for the live nodes, filled in at every execute()
+    if(networkConfig.getUplinkDiscoveryInterval() != 0)
+    {
+        std::vector<unsigned char> liveNodes(networkConfig.getLiveNodesSize(), 0);
+        packet.put(liveNodes.data(), liveNodes.size());
+    }
 }
 
 void MasterTimesyncDownlink::execute(long long slotStart)
 {
     next();
+    if(networkConfig.getUplinkDiscoveryInterval() != 0)
+    {
+        // Advertise the nodes present in the network, the uplink round-robin
+        // of all nodes (including ours) switches to it from now on
+        auto uplink = ctx.getUplink();
+        uplink->updateLiveNodes();
+        memcpy(&packet[getLiveNodesOffset(networkConfig)], uplink->getLiveNodes().data(),
+               networkConfig.getLiveNodesSize());
+    }
     ctx.configureTransceiver(ctx.getTransceiverConfig());
     //Sending synchronization start packet
     packet.send(ctx, slotframeTime);
     ctx.transceiverIdle();
+    ctx.getMACTrace().event(MACTraceEvent::TIMESYNC_SEND);
     if (ENABLE_TIMESYNC_DL_INFO_DBG) {
         auto nt = NetworkTime::fromLocalTime(slotStart);
         print_dbg("[T] ST=%lld NT=%lld\n", slotframeTime, nt.get());
@@ -74,13 +102,55 @@ void MasterTimesyncDownlink::macStartHook()
     NetworkTime::setLocalNodeToNetworkTimeOffset(-slotframeTime);
     
     // Initialize considering the next() in execute
-    slotframeTime -= networkConfig.getClockSyncPeriod();
-    setTimesyncPacketCounter(-1);
+    slotframeTime -= getSyncPeriod();
+    if(networkConfig.getAdaptiveClockSync())
+        setTimesyncPacketCounter(-syncInterval);
+    else
+        setTimesyncPacketCounter(-1);
 }
 
 void MasterTimesyncDownlink::next() {
-    slotframeTime += networkConfig.getClockSyncPeriod();
-    incrementTimesyncPacketCounter();
+    slotframeTime += getSyncPeriod();
+    if(networkConfig.getAdaptiveClockSync() == false)
+    {
+        incrementTimesyncPacketCounter();
+        return;
+    }
+    // The counter is in control superframes, and the interval to the next
+    // timesync has already been announced in the previous timesync packet
+    setTimesyncPacketCounter(packetCounter + syncInterval);
+    syncInterval = nextSyncInterval;
+    nextSyncInterval = chooseSyncInterval();
+    packet[syncPacketHeaderSize] = syncInterval;
+    packet[syncPacketHeaderSize + 1] = nextSyncInterval;
+    if(ENABLE_TIMESYNC_DL_INFO_DBG)
+        print_dbg("[T] sync interval=%u next=%u\n", syncInterval, nextSyncInterval);
+}
+
+unsigned int MasterTimesyncDownlink::chooseSyncInterval() {
+    const unsigned int minInterval = networkConfig.getNumSuperframesPerClockSync();
+    const unsigned int maxInterval = networkConfig.getMaxNumSuperframesPerClockSync();
+    const unsigned int maxWindow = networkConfig.getMaxAdmittedRcvWindow() / 1000;
+    // Worst receiver window in microseconds predicted by the nodes for the
+    // sync interval they were in, 0 if no node reported since the last call
+    unsigned int window = ctx.getUplink()->takeSyncWindowReport();
+    unsigned int interval = nextSyncInterval;
+    if(window > maxWindow / 2)
+        interval = std::max(minInterval, interval / 2);
+    else if(window != 0 && window <= maxWindow / 4)
+        interval = std::min(maxInterval, interval + 1);
+    // The schedule being distributed was given an activation tile that is
+    // not a timesync assuming the minimum interval after the announced ones,
+    // move the timesync that would fall on it
+    unsigned int activationTile;
+    if(ctx.getScheduleDistribution()->getPendingActivationTile(activationTile))
+    {
+        const unsigned int csSize = networkConfig.getControlSuperframeStructure().size();
+        unsigned int tile = (packetCounter + syncInterval + interval) * csSize;
+        if(tile == activationTile)
+            interval = interval < maxInterval ? interval + 1 : interval - 1;
+    }
+    return interval;
 }
 
 long long MasterTimesyncDownlink::correct(long long int uncorrected) {
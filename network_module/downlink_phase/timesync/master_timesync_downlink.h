@@ -82,6 +82,14 @@ protected:
     void next() override;
     long long correct(long long int uncorrected) override;
 private:
+    /**
+     * Choose the interval between the next timesync and the one after,
+     * lengthening it while the sync windows reported by the nodes are small
+     * and halving it when they are large
+     * \return the interval in control superframes
+     */
+    unsigned int chooseSyncInterval();
+
     long long slotframeTime;
     static const long long initializationDelay = 1000000;
     Packet packet;
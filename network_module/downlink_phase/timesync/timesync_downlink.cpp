@@ -44,6 +44,21 @@ std::pair<long long, long long> TimesyncDownlink::getWakeupAndTimeout(long long
     );
 }
 
+unsigned int TimesyncDownlink::getNumTimesyncs(unsigned int tile) const {
+    const unsigned int csSize = networkConfig.getControlSuperframeStructure().size();
+    const unsigned int last = packetCounter * csSize;
+    if(tile <= last) return 0;
+    unsigned int result = 1;
+    const unsigned int next = last + syncInterval * csSize;
+    if(tile <= next) return result;
+    result++;
+    const unsigned int afterNext = next + nextSyncInterval * csSize;
+    if(tile <= afterNext) return result;
+    result++;
+    const unsigned int minPeriod = networkConfig.getNumSuperframesPerClockSync() * csSize;
+    return result + (tile - afterNext - 1) / minPeriod;
+}
+
 void TimesyncDownlink::advance(long long slotStart)
 {
     throw std::logic_error("TimesyncDownlink can't advance");
@@ -44,12 +44,36 @@ public:
     TimesyncDownlink() = delete;
     TimesyncDownlink(const TimesyncDownlink& orig) = delete;
 
-    static unsigned long long getDuration(unsigned short hops) {
-        return phaseStartupTime + hops * rebroadcastInterval;
+    static unsigned long long getDuration(const NetworkConfiguration& config) {
+        return phaseStartupTime + config.getMaxHops() * getRebroadcastInterval(config);
     }
+
+    /**
+     * \return the size of the timesync packet, which also carries the sync
+     * intervals if the adaptive clock sync period is enabled, and the live
+     * nodes if the adaptive uplink round-robin is enabled
+     */
+    static unsigned int getSyncPacketSize(const NetworkConfiguration& config) {
+        return getLiveNodesOffset(config) + config.getLiveNodesSize();
+    }
+
+    /**
+     * \return the offset of the live nodes in the timesync packet
+     */
+    static unsigned int getLiveNodesOffset(const NetworkConfiguration& config) {
+        if(config.getAdaptiveClockSync()) return syncPacketHeaderSize + syncIntervalsSize;
+        return syncPacketHeaderSize;
+    }
+
+    static int getRebroadcastInterval(const NetworkConfiguration& config) {
+        return (getSyncPacketSize(config)+8)*32000 + 536000; //32us per-byte + 536us total delta
+    }
+
     static const int phaseStartupTime = 450000;
-    static const unsigned int syncPacketSize = 11;
-    static const int rebroadcastInterval = (syncPacketSize+8)*32000 + 536000; //32us per-byte + 536us total delta
+    static const unsigned int syncPacketHeaderSize = 11;
+    /// With the adaptive clock sync period, the timesync packet announces
+    /// the next two sync intervals, one byte each, after the header
+    static const unsigned int syncIntervalsSize = 2;
 
     /**
      * @return the status of the synchronization state machine
@@ -95,10 +119,32 @@ public:
     
     /**
      * \return the timesync packet counter used for slave nodes to know the
-     * absolute network time
+     * absolute network time. With the adaptive clock sync period it counts
+     * the control superframes up to the last timesync instead
      */
     unsigned int getTimesyncPacketCounter() const { return packetCounter; }
 
+    /**
+     * \return the number of control superframes from the last timesync to
+     * the next one
+     */
+    unsigned int getSyncInterval() const { return syncInterval; }
+
+    /**
+     * \return the time from the last timesync to the next one
+     */
+    unsigned long long getSyncPeriod() const {
+        return syncInterval * networkConfig.getControlSuperframeDuration();
+    }
+
+    /**
+     * \return the number of timesyncs before tile. Only meaningful with the
+     * adaptive clock sync period and for tiles after the last timesync: the
+     * two announced timesyncs are known, the following ones are assumed to
+     * be at the minimum clock sync period, so the result is an upper bound
+     */
+    unsigned int getNumTimesyncs(unsigned int tile) const;
+
     bool macCanOperate() {
         return internalStatus == IN_SYNC && llabs(error) < networkConfig.getMaxAdmittedRcvWindow()/2;
     }
@@ -111,24 +157,48 @@ protected:
     TimesyncDownlink(MACContext& ctx, MacroStatus initStatus, unsigned receivingWindow) :
             MACPhase(ctx),
             networkConfig(ctx.getNetworkConfig()),
+            syncPacketSize(getSyncPacketSize(networkConfig)),
+            rebroadcastInterval(getRebroadcastInterval(networkConfig)),
             internalStatus(initStatus),
-            receiverWindow(receivingWindow), error(0) {}
+            receiverWindow(receivingWindow), error(0),
+            syncInterval(networkConfig.getNumSuperframesPerClockSync()),
+            nextSyncInterval(networkConfig.getNumSuperframesPerClockSync()) {}
     
     TimesyncDownlink(MACContext& ctx, MacroStatus initStatus) :
             MACPhase(ctx),
             networkConfig(ctx.getNetworkConfig()),
+            syncPacketSize(getSyncPacketSize(networkConfig)),
+            rebroadcastInterval(getRebroadcastInterval(networkConfig)),
             internalStatus(initStatus),
-            receiverWindow(networkConfig.getMaxAdmittedRcvWindow()), error(0) {}
+            receiverWindow(networkConfig.getMaxAdmittedRcvWindow()), error(0),
+            syncInterval(networkConfig.getNumSuperframesPerClockSync()),
+            nextSyncInterval(networkConfig.getNumSuperframesPerClockSync()) {}
 
     virtual void next()=0;
     virtual long long correct(long long int uncorrected)=0;
     unsigned char missedPacket();
 
+    /**
+     * \return the network time of the last timesync
+     */
+    long long getSyncNetworkTime() const {
+        if(networkConfig.getAdaptiveClockSync())
+            return static_cast<long long>(packetCounter) * networkConfig.getControlSuperframeDuration();
+        return static_cast<long long>(packetCounter) * networkConfig.getClockSyncPeriod();
+    }
+
     const NetworkConfiguration& networkConfig;
+    const unsigned int syncPacketSize;
+    const int rebroadcastInterval;
     MacroStatus internalStatus;
     unsigned receiverWindow;
     long long error;
     unsigned int packetCounter;
+    /* Control superframes from the last timesync to the next one,
+     * and from the next one to the one after. They only fit in one byte, as
+     * they are sent in the timesync packet, with adaptive clock sync */
+    unsigned int syncInterval;
+    unsigned int nextSyncInterval;
 };
 
 }
@@ -59,12 +59,12 @@ MACContext::MACContext(const MediumAccessController& mac, Transceiver& transceiv
 }
 
 void MACContext::calculateDurations() {
-    dataSlotDuration = DataPhase::getDuration();
-    uplinkSlotDuration = UplinkPhase::getDuration(networkConfig.getNumUplinkPackets());
+    dataSlotDuration = DataPhase::getDuration(networkConfig);
+    uplinkSlotDuration = UplinkPhase::getDuration(networkConfig);
     /* Align the Uplink slot duration is a multiple of the Data slot duration */
     uplinkSlotDuration = align(uplinkSlotDuration, dataSlotDuration);
     auto scheduleDownlinkDuration = ScheduleDownlinkPhase::getDuration(networkConfig);
-    auto timesyncDownlinkDuration = TimesyncDownlink::getDuration(networkConfig.getMaxHops());
+    auto timesyncDownlinkDuration = TimesyncDownlink::getDuration(networkConfig);
     /* Align the Downlink slot duration is a multiple of the Data slot duration */
     downlinkSlotDuration = align(std::max(scheduleDownlinkDuration, timesyncDownlinkDuration), dataSlotDuration);
 
@@ -147,6 +147,14 @@ RecvResult MACContext::recv(void *pkt, int size, long long timeout, std::functio
     return rcvResult;
 }
 
+unsigned int MACContext::getNumTimesyncs(unsigned int tileCounter) const
+{
+    if(networkConfig.getAdaptiveClockSync())
+        return timesync->getNumTimesyncs(tileCounter);
+    int tilesPerTimesync = controlSuperframe.size() * networkConfig.getNumSuperframesPerClockSync();
+    return (tileCounter + tilesPerTimesync - 1) / tilesPerTimesync;
+}
+
 void MACContext::run()
 {
     transceiver.turnOn();
@@ -176,30 +184,49 @@ void MACContext::run()
         unsigned dataSlots;
         if(controlSuperframe.isControlDownlink(tileCounter))
         {
+            trace.beginSlot(MACTracePhase::DOWNLINK);
             if(tileCounter==0 && controlSuperframeCounter==0)
             {
                 timesync->execute(currentNextDeadline);
                 currentNextDeadline = timesync->getSlotframeStart();
             } else {
                 // Send a notify to the scheduler thread, to begin scheduling
-                beginScheduling();
+                beginScheduling(currentNextDeadline);
                 scheduleDistribution->run(currentNextDeadline);
             }
+            trace.endSlot(currentNextDeadline, downlinkSlotDuration, getTime());
             currentNextDeadline += downlinkSlotDuration;
             dataSlots = numDataSlotInDownlinkTile;
             /* DataPhase needs track of current tile slot */
             data->advanceBy(downlink_slots);
         } else {
+            trace.beginSlot(MACTracePhase::UPLINK);
             uplink->run(currentNextDeadline);
+            long long now = getTime();
+            trace.endSlot(currentNextDeadline, uplinkSlotDuration, now);
+            if(ENABLE_SLOT_CALIBRATION)
+                calibration.record(SlotCalibration::UPLINK_SLOT, now - currentNextDeadline);
             currentNextDeadline += uplinkSlotDuration;
             dataSlots = numDataSlotInUplinkTile;
             /* DataPhase needs track of current tile slot */
             data->advanceBy(uplink_slots);
         }
 
+        // With mini-slots a transmission takes more than one data slot, and
+        // the following ones, that are sleeps, share its end
+        long long dataSpanEnd = 0;
         for(unsigned i = 0; i < dataSlots; i++)
         {
+            trace.beginSlot(MACTracePhase::DATA);
             data->run(currentNextDeadline);
+            long long now = getTime();
+            bool spanStart = currentNextDeadline >= dataSpanEnd;
+            if(spanStart)
+                dataSpanEnd = currentNextDeadline + data->getLastSlotCount() * dataSlotDuration;
+            trace.endSlot(currentNextDeadline, dataSpanEnd - currentNextDeadline, now);
+            if(ENABLE_SLOT_CALIBRATION && spanStart)
+                calibration.record(SlotCalibration::DATA_SLOT, std::max(0LL,
+                    now - currentNextDeadline - radioTime(data->getLastSlotPacketSize())));
             currentNextDeadline += dataSlotDuration;
         }
         /* Call periodicUpdate to Streams and Servers */
@@ -209,8 +236,12 @@ void MACContext::run()
         if(++tileCounter >= controlSuperframe.size())
         {
             tileCounter=0;
-            if(++controlSuperframeCounter >= networkConfig.getNumSuperframesPerClockSync())
+            if(ENABLE_MAC_TRACE_DBG) trace.print(networkId);
+            if(++controlSuperframeCounter >= timesync->getSyncInterval())
+            {
                 controlSuperframeCounter=0;
+                if(ENABLE_SLOT_CALIBRATION) calibration.print(networkConfig);
+            }
         }
     }
     transceiver.turnOff();
@@ -30,6 +30,8 @@
 //#include "uplink/topology/topology_context.h"
 //#include "timesync/timesync_downlink.h"
 #include "network_configuration.h"
+#include "slot_calibration.h"
+#include "mac_trace.h"
 #include "interfaces-impl/transceiver.h"
 #include "interfaces-impl/power_manager.h"
 #include "stream/stream_manager.h"
@@ -201,6 +203,17 @@ public:
      */
     StreamManager* getStreamManager() { return &streamMgr; }
 
+    /**
+     * @return the processing times measured if ENABLE_SLOT_CALIBRATION is true
+     */
+    SlotCalibration& getSlotCalibration() { return calibration; }
+
+    /**
+     * @return the trace of what the MAC did in each slot, its records can be
+     * taken out with MACTrace::drain() from another thread
+     */
+    MACTrace& getMACTrace() { return trace; }
+
     /**
      * @return the number of slots (of data slot size) in a generic tile
      */
@@ -270,11 +283,10 @@ public:
 
     /**
      * @return the number of timesyncs occured before tileCounter
+     * NOTE: with the adaptive clock sync period only the difference between
+     * two calls for tiles after the last timesync is meaningful
      */
-    unsigned int getNumTimesyncs(unsigned int tileCounter) const {
-        int tilesPerTimesync = controlSuperframe.size() * networkConfig.getNumSuperframesPerClockSync();
-        return (tileCounter + tilesPerTimesync - 1) / tilesPerTimesync;
-    }
+    unsigned int getNumTimesyncs(unsigned int tileCounter) const;
 
     void run();
 
@@ -284,7 +296,11 @@ public:
 
     virtual void startScheduler() {};
 
-    virtual void beginScheduling() {};
+    /**
+     * \param slotStart start of the downlink slot in which the master
+     * scheduler is woken up
+     */
+    virtual void beginScheduling(long long slotStart) {};
 
 protected:
     MACContext(const MediumAccessController& mac,
@@ -324,6 +340,9 @@ private:
     unsigned rcvTotal;
     unsigned rcvErrors;
 
+    SlotCalibration calibration;
+    MACTrace trace;
+
     volatile bool running;
     const bool sleepDeep=false; //TODO: make it configurable
     bool ready = false;
@@ -0,0 +1,102 @@
+/***************************************************************************
+ *   Copyright (C) 2019 by Federico Terraneo                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   As a special exception, if other files instantiate templates or use   *
+ *   macros or inline functions from this file, or you compile this file   *
+ *   and link it with other works to produce a work based on this file,    *
+ *   this file does not by itself cause the resulting work to be covered   *
+ *   by the GNU General Public License. However the source code for this   *
+ *   file must still be made available in accordance with the GNU General  *
+ *   Public License. This exception does not invalidate any other reasons  *
+ *   why a work based on this file might be covered by the GNU General     *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ ***************************************************************************/
+
+#include "mac_trace.h"
+#include "downlink_phase/timesync/networktime.h"
+#include "util/debug_settings.h"
+#include <algorithm>
+
+namespace mxnet {
+
+static const char *eventNames[] =
+{
+    "none", "dsend", "drecv", "dmiss", "dfwd", "dbuf", "dbufmiss",
+    "tsend", "trecv", "tmiss", "usend", "urecv", "umiss",
+    "ssend", "srecv", "smiss", "gap"
+};
+
+static_assert(sizeof(eventNames)/sizeof(eventNames[0])==
+              static_cast<int>(MACTraceEvent::NUM_EVENTS),"");
+
+void MACTrace::endSlot(long long slotStart, long long slotDuration, long long now)
+{
+    long long slack = slotDuration - (now - slotStart);
+    if(current.event == MACTraceEvent::NONE && slack >= 0) return;
+    // After a gap there must be room for the TRACE_GAP record too
+    unsigned int h = head;
+    if(h - tail >= traceSize - (gap > 0 ? 1 : 0))
+    {
+        if(gap++ == 0) gapStart = NetworkTime::fromLocalTime(slotStart).get();
+        dropped++;
+        return;
+    }
+    if(gap > 0)
+    {
+        MACTraceRecord& r = records[h++ % traceSize];
+        r.time = gapStart;
+        r.slack = 0;
+        r.error = gap;
+        r.stream = StreamId();
+        r.phase = current.phase;
+        r.event = MACTraceEvent::TRACE_GAP;
+        r.node = 0;
+        r.rssi = 0;
+        gap = 0;
+    }
+    current.time = NetworkTime::fromLocalTime(slotStart).get();
+    current.slack = slack;
+    records[h++ % traceSize] = current;
+    // Publish the records only after having written them
+    __atomic_store_n(&head, h, __ATOMIC_RELEASE);
+}
+
+unsigned int MACTrace::drain(MACTraceRecord *records, unsigned int maxRecords)
+{
+    unsigned int h = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+    unsigned int result = std::min(h - tail, maxRecords);
+    for(unsigned int i = 0; i < result; i++)
+        records[i] = this->records[(tail + i) % traceSize];
+    // Release the records to the MAC thread only after having copied them
+    __atomic_store_n(&tail, tail + result, __ATOMIC_RELEASE);
+    return result;
+}
+
+void MACTrace::print(unsigned char nodeId)
+{
+    MACTraceRecord r;
+    while(drain(&r, 1) > 0)
+    {
+        print_dbg("[MT] n=%d t=%lld p=%d e=%s sl=%d s=%d,%d,%d,%d nd=%d r=%d err=%d\n",
+                  nodeId, r.time, static_cast<int>(r.phase),
+                  eventNames[static_cast<int>(r.event)], r.slack,
+                  r.stream.src, r.stream.dst, r.stream.srcPort, r.stream.dstPort,
+                  r.node, r.rssi, r.error);
+    }
+    if(dropped > 0) print_dbg("[MT] n=%d dropped=%u\n", nodeId, dropped);
+}
+
+} // namespace mxnet
@@ -0,0 +1,163 @@
+/***************************************************************************
+ *   Copyright (C) 2019 by Federico Terraneo                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   As a special exception, if other files instantiate templates or use   *
+ *   macros or inline functions from this file, or you compile this file   *
+ *   and link it with other works to produce a work based on this file,    *
+ *   this file does not by itself cause the resulting work to be covered   *
+ *   by the GNU General Public License. However the source code for this   *
+ *   file must still be made available in accordance with the GNU General  *
+ *   Public License. This exception does not invalidate any other reasons  *
+ *   why a work based on this file might be covered by the GNU General     *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ ***************************************************************************/
+
+#pragma once
+
+#include "stream/stream_parameters.h"
+
+namespace mxnet {
+
+/**
+ * What the MAC did in a slot
+ */
+enum class MACTraceEvent : unsigned char
+{
+    NONE,           ///< Nothing recorded, the slot is traced only if it overran
+    DATA_SEND,      ///< Sent a packet of a stream opened from this node
+    DATA_RECV,      ///< Received a packet of a stream opened to this node
+    DATA_MISS,      ///< Missed a packet of a stream opened to this node
+    DATA_FORWARD,   ///< Sent a buffered packet of a multihop stream
+    DATA_BUFFER,    ///< Received a packet of a multihop stream
+    DATA_BUFFER_MISS, ///< Missed a packet of a multihop stream
+    TIMESYNC_SEND,  ///< Sent or rebroadcast the timesync packet
+    TIMESYNC_RECV,  ///< Received the timesync packet, error is the clock error
+    TIMESYNC_MISS,  ///< Missed the timesync packet
+    UPLINK_SEND,    ///< Sent the uplink message
+    UPLINK_RECV,    ///< Received the uplink message of node
+    UPLINK_MISS,    ///< Missed the uplink message of node
+    SCHEDULE_SEND,  ///< Sent or rebroadcast a schedule downlink packet
+    SCHEDULE_RECV,  ///< Received a schedule downlink packet
+    SCHEDULE_MISS,  ///< Missed a schedule downlink packet
+    TRACE_GAP,      ///< Records dropped because the ring was full, see MACTrace
+    NUM_EVENTS
+};
+
+/**
+ * The phase a slot belongs to
+ */
+enum class MACTracePhase : unsigned char
+{
+    DATA, UPLINK, DOWNLINK
+};
+
+/**
+ * A slot of the MAC trace
+ */
+struct MACTraceRecord
+{
+    long long time;      ///< Network time of the slot start
+    int slack;           ///< Slot duration minus time spent, negative if overrun
+    int error;           ///< Clock error for TIMESYNC_RECV, number of dropped
+                         ///< records for TRACE_GAP, 0 otherwise
+    StreamId stream;     ///< Stream for the DATA_ events
+    MACTracePhase phase;
+    MACTraceEvent event;
+    unsigned char node;  ///< Node for the UPLINK_ events, the first of the
+                         ///< nodes sharing the slot for a shared UPLINK_MISS
+    signed char rssi;    ///< RSSI of received packets, 0 otherwise
+};
+
+/**
+ * A fixed-size ring of MACTraceRecord, one per slot in which the MAC did
+ * something or that overran. The MAC thread fills the current record through
+ * beginSlot(), event() and endSlot(), while the records are taken out with
+ * drain(), that can be called by another thread without locking.
+ * If the ring is full the new records are dropped, as overwriting the oldest
+ * ones would race with drain(). When there is room again a TRACE_GAP record,
+ * with the time of the first dropped slot and the number of dropped records,
+ * is stored before the next one, so the gap shows up where it happened.
+ */
+class MACTrace
+{
+public:
+    MACTrace() : head(0), tail(0), dropped(0), gap(0), gapStart(0), current() {}
+
+    /**
+     * Called by the MAC thread before executing a slot
+     */
+    void beginSlot(MACTracePhase phase)
+    {
+        current.phase = phase;
+        current.event = MACTraceEvent::NONE;
+    }
+
+    /**
+     * Called by the MAC phases to record what they did in the current slot,
+     * if called more than once per slot the last event is kept
+     */
+    void event(MACTraceEvent e, StreamId stream = StreamId(),
+               unsigned char node = 0, short rssi = 0, int error = 0)
+    {
+        current.event = e;
+        current.stream = stream;
+        current.node = node;
+        current.rssi = rssi;
+        current.error = error;
+    }
+
+    /**
+     * Called by the MAC thread after a slot, commits the current record
+     * \param slotStart the slot start in local time
+     * \param slotDuration the slot duration
+     * \param now the current time
+     */
+    void endSlot(long long slotStart, long long slotDuration, long long now);
+
+    /**
+     * Take the oldest records out of the ring
+     * \param records where to store them
+     * \param maxRecords maximum number of records to store
+     * \return the number of records stored
+     */
+    unsigned int drain(MACTraceRecord *records, unsigned int maxRecords);
+
+    /**
+     * Drain the ring printing all the records, to be decoded with
+     * experiments/scripts/mac_trace_analyzer.py
+     * \param nodeId the node id, printed with each record
+     */
+    void print(unsigned char nodeId);
+
+    /**
+     * \return the number of records dropped because the ring was full
+     */
+    unsigned int getDropped() const { return dropped; }
+
+    /// Number of records in the ring, a power of two
+    static const unsigned int traceSize = 128;
+
+private:
+    volatile unsigned int head; ///< Written only by the MAC thread
+    volatile unsigned int tail; ///< Written only by the draining thread
+    unsigned int dropped;
+    unsigned int gap;           ///< Records dropped since the last one stored
+    long long gapStart;         ///< Network time of the first of them
+    MACTraceRecord current;
+    MACTraceRecord records[traceSize];
+};
+
+} // namespace mxnet
@@ -32,6 +32,7 @@
 #include "downlink_phase/master_schedule_distribution.h"
 #include "uplink_phase/master_uplink_phase.h"
 #include "scheduler/schedule_computation.h"
+#include "scheduler/schedule_capture.h"
 
 namespace mxnet {
 
@@ -41,9 +42,13 @@ public:
     MasterMACContext() = delete;
     virtual ~MasterMACContext() {};
     void startScheduler() {
+      ScheduleCapture::configuration(getNetworkConfig(), getSlotsInTileCount(),
+          getDataSlotsInDownlinkTileCount(), getDataSlotsInUplinkTileCount());
       scheduleComputation.startThread();
     };
-    void beginScheduling() {
+    void beginScheduling(long long slotStart) {
+      if(ScheduleCapture::enabled())
+          ScheduleCapture::beginScheduling(getCurrentTile(slotStart));
       scheduleComputation.beginScheduling();
     };
 
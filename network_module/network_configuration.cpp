@@ -31,6 +31,8 @@
 #include "util/bitwise_ops.h"
 #include "util/debug_settings.h"
 #include "uplink_phase/uplink_message.h"
+#include "downlink_phase/timesync/timesync_downlink.h"
+#include "data_phase/dataphase.h"
 #include <stdexcept>
 
 namespace mxnet {
@@ -70,7 +72,10 @@ NetworkConfiguration::NetworkConfiguration(unsigned char maxHops, unsigned short
         unsigned short maxRoundsWeakLinkBecomesDead, 
         short minNeighborRSSI, short minWeakNeighborRSSI,
         unsigned char maxMissedTimesyncs, bool channelSpatialReuse,
-        bool useWeakTopologies, ControlSuperframeStructure controlSuperframe) :
+        bool useWeakTopologies, ControlSuperframeStructure controlSuperframe,
+        unsigned char uplinkDiscoveryInterval, bool uplinkSpatialReuse,
+        SlotTimings slotTimings, unsigned char miniSlotPayloadSize,
+        unsigned long long maxClockSyncPeriod) :
     maxHops(maxHops), hopBits(BitwiseOps::bitsForRepresentingCount(maxHops)),
     numUplinkPerSuperframe(controlSuperframe.countUplinkSlots()), numDownlinkPerSuperframe(controlSuperframe.countDownlinkSlots()),
     staticNetworkId(networkId), staticHop(staticHop), maxNodes(maxNodes),
@@ -83,12 +88,27 @@ NetworkConfiguration::NetworkConfiguration(unsigned char maxHops, unsigned short
     minNeighborRSSI(minNeighborRSSI), minWeakNeighborRSSI(minWeakNeighborRSSI),
     channelSpatialReuse(channelSpatialReuse),
     useWeakTopologies(useWeakTopologies), controlSuperframe(controlSuperframe),
+    uplinkDiscoveryInterval(uplinkDiscoveryInterval),
+    uplinkSpatialReuse(uplinkSpatialReuse), slotTimings(slotTimings),
+    miniSlotPayloadSize(miniSlotPayloadSize),
+    maxClockSyncPeriod(maxClockSyncPeriod),
     controlSuperframeDuration(tileDuration * controlSuperframe.size()),
     numSuperframesPerClockSync(clockSyncPeriod / controlSuperframeDuration) {
     validate();
 }
 
 void NetworkConfiguration::validate() const {
+    // Checked first since the getters return the fixed values
+#ifdef TDMH_FIXED_MAX_NODES
+    if(maxNodes != TDMH_FIXED_MAX_NODES)
+        throwLogicError("maxNodes (%d) differs from TDMH_FIXED_MAX_NODES (%d)",
+                        maxNodes, TDMH_FIXED_MAX_NODES);
+#endif
+#ifdef TDMH_FIXED_MAX_HOPS
+    if(maxHops != TDMH_FIXED_MAX_HOPS)
+        throwLogicError("maxHops (%d) differs from TDMH_FIXED_MAX_HOPS (%d)",
+                        maxHops, TDMH_FIXED_MAX_HOPS);
+#endif
     const int totAvailableBytes = getFirstUplinkPacketCapacity(*this) +
         (numUplinkPackets - 1) * getOtherUplinkPacketCapacity();
     auto topologySize = guaranteedTopologies * TopologyElement::maxSize(
@@ -99,9 +119,37 @@ void NetworkConfiguration::validate() const {
     if(clockSyncPeriod % controlSuperframeDuration != 0)
         throwLogicError("control superframe (%lld) does not divide clock sync period (%lld)",
                         controlSuperframeDuration, clockSyncPeriod);
+    if(maxClockSyncPeriod != 0) {
+        if(maxClockSyncPeriod < clockSyncPeriod)
+            throwLogicError("maxClockSyncPeriod (%lld) is less than clockSyncPeriod (%lld)",
+                            maxClockSyncPeriod, clockSyncPeriod);
+        if(maxClockSyncPeriod % controlSuperframeDuration != 0)
+            throwLogicError("control superframe (%lld) does not divide max clock sync period (%lld)",
+                            controlSuperframeDuration, maxClockSyncPeriod);
+        // The sync intervals are announced in the timesync packet in one byte
+        if(maxClockSyncPeriod / controlSuperframeDuration > 255)
+            throwLogicError("maxClockSyncPeriod exceeds 255 control superframes");
+    }
     // maxNodes must be a multiple of 8 because otherwise the RuntimeBitset won't work correctly
     if((maxNodes % 8) != 0)
       throwLogicError("Configuration error: maxNodes must be a multiple of 8");
+    // With an interval of 1 every uplink slot would be a discovery slot
+    if(uplinkDiscoveryInterval == 1)
+        throwLogicError("uplinkDiscoveryInterval must be either 0 or greater than 1");
+    if(slotTimings.getDataProcessing() < 0 || slotTimings.getUplinkPacketProcessing() < 0
+        || slotTimings.getDownlinkRebroadcastProcessing() < 0)
+        throwLogicError("slotTimings can't be negative");
+    if(miniSlotPayloadSize > DataPhase::getMaxPayloadSize())
+        throwLogicError("miniSlotPayloadSize %d exceeds maximum payload size %d",
+                        miniSlotPayloadSize, DataPhase::getMaxPayloadSize());
+    if(uplinkSpatialReuse) {
+        // The uplink groups are advertised by the adaptive round-robin, and
+        // weak links are needed to know which nodes interfere
+        if(uplinkDiscoveryInterval == 0 || useWeakTopologies == false)
+            throwLogicError("uplinkSpatialReuse requires uplinkDiscoveryInterval and useWeakTopologies");
+        if(TimesyncDownlink::getSyncPacketSize(*this) > MediumAccessController::maxControlPktSize)
+            throwLogicError("uplinkSpatialReuse: timesync packet too large for %d nodes", maxNodes);
+    }
 }
 
 } /* namespace mxnet */
@@ -27,6 +27,9 @@
 
 #pragma once
 
+#include "util/network_size.h"
+#include "util/bitwise_ops.h"
+
 namespace mxnet {
 
 /**
@@ -92,6 +95,56 @@ private:
     const int sz;
 };
 
+/**
+ * This class contains the processing times used to compute the slot durations.
+ * The defaults are conservative, the worst-case times measured on the target
+ * with the calibration mode (ENABLE_SLOT_CALIBRATION in debug_settings.h)
+ * can be used instead to shrink the slots
+ */
+class SlotTimings
+{
+public:
+    /**
+     * Default constructor, uses the hand-tuned processing times
+     */
+    SlotTimings() : dataProcessing(1500000), uplinkPacketProcessing(5000000),
+        downlinkRebroadcastProcessing(244000) {}
+
+    /**
+     * \param dataProcessing time in nanoseconds needed in a data slot in
+     * addition to the time to transmit a packet of maximum size
+     * \param uplinkPacketProcessing time in nanoseconds needed to receive
+     * and process each packet of an uplink message
+     * \param downlinkRebroadcastProcessing time in nanoseconds needed from the
+     * end of the reception of a schedule downlink packet to its rebroadcast
+     */
+    SlotTimings(int dataProcessing, int uplinkPacketProcessing,
+                int downlinkRebroadcastProcessing)
+        : dataProcessing(dataProcessing),
+          uplinkPacketProcessing(uplinkPacketProcessing),
+          downlinkRebroadcastProcessing(downlinkRebroadcastProcessing) {}
+
+    /**
+     * \return the processing time in a data slot
+     */
+    int getDataProcessing() const { return dataProcessing; }
+
+    /**
+     * \return the reception and processing time of an uplink packet
+     */
+    int getUplinkPacketProcessing() const { return uplinkPacketProcessing; }
+
+    /**
+     * \return the processing time to rebroadcast a schedule downlink packet
+     */
+    int getDownlinkRebroadcastProcessing() const { return downlinkRebroadcastProcessing; }
+
+private:
+    int dataProcessing;
+    int uplinkPacketProcessing;
+    int downlinkRebroadcastProcessing;
+};
+
 
 class NetworkConfiguration {
 public:
@@ -106,7 +159,12 @@ public:
             short minNeighborRSSI, short minWeakNeighborRSSI,
             unsigned char maxMissedTimesyncs,
             bool channelSpatialReuse, bool useWeakTopologies,
-            ControlSuperframeStructure controlSuperframe=ControlSuperframeStructure());
+            ControlSuperframeStructure controlSuperframe=ControlSuperframeStructure(),
+            unsigned char uplinkDiscoveryInterval=0,
+            bool uplinkSpatialReuse=false,
+            SlotTimings slotTimings=SlotTimings(),
+            unsigned char miniSlotPayloadSize=0,
+            unsigned long long maxClockSyncPeriod=0);
 
     /**
      * @return the reference frequency for the protocol.
@@ -126,7 +184,11 @@ public:
      * @return the number of bits needed to represent the hop count
      */
     unsigned char getHopBits() const {
+#ifdef TDMH_FIXED_MAX_HOPS
+        return BitwiseOps::bitsForRepresentingCountConstexpr(TDMH_FIXED_MAX_HOPS);
+#else
         return hopBits;
+#endif
     }
 
     /**
@@ -184,21 +246,29 @@ public:
      * @return the maximum number of hops the networks supports.
      */
     unsigned char getMaxHops() const {
+#ifdef TDMH_FIXED_MAX_HOPS
+        return TDMH_FIXED_MAX_HOPS;
+#else
         return maxHops;
+#endif
     }
 
     /**
      * @return the maximum number of nodes the network supports.
      */
     unsigned short getMaxNodes() const {
+#ifdef TDMH_FIXED_MAX_NODES
+        return TDMH_FIXED_MAX_NODES;
+#else
         return maxNodes;
+#endif
     }
 
     /**
      * @return the size of the bitmask used to store neighbors of a node.
      */
     unsigned short getNeighborBitmaskSize() const {
-        return ((maxNodes + 7) / 8);
+        return ((getMaxNodes() + 7) / 8);
     }
 
     /**
@@ -281,12 +351,38 @@ public:
     }
 
     /**
-     * @return the number of superframes contained within a clock sync period
+     * @return the number of superframes contained within a clock sync period,
+     * the minimum one if the adaptive clock sync period is enabled
      */
     unsigned getNumSuperframesPerClockSync() const {
         return numSuperframesPerClockSync;
     }
 
+    /**
+     * @return true if the master adapts the clock sync period between
+     * getClockSyncPeriod() and getMaxClockSyncPeriod() based on the
+     * synchronization error reported by the nodes
+     */
+    bool getAdaptiveClockSync() const {
+        return maxClockSyncPeriod > clockSyncPeriod;
+    }
+
+    /**
+     * @return the maximum clock sync period, equal to getClockSyncPeriod()
+     * if the adaptive clock sync period is disabled
+     */
+    unsigned long long getMaxClockSyncPeriod() const {
+        return getAdaptiveClockSync() ? maxClockSyncPeriod : clockSyncPeriod;
+    }
+
+    /**
+     * @return the number of superframes contained within the maximum clock
+     * sync period
+     */
+    unsigned getMaxNumSuperframesPerClockSync() const {
+        return getMaxClockSyncPeriod() / controlSuperframeDuration;
+    }
+
     /**
      * @return true if spatial reuse of channel is enabled
      */
@@ -302,6 +398,54 @@ public:
         return useWeakTopologies;
     }
 
+    /**
+     * @return 0 if the uplink round-robin visits all node ids, otherwise
+     * the uplink slots are assigned only to the nodes that the master
+     * advertises as present in the network, and one every
+     * getUplinkDiscoveryInterval() uplink slots is left to the absent ones
+     * so that new nodes can join.
+     */
+    unsigned char getUplinkDiscoveryInterval() const {
+        return uplinkDiscoveryInterval;
+    }
+
+    /**
+     * @return the processing times used to compute the slot durations
+     */
+    SlotTimings getSlotTimings() const {
+        return slotTimings;
+    }
+
+    /**
+     * @return true if nodes that are far apart in the network graph can be
+     * assigned the same uplink slot. Requires the adaptive uplink round-robin
+     */
+    bool getUplinkSpatialReuse() const {
+        return uplinkSpatialReuse;
+    }
+
+    /**
+     * @return 0 if every data slot is long enough for a packet of maximum
+     * size, otherwise data slots are mini-slots sized for a stream payload of
+     * getMiniSlotPayloadSize() bytes, and the scheduler allocates to each
+     * transmission as many consecutive mini-slots as its payload needs
+     */
+    unsigned char getMiniSlotPayloadSize() const {
+        return miniSlotPayloadSize;
+    }
+
+    /**
+     * @return the size of the information about the nodes present in the
+     * network appended to the timesync packet by the adaptive uplink
+     * round-robin. It is a bitmap of the present nodes, or 4 bits per node
+     * with the uplink group if uplink spatial reuse is enabled
+     */
+    unsigned short getLiveNodesSize() const {
+        if(uplinkDiscoveryInterval == 0) return 0;
+        if(uplinkSpatialReuse) return (getMaxNodes() + 1) / 2;
+        return getNeighborBitmaskSize();
+    }
+
 private:
     /**
      * Validates the times configured
@@ -332,6 +476,11 @@ private:
     const bool channelSpatialReuse;
     const bool useWeakTopologies;
     const ControlSuperframeStructure controlSuperframe;
+    const unsigned char uplinkDiscoveryInterval;
+    const bool uplinkSpatialReuse;
+    const SlotTimings slotTimings;
+    const unsigned char miniSlotPayloadSize;
+    const unsigned long long maxClockSyncPeriod;
     const unsigned long long controlSuperframeDuration;
 
     unsigned numSuperframesPerClockSync;
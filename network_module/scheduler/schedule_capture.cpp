@@ -0,0 +1,134 @@
+/***************************************************************************
+ *   Copyright (C) 2019 by Federico Terraneo                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   As a special exception, if other files instantiate templates or use   *
+ *   macros or inline functions from this file, or you compile this file   *
+ *   and link it with other works to produce a work based on this file,    *
+ *   this file does not by itself cause the resulting work to be covered   *
+ *   by the GNU General Public License. However the source code for this   *
+ *   file must still be made available in accordance with the GNU General  *
+ *   Public License. This exception does not invalidate any other reasons  *
+ *   why a work based on this file might be covered by the GNU General     *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ ***************************************************************************/
+
+#include "schedule_capture.h"
+#include "../util/packet.h"
+
+namespace mxnet {
+
+ScheduleCapture::Sink ScheduleCapture::sink = nullptr;
+
+/**
+ * Append an integer to a packet in little endian
+ */
+static void putLittleEndian(Packet& pkt, unsigned long long value, unsigned int bytes)
+{
+    unsigned char data[sizeof(value)];
+    for(unsigned int i = 0; i < bytes; i++) data[i] = value >> (8 * i);
+    pkt.put(data, bytes);
+}
+
+void ScheduleCapture::configuration(const NetworkConfiguration& config, unsigned slotsPerTile,
+                                    unsigned dataslotsPerDownlinkTile, unsigned dataslotsPerUplinkTile)
+{
+    if(sink == nullptr) return;
+    auto superframe = config.getControlSuperframeStructure();
+    unsigned int bitmask = 0;
+    for(int i = 0; i < superframe.size(); i++)
+        if(superframe.isControlDownlink(i)) bitmask |= 1 << i;
+    auto timings = config.getSlotTimings();
+    Packet pkt;
+    putLittleEndian(pkt, config.getMaxHops(), 1);
+    putLittleEndian(pkt, config.getMaxNodes(), 2);
+    putLittleEndian(pkt, config.getStaticNetworkId(), 2);
+    putLittleEndian(pkt, config.getStaticHop(), 1);
+    putLittleEndian(pkt, config.getPanId(), 2);
+    putLittleEndian(pkt, static_cast<unsigned short>(config.getTxPower()), 2);
+    putLittleEndian(pkt, config.getBaseFrequency(), 4);
+    putLittleEndian(pkt, config.getClockSyncPeriod(), 8);
+    putLittleEndian(pkt, config.getGuaranteedTopologies(), 1);
+    putLittleEndian(pkt, config.getNumUplinkPackets(), 1);
+    putLittleEndian(pkt, config.getTileDuration(), 8);
+    putLittleEndian(pkt, config.getMaxAdmittedRcvWindow(), 8);
+    putLittleEndian(pkt, config.getMaxRoundsUnavailableBecomesDead(), 2);
+    putLittleEndian(pkt, config.getMaxRoundsWeakLinkBecomesDead(), 2);
+    putLittleEndian(pkt, static_cast<unsigned short>(config.getMinNeighborRSSI()), 2);
+    putLittleEndian(pkt, static_cast<unsigned short>(config.getMinWeakNeighborRSSI()), 2);
+    putLittleEndian(pkt, config.getMaxMissedTimesyncs(), 1);
+    putLittleEndian(pkt, config.getChannelSpatialReuse(), 1);
+    putLittleEndian(pkt, config.getUseWeakTopologies(), 1);
+    putLittleEndian(pkt, bitmask, 4);
+    putLittleEndian(pkt, superframe.size(), 1);
+    putLittleEndian(pkt, config.getUplinkDiscoveryInterval(), 1);
+    putLittleEndian(pkt, config.getUplinkSpatialReuse(), 1);
+    putLittleEndian(pkt, timings.getDataProcessing(), 4);
+    putLittleEndian(pkt, timings.getUplinkPacketProcessing(), 4);
+    putLittleEndian(pkt, timings.getDownlinkRebroadcastProcessing(), 4);
+    putLittleEndian(pkt, config.getMiniSlotPayloadSize(), 1);
+    putLittleEndian(pkt, config.getMaxClockSyncPeriod(), 8);
+    putLittleEndian(pkt, slotsPerTile, 4);
+    putLittleEndian(pkt, dataslotsPerDownlinkTile, 4);
+    putLittleEndian(pkt, dataslotsPerUplinkTile, 4);
+    record(CaptureType::CONFIGURATION, 0, pkt);
+}
+
+void ScheduleCapture::topologies(unsigned int tile,
+                                 const UpdatableQueue<unsigned char, TopologyElement>& queue)
+{
+    if(sink == nullptr) return;
+    // Visited in the order handleTopologies() dequeues them
+    queue.visit([tile](const TopologyElement& topology) {
+        Packet pkt;
+        topology.serialize(pkt);
+        record(CaptureType::TOPOLOGY, tile, pkt);
+        return true;
+    });
+}
+
+void ScheduleCapture::smes(unsigned int tile,
+                           const UpdatableQueue<SMEKey, StreamManagementElement>& queue)
+{
+    if(sink == nullptr) return;
+    queue.visit([tile](const StreamManagementElement& sme) {
+        Packet pkt;
+        sme.serialize(pkt);
+        record(CaptureType::SME, tile, pkt);
+        return true;
+    });
+}
+
+void ScheduleCapture::record(CaptureType type, unsigned int tile, Packet& payload)
+{
+    unsigned char data[MediumAccessController::maxPktSize];
+    unsigned int size = payload.size();
+    payload.get(data, size);
+    record(type, tile, data, size);
+}
+
+void ScheduleCapture::record(CaptureType type, unsigned int tile,
+                             const unsigned char *payload, unsigned int size)
+{
+    unsigned char data[headerSize + MediumAccessController::maxPktSize];
+    data[0] = static_cast<unsigned char>(type);
+    for(int i = 0; i < 4; i++) data[1 + i] = tile >> (8 * i);
+    data[5] = size & 0xff;
+    data[6] = size >> 8;
+    for(unsigned int i = 0; i < size; i++) data[headerSize + i] = payload[i];
+    sink(data, headerSize + size);
+}
+
+} // namespace mxnet
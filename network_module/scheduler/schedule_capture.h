@@ -0,0 +1,133 @@
+/***************************************************************************
+ *   Copyright (C) 2019 by Federico Terraneo                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   As a special exception, if other files instantiate templates or use   *
+ *   macros or inline functions from this file, or you compile this file   *
+ *   and link it with other works to produce a work based on this file,    *
+ *   this file does not by itself cause the resulting work to be covered   *
+ *   by the GNU General Public License. However the source code for this   *
+ *   file must still be made available in accordance with the GNU General  *
+ *   Public License. This exception does not invalidate any other reasons  *
+ *   why a work based on this file might be covered by the GNU General     *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ ***************************************************************************/
+
+#pragma once
+
+#include "../network_configuration.h"
+#include "../uplink_phase/topology/topology_element.h"
+#include "../stream/stream_management_element.h"
+#include "../util/updatable_queue.h"
+
+namespace mxnet {
+
+class Packet;
+
+/**
+ * Type of a ScheduleCapture record
+ */
+enum class CaptureType : unsigned char
+{
+    CONFIGURATION,    ///< Payload is the configuration, see ScheduleCapture::configuration()
+    TOPOLOGY,         ///< Payload is a serialized TopologyElement
+    SME,              ///< Payload is a serialized StreamManagementElement
+    BEGIN_SCHEDULING, ///< The scheduler was woken up, no payload
+    SCHEDULE_APPLIED  ///< The last schedule was distributed and applied, no payload
+};
+
+/**
+ * Records the inputs of the master ScheduleComputation, so that a slow or
+ * wrong reschedule seen in a simulation or on a real network can be
+ * reproduced offline with tests/local/scheduler/schedule_replay.
+ *
+ * A capture is a sequence of records, each made of a one byte CaptureType,
+ * the four byte tile in which the event happened and the two byte size of the
+ * payload that follows. All integers are little endian, so that a capture
+ * taken on the nodes can be read on any host.
+ *
+ * As for the EventLog, records are passed to a sink set by the platform,
+ * and if no sink is set, as on the nodes unless the application sets one,
+ * capturing is just a test. All records are produced by the MAC thread.
+ */
+class ScheduleCapture
+{
+public:
+    /**
+     * Called with each record, that has to be stored or sent as is.
+     * Unlike the EventLog records can't be dropped, as the replay would diverge
+     */
+    typedef void (*Sink)(const unsigned char *record, unsigned int size);
+
+    /**
+     * \param s the sink, or nullptr to stop capturing
+     */
+    static void setSink(Sink s) { sink = s; }
+
+    /**
+     * \return true if the master inputs are captured
+     */
+    static bool enabled() { return sink != nullptr; }
+
+    /**
+     * Record the configuration, all the NetworkConfiguration constructor
+     * parameters in order followed by the slot counts of the tiles, with the
+     * sizes of the NetworkConfiguration getters and 4 bytes for the control
+     * superframe bitmask and for each SlotTimings and slot count
+     */
+    static void configuration(const NetworkConfiguration& config, unsigned slotsPerTile,
+                              unsigned dataslotsPerDownlinkTile, unsigned dataslotsPerUplinkTile);
+
+    /**
+     * Record the topologies about to be passed to NetworkTopology::handleTopologies()
+     */
+    static void topologies(unsigned int tile,
+                           const UpdatableQueue<unsigned char, TopologyElement>& queue);
+
+    /**
+     * Record the SMEs about to be passed to StreamCollection::receiveSMEs()
+     */
+    static void smes(unsigned int tile,
+                     const UpdatableQueue<SMEKey, StreamManagementElement>& queue);
+
+    /**
+     * Record a ScheduleComputation::beginScheduling()
+     */
+    static void beginScheduling(unsigned int tile)
+    {
+        if(sink) record(CaptureType::BEGIN_SCHEDULING, tile, nullptr, 0);
+    }
+
+    /**
+     * Record a ScheduleComputation::scheduleSentAndApplied()
+     */
+    static void scheduleApplied(unsigned int tile)
+    {
+        if(sink) record(CaptureType::SCHEDULE_APPLIED, tile, nullptr, 0);
+    }
+
+    /// Size of the type, tile and payload size fields of a record
+    static const unsigned int headerSize = 7;
+
+private:
+    static void record(CaptureType type, unsigned int tile, Packet& payload);
+
+    static void record(CaptureType type, unsigned int tile,
+                       const unsigned char *payload, unsigned int size);
+
+    static Sink sink;
+};
+
+} // namespace mxnet
@@ -28,6 +28,7 @@
 #include "schedule_computation.h"
 #include "../util/debug_settings.h"
 #include "../util/stackrange.h"
+#include "../data_phase/dataphase.h"
 #include <unordered_set>
 #include <algorithm>
 #include <utility>
@@ -50,8 +51,8 @@ ScheduleComputation::ScheduleComputation(const NetworkConfiguration& cfg,
     reservedSlotsUplink(slotsPerTile-dataslotsPerUplinkTile),
     netconfig(cfg),
     superframe(netconfig.getControlSuperframeStructure()),
-    network_graph(netconfig.getNeighborBitmaskSize()),
-    weak_graph(netconfig.getNeighborBitmaskSize())
+    network_graph(netconfig.getMaxNodes()),
+    weak_graph(netconfig.getMaxNodes())
 {
 
 }
@@ -102,37 +103,42 @@ void ScheduleComputation::run()
             ready=false;
 #endif
         }
-        
-        bool forceReschedule=false, forceResend=false;
-        
-        if(topology->wasModified())
-        {
-            // If topology changes, need to reschedule
-            forceReschedule = true;
-            auto op = stream_collection.getOperation();
-            if(op.resend) forceResend = true;
-        } else {
-            // We may also need to reschedule due to stream changes
-            auto op = stream_collection.getOperation();
-            if(op.reschedule) forceReschedule = true;
-            if(op.resend) forceResend = true;
-        }
-        
-        bool scheduleChanged=false;
-        if(forceReschedule) scheduleChanged=reschedule();
-        
-        if(forceResend && !scheduleChanged)
-        {
+        step();
+    }
+}
+
+bool ScheduleComputation::step()
+{
+    bool forceReschedule=false, forceResend=false;
+    
+    if(topology->wasModified())
+    {
+        // If topology changes, need to reschedule
+        forceReschedule = true;
+        auto op = stream_collection.getOperation();
+        if(op.resend) forceResend = true;
+    } else {
+        // We may also need to reschedule due to stream changes
+        auto op = stream_collection.getOperation();
+        if(op.reschedule) forceReschedule = true;
+        if(op.resend) forceResend = true;
+    }
+    
+    bool scheduleChanged=false;
+    if(forceReschedule) scheduleChanged=reschedule();
+    
+    if(forceResend && !scheduleChanged)
+    {
 #ifdef _MIOSIX
-            miosix::Lock<miosix::Mutex> lck(sched_mutex);
+        miosix::Lock<miosix::Mutex> lck(sched_mutex);
 #else
-            std::unique_lock<std::mutex> lck(sched_mutex);
+        std::unique_lock<std::mutex> lck(sched_mutex);
 #endif
-            // If we get here we have not rescheduled but are asked to resend.
-            // Just mark the presence of a schedule to be sent, not yet applied
-            scheduleNotApplied = true;
-        }
+        // If we get here we have not rescheduled but are asked to resend.
+        // Just mark the presence of a schedule to be sent, not yet applied
+        scheduleNotApplied = true;
     }
+    return forceReschedule;
 }
 
 bool ScheduleComputation::reschedule()
@@ -402,8 +408,10 @@ std::pair<std::list<ScheduleElement>, unsigned int> ScheduleComputation::schedul
             // with minimum period size being equal to the tile lenght (by design)
             // Otherwise the resulting stream won't be periodic
             unsigned max_offset = (toInt(transmission.getPeriod()) * slotsPerTile) - 1;
-            for(unsigned offset = last_offset; offset < max_offset; offset++) {
-                if(!checkDataSlot(offset))
+            // With mini-slots a transmission may need more consecutive slots
+            unsigned slot_count = getSlotCount(transmission);
+            for(unsigned offset = last_offset; offset + slot_count - 1 < max_offset; offset++) {
+                if(!checkDataSlots(offset, slot_count))
                     continue;
                 if(SCHEDULER_DETAILED_DBG)
                     printf("[SC] Checking offset %d\n", offset);
@@ -419,7 +427,7 @@ std::pair<std::list<ScheduleElement>, unsigned int> ScheduleComputation::schedul
                                               offset, linksCausingInterference);
 
                 if(!conflict) {
-                    last_offset = offset;
+                    last_offset = offset + slot_count - 1;
                     block_size++;
                     // Calculate new schedule size
                     unsigned period = toInt(transmission.getPeriod());
@@ -447,7 +455,7 @@ std::pair<std::list<ScheduleElement>, unsigned int> ScheduleComputation::schedul
             last_offset++;
             // If we are in the last timeslot and have a conflict,
             // cannot reschedule on another timeslot
-            if(last_offset == max_offset) {
+            if(last_offset >= max_offset) {
                 stream_err = true;
                 // Print error if max_offset is used on a transmission != last transmission
                 if(transmission.getDst() != transmission.getRx())
@@ -536,14 +544,30 @@ bool ScheduleComputation::checkDataSlot(unsigned offset) {
     return true;
 }
 
+unsigned ScheduleComputation::getSlotCount(const ScheduleElement& transmission) const {
+    return DataPhase::getSlotsForPayload(netconfig, transmission.getParams().getPayloadSize());
+}
+
+bool ScheduleComputation::checkDataSlots(unsigned offset, unsigned count) {
+    // Control slots are at the beginning of each tile, so this also prevents
+    // a transmission from crossing a tile boundary
+    for(unsigned i = 0; i < count; i++)
+        if(!checkDataSlot(offset + i))
+            return false;
+    return true;
+}
+
 // This easy check is a necessary condition for a slot conflict,
 // if the result is false, then a conflict cannot happen
 // It can be used to avoid nested loops
 bool ScheduleComputation::slotConflictPossible(const ScheduleElement& newtransm,
                                                const ScheduleElement& oldtransm,
                                                unsigned offset) {
-    // Compare offsets relative to current tile of two transmissions
-    return ((offset % slotsPerTile) == (oldtransm.getOffset() % slotsPerTile));
+    // Compare the slots occupied by the two transmissions relative to current tile
+    unsigned new_begin = offset % slotsPerTile;
+    unsigned old_begin = oldtransm.getOffset() % slotsPerTile;
+    return (new_begin < old_begin + getSlotCount(oldtransm)) &&
+           (old_begin < new_begin + getSlotCount(newtransm));
 }
 
 // Extensive check to be used when slotConflictPossible returns true
@@ -556,10 +580,13 @@ bool ScheduleComputation::checkSlotConflict(const ScheduleElement& newtransm,
     unsigned periodslots_a = period_a * slotsPerTile;
     unsigned periodslots_b = period_b * slotsPerTile;
     unsigned schedule_slots = lcm(period_a, period_b) * slotsPerTile;
+    // Transmissions may span more than one slot with mini-slots
+    unsigned count_a = getSlotCount(newtransm);
+    unsigned count_b = getSlotCount(oldtransm);
 
     for(unsigned slot_a=offset_a; slot_a < schedule_slots; slot_a += periodslots_a) {
         for(unsigned slot_b=oldtransm.getOffset(); slot_b < schedule_slots; slot_b += periodslots_b) {
-            if(slot_a == slot_b)
+            if(slot_a < slot_b + count_b && slot_b < slot_a + count_a)
                 return true;
         }
     }
@@ -91,7 +91,16 @@ public:
     void startThread();
     
     void beginScheduling();
-    
+
+    /**
+     * Do in the calling thread what the scheduler thread does when woken up
+     * by beginScheduling(), to replay a ScheduleCapture deterministically.
+     * Must not be used if the thread was started, and as the thread does,
+     * must not be called while needToSendSchedule() is true.
+     * \return true if a reschedule was computed
+     */
+    bool step();
+
     /**
      * Used by the ScheduleDownlink class to get the latest schedule
      * @return a copy of the Schedule class containing schedule, size, id
@@ -190,6 +199,17 @@ private:
 
     bool checkDataSlot(unsigned offset);
 
+    /**
+     * \return the number of consecutive data slots a transmission occupies,
+     * greater than 1 only with mini-slots
+     */
+    unsigned getSlotCount(const ScheduleElement& transmission) const;
+
+    /**
+     * \return true if all the slots from offset to offset+count-1 are data slots
+     */
+    bool checkDataSlots(unsigned offset, unsigned count);
+
     bool slotConflictPossible(const ScheduleElement& newtransm, const ScheduleElement& oldtransm, unsigned offset);
 
     bool checkSlotConflict(const ScheduleElement& newtransm, const ScheduleElement& oldtransm, unsigned offset_a);
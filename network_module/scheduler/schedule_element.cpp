@@ -31,29 +31,101 @@
 namespace mxnet {
 
 void ScheduleHeader::serialize(Packet& pkt) const {
-    pkt.put(&header, sizeof(ScheduleHeaderPkt));
+    auto w = pkt.reserve(size());
+    w.put(header);
+    if(isDelta()) w.put(delta);
 }
 
 void ScheduleHeader::deserialize(Packet& pkt) {
-    pkt.get(&header, sizeof(ScheduleHeaderPkt));
+    pkt.consume(sizeof(ScheduleHeaderPkt)).get(header);
+    if(isDelta()) pkt.consume(sizeof(ScheduleDeltaPkt)).get(delta);
+    else std::memset(&delta, 0, sizeof(ScheduleDeltaPkt));
 }
 
 
 void ScheduleElement::serialize(Packet& pkt) const {
-    pkt.put(&id, sizeof(StreamId));
-    pkt.put(&params, sizeof(StreamParameters));
-    pkt.put(&content, sizeof(ScheduleElementPkt));
+    auto w = pkt.reserve(maxSize());
+    w.put(id);
+    w.put(params);
+    w.put(content);
 }
 
 void ScheduleElement::deserialize(Packet& pkt) {
-    pkt.get(&id, sizeof(StreamId));
-    pkt.get(&params, sizeof(StreamParameters));
-    pkt.get(&content, sizeof(ScheduleElementPkt));
+    auto r = pkt.consume(maxSize());
+    r.get(id);
+    r.get(params);
+    r.get(content);
+}
+
+/* Kinds of compact groups that are not a number of elements */
+static const unsigned char removedStreamKind = 0;
+static const unsigned char infoElementKind = 255;
+static const unsigned int maxGroupElements = 254;
+
+static bool isInfoElement(const ScheduleElement& e) {
+    return e.getTx() == 0 && e.getRx() == 0;
+}
+
+/**
+ * \return the number of elements starting from i in the same compact group
+ */
+static unsigned int groupLength(const std::vector<ScheduleElement>& elements, unsigned int i) {
+    if(isInfoElement(elements[i])) return 1;
+    unsigned int j = i + 1;
+    while(j < elements.size() && j - i < maxGroupElements &&
+          isInfoElement(elements[j]) == false &&
+          elements[j].getKey() == elements[i].getKey()) j++;
+    return j - i;
+}
+
+/**
+ * \return the varint value of an element in a compact group
+ */
+static unsigned int compactElement(const ScheduleElement& e, unsigned int prevOffset,
+                                   unsigned char prevRx) {
+    int diff = static_cast<int>(e.getOffset()) - static_cast<int>(prevOffset);
+    unsigned int zigzag = (static_cast<unsigned int>(diff) << 1) ^ static_cast<unsigned int>(diff >> 31);
+    return zigzag << 1 | (e.getTx() != prevRx ? 1 : 0);
+}
+
+static unsigned int varintSize(unsigned int value) {
+    unsigned int result = 1;
+    while(value >= 0x80) {
+        value >>= 7;
+        result++;
+    }
+    return result;
+}
+
+static void putVarint(PacketWriter& w, unsigned int value) {
+    while(value >= 0x80) {
+        w.put(static_cast<unsigned char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    w.put(static_cast<unsigned char>(value));
+}
+
+static bool getVarint(Packet& pkt, unsigned int& value) {
+    value = 0;
+    for(int shift = 0; shift < 32; shift += 7) {
+        if(pkt.empty()) return false;
+        unsigned char byte;
+        pkt.get(&byte, 1);
+        value |= static_cast<unsigned int>(byte & 0x7f) << shift;
+        if((byte & 0x80) == 0) return true;
+    }
+    return false;
 }
 
 void SchedulePacket::serialize(Packet& pkt) const {
     pkt.putPanHeader(panId);
     header.serialize(pkt);
+    if(header.isCompact()) {
+        serializeCompact(pkt);
+        return;
+    }
+    for(auto e : removed)
+        e.serialize(pkt);
     for(auto e : elements)
         e.serialize(pkt);
 }
@@ -61,25 +133,139 @@ void SchedulePacket::serialize(Packet& pkt) const {
 void SchedulePacket::deserialize(Packet& pkt) {
     pkt.removePanHeader();
     header.deserialize(pkt);
-    auto count = pkt.size() / ScheduleElement::maxSize();
+    removed.clear();
     elements.clear();
+    if(header.isCompact()) {
+        deserializeCompact(pkt);
+        return;
+    }
+    auto count = pkt.size() / ScheduleElement::maxSize();
     elements.reserve(count);
+    // The removed streams of a delta are the first elements, counting from
+    // the first packet of the schedule
+    unsigned int index = header.getCurrentPacket() * getPacketCapacity(header.isDelta());
     for(unsigned int i=0; i < count; i++) {
         ScheduleElement elem;
         elem.deserialize(pkt);
-        elements.push_back(elem);
+        if(header.isDelta() && index++ < header.getRemovedStreams())
+            removed.push_back(elem);
+        else elements.push_back(elem);
+    }
+}
+
+void SchedulePacket::serializeCompact(Packet& pkt) const {
+    // Groups vary in size, reserve the space for all of them at once
+    auto w = pkt.reserve(size() - panHeaderSize - header.size());
+    for(auto& e : removed) {
+        w.put(e.getStreamId());
+        w.put(removedStreamKind);
+    }
+    for(unsigned int i = 0; i < elements.size();) {
+        StreamId id = elements[i].getStreamId();
+        w.put(id);
+        if(isInfoElement(elements[i])) {
+            w.put(infoElementKind);
+            w.put(static_cast<unsigned char>(elements[i].getOffset()));
+            i++;
+            continue;
+        }
+        unsigned char n = groupLength(elements, i);
+        w.put(n);
+        w.put(elements[i].getParams());
+        unsigned int prevOffset = 0;
+        unsigned char prevRx = id.src;
+        for(unsigned int j = i; j < i + n; j++) {
+            auto& e = elements[j];
+            unsigned int value = compactElement(e, prevOffset, prevRx);
+            putVarint(w, value);
+            if(value & 1) w.put(e.getTx());
+            w.put(e.getRx());
+            prevOffset = e.getOffset();
+            prevRx = e.getRx();
+        }
+        i += n;
+    }
+}
+
+void SchedulePacket::deserializeCompact(Packet& pkt) {
+    // Parsing stops at the first truncated group
+    while(pkt.size() >= sizeof(StreamId) + 1) {
+        StreamId id;
+        unsigned char kind;
+        pkt.get(&id, sizeof(StreamId));
+        pkt.get(&kind, 1);
+        if(kind == removedStreamKind) {
+            removed.push_back(ScheduleElement(id, StreamParameters(), id.src, id.dst, 0));
+            continue;
+        }
+        if(kind == infoElementKind) {
+            if(pkt.empty()) return;
+            unsigned char type;
+            pkt.get(&type, 1);
+            elements.push_back(InfoElement(id, static_cast<InfoType>(type)));
+            continue;
+        }
+        if(pkt.size() < sizeof(StreamParameters)) return;
+        StreamParameters params;
+        pkt.get(&params, sizeof(StreamParameters));
+        unsigned int prevOffset = 0;
+        unsigned char prevRx = id.src;
+        for(int j = 0; j < kind; j++) {
+            unsigned int value;
+            if(getVarint(pkt, value) == false) return;
+            unsigned char tx = prevRx, rx;
+            if(value & 1) {
+                if(pkt.empty()) return;
+                pkt.get(&tx, 1);
+            }
+            if(pkt.empty()) return;
+            pkt.get(&rx, 1);
+            unsigned int zigzag = value >> 1;
+            int diff = static_cast<int>(zigzag >> 1) ^ -static_cast<int>(zigzag & 1);
+            unsigned int offset = prevOffset + diff;
+            elements.push_back(ScheduleElement(id, params, tx, rx, offset));
+            prevOffset = offset;
+            prevRx = rx;
+        }
     }
 }
 
 std::size_t SchedulePacket::size() const {
-    return panHeaderSize +
-        header.size() +
-        elements.size();
+    std::size_t result = panHeaderSize + header.size();
+    if(header.isCompact() == false)
+        return result + (removed.size() + elements.size()) * ScheduleElement::maxSize();
+    result += removed.size() * (sizeof(StreamId) + 1);
+    for(unsigned int i = 0; i < elements.size();) {
+        if(isInfoElement(elements[i])) {
+            result += sizeof(StreamId) + 2;
+            i++;
+            continue;
+        }
+        unsigned int n = groupLength(elements, i);
+        result += sizeof(StreamId) + 1 + sizeof(StreamParameters);
+        unsigned int prevOffset = 0;
+        unsigned char prevRx = elements[i].getSrc();
+        for(unsigned int j = i; j < i + n; j++) {
+            unsigned int value = compactElement(elements[j], prevOffset, prevRx);
+            result += varintSize(value) + (value & 1) + 1;
+            prevOffset = elements[j].getOffset();
+            prevRx = elements[j].getRx();
+        }
+        i += n;
+    }
+    return result;
 }
 
-unsigned int SchedulePacket::getPacketCapacity() {
-    return (MediumAccessController::maxControlPktSize - (panHeaderSize + ScheduleHeader::maxSize()))
+unsigned int SchedulePacket::getPacketCapacity(bool delta) {
+    return (MediumAccessController::maxControlPktSize - (panHeaderSize + ScheduleHeader::maxSize(delta)))
         / ScheduleElement::maxSize();
 }
 
+unsigned int SchedulePacket::getInfoCapacity() const {
+    unsigned int used = size();
+    if(used >= MediumAccessController::maxControlPktSize) return 0;
+    unsigned int infoSize = header.isCompact() ? sizeof(StreamId) + 2 : ScheduleElement::maxSize();
+    return (MediumAccessController::maxControlPktSize - used) / infoSize;
+}
+
 } /* namespace mxnet */
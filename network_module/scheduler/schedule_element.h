@@ -57,6 +57,13 @@ struct ScheduleHeaderPkt {
     unsigned int activationTile:32;
     unsigned int scheduleTiles:16;
     unsigned int repetition:8;
+    unsigned int flags:8;
+} __attribute__((packed));
+
+/* Follows ScheduleHeaderPkt only in the headers of delta schedules */
+struct ScheduleDeltaPkt {
+    unsigned int baseScheduleID:32;
+    unsigned int removedStreams:16;
 } __attribute__((packed));
 
 struct ScheduleElementPkt {
@@ -69,11 +76,14 @@ class ScheduleHeader : public SerializableMessage {
 public:
     ScheduleHeader() {
         std::memset(&header, 0, sizeof(ScheduleHeaderPkt));
+        std::memset(&delta, 0, sizeof(ScheduleDeltaPkt));
     }
 
     ScheduleHeader(unsigned int totalPacket, unsigned int currentPacket,
                    unsigned long scheduleID=0, unsigned long activationTile=0,
-                   unsigned int scheduleTiles=0, unsigned char repetition=0)
+                   unsigned int scheduleTiles=0, unsigned char repetition=0,
+                   unsigned long baseScheduleID=0, unsigned int removedStreams=0,
+                   bool compact=false)
     {
         header.totalPacket = totalPacket;
         header.currentPacket = currentPacket;
@@ -81,12 +91,17 @@ public:
         header.activationTile = activationTile;
         header.scheduleTiles = scheduleTiles;
         header.repetition = repetition;
+        header.flags = (compact ? compactFlag : 0) | (baseScheduleID != 0 ? deltaFlag : 0);
+        delta.baseScheduleID = baseScheduleID;
+        delta.removedStreams = removedStreams;
     }
 
     void serialize(Packet& pkt) const override;
     void deserialize(Packet& pkt) override;
-    std::size_t size() const override { return maxSize(); }
-    static std::size_t maxSize() { return sizeof(ScheduleHeaderPkt); }
+    std::size_t size() const override { return maxSize(isDelta()); }
+    static std::size_t maxSize(bool delta) {
+        return sizeof(ScheduleHeaderPkt) + (delta ? sizeof(ScheduleDeltaPkt) : 0);
+    }
     unsigned int getTotalPacket() const { return header.totalPacket; }
     bool isSchedulePacket() const { return header.totalPacket>0; }
     unsigned int getCurrentPacket() const { return header.currentPacket; }
@@ -95,6 +110,14 @@ public:
     unsigned long getActivationTile() const { return header.activationTile; }
     unsigned int getScheduleTiles() const { return header.scheduleTiles; }
     unsigned char getRepetition() const { return header.repetition; }
+    /* A delta schedule only carries the differences from the schedule with
+     * ID baseScheduleID: the first removedStreams elements are one per stream
+     * whose elements must be removed, the following ones are to be added */
+    bool isDelta() const { return (header.flags & deltaFlag) != 0; }
+    unsigned long getBaseScheduleID() const { return delta.baseScheduleID; }
+    unsigned int getRemovedStreams() const { return delta.removedStreams; }
+    /* If set, the elements are encoded grouped by stream, see SchedulePacket */
+    bool isCompact() const { return (header.flags & compactFlag) != 0; }
     void incrementPacketCounter() { header.currentPacket++; }
     void incrementRepetition() {
             header.repetition++;
@@ -104,7 +127,11 @@ public:
     void setActivationTile(unsigned long tilenum) { header.activationTile = tilenum; }
 
 private:
+    static const unsigned char compactFlag = 1;
+    static const unsigned char deltaFlag = 2; ///< ScheduleDeltaPkt follows
+
     ScheduleHeaderPkt header;
+    ScheduleDeltaPkt delta;
 };
 
 class ScheduleElement : public SerializableMessage {
@@ -124,6 +151,15 @@ public:
         content.offset = off;
     }
 
+    // Constructor used when parsing a SchedulePacket
+    ScheduleElement(StreamId id, StreamParameters params,
+                    unsigned char tx, unsigned char rx, unsigned int off) :
+        id(id), params(params) {
+        content.tx = tx;
+        content.rx = rx;
+        content.offset = off;
+    }
+
     // Constructor for multi-hop stream
     ScheduleElement(MasterStreamInfo stream,
                     unsigned char tx,
@@ -191,6 +227,17 @@ public:
     InfoType getType() const { return static_cast<InfoType>(content.offset); }
 };
 
+/**
+ * A schedule downlink packet. If the header is compact, the elements are
+ * encoded as a sequence of groups starting with the StreamId and a kind byte:
+ * - kind 0: a stream removed by a delta schedule, nothing follows
+ * - kind 255: an info element, followed by the InfoType byte
+ * - otherwise kind is the number of consecutive elements of the stream that
+ *   follow the StreamParameters. Each one is a varint with the zigzag encoded
+ *   offset difference from the previous one shifted left by one, whose lsb
+ *   is set if tx differs from the previous rx and so follows as a byte, and
+ *   then the rx byte. The first element starts from offset 0 and the src
+ */
 class SchedulePacket : public SerializableMessage {
 public:
     SchedulePacket(unsigned short panId) : panId(panId) {}
@@ -200,21 +247,39 @@ public:
     
     std::size_t size() const override;
     
-    static unsigned int getPacketCapacity();
+    /**
+     * \param delta true for the packets of a delta schedule, that have a
+     * larger header
+     * \return the number of elements that fit in a packet if not compact
+     */
+    static unsigned int getPacketCapacity(bool delta);
+
+    /**
+     * \return the number of info elements that can still be added
+     */
+    unsigned int getInfoCapacity() const;
     
     ScheduleHeader getHeader() const { return header; }
     std::vector<ScheduleElement> getElements() const { return elements; }
+    /* Elements of the streams removed by a delta schedule, only the StreamId
+     * is meaningful */
+    std::vector<ScheduleElement> getRemovedStreams() const { return removed; }
     void popElements(int n) {
         for(int i = 0; i < n; i++)
             elements.pop_back();
     }
     void setHeader(ScheduleHeader& newHeader) { header = newHeader; }
     void putElement(ScheduleElement& el) { elements.push_back(el); }
+    void putRemovedStream(ScheduleElement& el) { removed.push_back(el); }
     void putInfoElement(InfoElement& el) { elements.push_back(static_cast<ScheduleElement>(el)); }
 
 private:
+    void serializeCompact(Packet& pkt) const;
+    void deserializeCompact(Packet& pkt);
+
     unsigned short panId;
     ScheduleHeader header;
+    std::vector<ScheduleElement> removed;
     std::vector<ScheduleElement> elements;
 };
 
@@ -0,0 +1,96 @@
+/***************************************************************************
+ *   Copyright (C) 2019 by Federico Terraneo                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   As a special exception, if other files instantiate templates or use   *
+ *   macros or inline functions from this file, or you compile this file   *
+ *   and link it with other works to produce a work based on this file,    *
+ *   this file does not by itself cause the resulting work to be covered   *
+ *   by the GNU General Public License. However the source code for this   *
+ *   file must still be made available in accordance with the GNU General  *
+ *   Public License. This exception does not invalidate any other reasons  *
+ *   why a work based on this file might be covered by the GNU General     *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ ***************************************************************************/
+
+
+#include "slot_calibration.h"
+#include "mac_context.h"
+#include "tdmh.h"
+#include "uplink_phase/uplink_phase.h"
+#include "util/debug_settings.h"
+#include <algorithm>
+
+namespace mxnet {
+
+/**
+ * \param measured measured processing time, or negative if never measured
+ * \param marginPercent margin to add
+ * \param fallback value to use if the time was never measured
+ */
+static int withMargin(long long measured, int marginPercent, int fallback)
+{
+    if(measured < 0) return fallback;
+    return measured + measured * marginPercent / 100;
+}
+
+SlotCalibration::SlotCalibration()
+{
+    std::fill(worstCase, worstCase + NUM_MEASURES, -1);
+    std::fill(count, count + NUM_MEASURES, 0);
+}
+
+SlotTimings SlotCalibration::recommended(const NetworkConfiguration& config,
+                                         int marginPercent) const
+{
+    auto current = config.getSlotTimings();
+
+    // The radio time of the packet the data slots were sized for has already
+    // been subtracted by the MAC, see DataPhase::getLastSlotPacketSize()
+    long long data = -1;
+    if(count[DATA_SLOT] > 0)
+        data = std::max(0LL, worstCase[DATA_SLOT]);
+
+    // The uplink slot is divided among the uplink packets, each followed by
+    // the transmission interval
+    long long uplink = -1;
+    if(count[UPLINK_SLOT] > 0)
+    {
+        long long packets = config.getNumUplinkPackets();
+        uplink = std::max(0LL, (worstCase[UPLINK_SLOT] + packets - 1) / packets
+                                - UplinkPhase::transmissionInterval);
+    }
+
+    long long downlink = -1;
+    if(count[DOWNLINK_REBROADCAST] > 0)
+        downlink = std::max(0LL, worstCase[DOWNLINK_REBROADCAST]);
+
+    return SlotTimings(withMargin(data, marginPercent, current.getDataProcessing()),
+        withMargin(uplink, marginPercent, current.getUplinkPacketProcessing()),
+        withMargin(downlink, marginPercent, current.getDownlinkRebroadcastProcessing()));
+}
+
+void SlotCalibration::print(const NetworkConfiguration& config) const
+{
+    auto r = recommended(config);
+    print_dbg("[C] data=%lld (%u) uplink=%lld (%u) rebroadcast=%lld (%u)\n",
+              worstCase[DATA_SLOT], count[DATA_SLOT],
+              worstCase[UPLINK_SLOT], count[UPLINK_SLOT],
+              worstCase[DOWNLINK_REBROADCAST], count[DOWNLINK_REBROADCAST]);
+    print_dbg("[C] SlotTimings(%d,%d,%d)\n", r.getDataProcessing(),
+              r.getUplinkPacketProcessing(), r.getDownlinkRebroadcastProcessing());
+}
+
+} // namespace mxnet
@@ -0,0 +1,107 @@
+/***************************************************************************
+ *   Copyright (C) 2019 by Federico Terraneo                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   As a special exception, if other files instantiate templates or use   *
+ *   macros or inline functions from this file, or you compile this file   *
+ *   and link it with other works to produce a work based on this file,    *
+ *   this file does not by itself cause the resulting work to be covered   *
+ *   by the GNU General Public License. However the source code for this   *
+ *   file must still be made available in accordance with the GNU General  *
+ *   Public License. This exception does not invalidate any other reasons  *
+ *   why a work based on this file might be covered by the GNU General     *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ ***************************************************************************/
+
+#pragma once
+
+#include "network_configuration.h"
+
+namespace mxnet {
+
+/**
+ * SlotCalibration collects the worst-case processing times of the MAC phases
+ * measured on the target during a run, and computes from them the SlotTimings
+ * to be passed to the NetworkConfiguration to shrink the slots.
+ *
+ * Measurements are only collected if ENABLE_SLOT_CALIBRATION is true.
+ * As each node only measures its own processing times, the recommended
+ * SlotTimings of all the nodes have to be merged taking the maximum.
+ */
+class SlotCalibration
+{
+public:
+    enum Measure
+    {
+        DATA_SLOT,            ///< From data slot start to the end of the phase,
+                              ///< minus the radio time the slots were sized for
+        UPLINK_SLOT,          ///< From uplink slot start to the end of the phase
+        DOWNLINK_REBROADCAST, ///< From end of a schedule packet to its rebroadcast
+        NUM_MEASURES
+    };
+
+    SlotCalibration();
+
+    /**
+     * Record a measurement, only the worst case is kept
+     * \param m which time was measured
+     * \param value measured time in nanoseconds
+     */
+    void record(Measure m, long long value)
+    {
+        if(value > worstCase[m]) worstCase[m] = value;
+        count[m]++;
+    }
+
+    /**
+     * \param timestamp packet timestamp, taken at the end of the SFD
+     * \param payloadBytes size of the packet
+     * \return the time when the radio completes the reception of the packet,
+     * that is after the length byte, the payload and the CRC
+     */
+    static long long receptionEnd(long long timestamp, int payloadBytes)
+    {
+        const long long byteTime = 32000;
+        return timestamp + (payloadBytes + 3) * byteTime;
+    }
+
+    /**
+     * \param m which time was measured
+     * \return the worst case time in nanoseconds, or -1 if never measured
+     */
+    long long getWorstCase(Measure m) const { return worstCase[m]; }
+
+    /**
+     * \param config the configuration the measurements were taken with
+     * \param marginPercent margin added to the measured processing times
+     * \return the recommended processing times. Times that were never measured
+     * are taken from the configuration
+     */
+    SlotTimings recommended(const NetworkConfiguration& config,
+                            int marginPercent = defaultMarginPercent) const;
+
+    /**
+     * Print the measured worst case times and the recommended processing times
+     */
+    void print(const NetworkConfiguration& config) const;
+
+    static const int defaultMarginPercent = 20;
+
+private:
+    long long worstCase[NUM_MEASURES];
+    unsigned int count[NUM_MEASURES];
+};
+
+} // namespace mxnet
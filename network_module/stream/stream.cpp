@@ -32,6 +32,20 @@
 
 namespace mxnet {
 
+/* The counters in StreamStats are written by a single thread and read by
+ * getStats() from another one, so a relaxed store is enough to update them */
+static inline void statsStore(unsigned int& counter, unsigned int value) {
+    __atomic_store_n(&counter, value, __ATOMIC_RELAXED);
+}
+
+static inline void statsIncrement(unsigned int& counter) {
+    statsStore(counter, counter + 1);
+}
+
+static inline unsigned int statsLoad(unsigned int& counter) {
+    return __atomic_load_n(&counter, __ATOMIC_RELAXED);
+}
+
 int Stream::connect(StreamManager* mgr) {
     // Lock mutex for concurrent access at StreamInfo
     {
@@ -65,6 +79,8 @@ int Stream::write(const void* data, int size) {
 #else
     std::unique_lock<std::mutex> lck(tx_mutex);
 #endif
+    if(nextTxPacketReady == true && info.getStatus() == StreamStatus::ESTABLISHED)
+        statsIncrement(stats.writeBlocks);
     // If we were called twice in a period, wait for the end of the period
     while(nextTxPacketReady == true && info.getStatus() == StreamStatus::ESTABLISHED) {
         tx_cv.wait(lck);
@@ -73,6 +89,10 @@ int Stream::write(const void* data, int size) {
     if(info.getStatus() != StreamStatus::ESTABLISHED) { 
         return -2;
     }
+    // With mini-slots the scheduled slots fit only the negotiated payload
+    if(miniSlots && size > static_cast<int>(info.getParams().getPayloadSize())) {
+        return -1;
+    }
     try {
         StreamId id = info.getStreamId();
         nextTxPacket.clear();
@@ -125,16 +145,23 @@ int Stream::read(void* data, int maxSize) {
         }
     }
     // We did not receive any data this round
+    statsIncrement(stats.readUnderruns);
     return -1;
 }
 
-bool Stream::receivePacket(const Packet& data) {
+bool Stream::receivePacket(const Packet& data, unsigned int slot) {
 #ifdef REDUNDANCY_DEBUG_CHECK
     if(received && rxCount > 0) {
         if(rxPacket != data)
             print_dbg("[E] Redundant Packet mismatch\n");
     }
 #endif
+    // First copy received in this period
+    if(received == false) {
+        if(rxCount > 0)
+            statsIncrement(stats.redundantUsed);
+        updateLatency(slot);
+    }
     // NOTE: we use a duplicated rxPacket to acquire data before locking the mutex
     rxPacket = data;
     received = true;
@@ -150,8 +177,11 @@ bool Stream::sendPacket(Packet& data) {
     // Stream Redundancy logic
     // NOTE: We update the packet before sending it
     // for the first time of the current period.
-    if(txCount == 0)
+    if(txCount == 0) {
         updateTxPacket();
+        if(txPacketReady)
+            statsIncrement(stats.sent);
+    }
     if(++txCount >= redundancyCount)
         txCount = 0;
     // Copy the txPacket to the DataPhase
@@ -463,6 +493,10 @@ bool Stream::updateRxPacket() {
     if(++rxCount >= redundancyCount) {
         // Reset received packet counter
         rxCount = 0;
+        if(received)
+            statsIncrement(stats.received);
+        else
+            statsIncrement(stats.missed);
         {
             // Lock mutex for shared access with application thread
 #ifdef _MIOSIX
@@ -488,6 +522,37 @@ bool Stream::updateRxPacket() {
     return false;
 }
 
+void Stream::updateLatency(unsigned int slot) {
+    if(latencyPeriodSlots == 0)
+        return;
+    // The schedule repeats the stream every period, count the slots from
+    // the first transmission of the source to the end of the current slot
+    unsigned int periodSlot = slot % latencyPeriodSlots;
+    unsigned int latency = (periodSlot + latencyPeriodSlots - latencyTxOffset)
+                           % latencyPeriodSlots + 1;
+    statsStore(stats.latencyLast, latency);
+    if(stats.latencyMin == 0 || latency < stats.latencyMin)
+        statsStore(stats.latencyMin, latency);
+    if(latency > stats.latencyMax)
+        statsStore(stats.latencyMax, latency);
+    statsStore(stats.latencySum, stats.latencySum + latency);
+}
+
+StreamStats Stream::getStats() {
+    StreamStats result;
+    result.sent = statsLoad(stats.sent);
+    result.received = statsLoad(stats.received);
+    result.missed = statsLoad(stats.missed);
+    result.redundantUsed = statsLoad(stats.redundantUsed);
+    result.writeBlocks = statsLoad(stats.writeBlocks);
+    result.readUnderruns = statsLoad(stats.readUnderruns);
+    result.latencyLast = statsLoad(stats.latencyLast);
+    result.latencyMin = statsLoad(stats.latencyMin);
+    result.latencyMax = statsLoad(stats.latencyMax);
+    result.latencySum = statsLoad(stats.latencySum);
+    return result;
+}
+
 void Stream::updateTxPacket() {
     // Lock mutex for shared access with application thread
 #ifdef _MIOSIX
@@ -30,6 +30,8 @@
 #include "../tdmh.h"
 #include "../util/packet.h"
 #include "stream_management_element.h"
+#include "../util/event_log.h"
+#include "../downlink_phase/timesync/networktime.h"
 #include <list>
 #ifdef _MIOSIX
 #include <miosix.h>
@@ -97,7 +99,7 @@ public:
     }
     // TODO: The base class implementation of these functions should throw an error?
     // Used by derived class Stream 
-    virtual bool receivePacket(const Packet& data) { return false; }
+    virtual bool receivePacket(const Packet& data, unsigned int slot) { return false; }
     // Used by derived class Stream
     virtual bool missPacket() { return false; }
     // Used by derived class Stream 
@@ -112,6 +114,8 @@ public:
     virtual void rejectedStream() {}
     // Used by derived class Stream 
     virtual void closedServer(StreamManager* mgr) {}
+    // Used by derived class Stream
+    virtual StreamStats getStats() { return StreamStats(); }
     // Used by derived class Server
     virtual int listen(StreamManager* mgr) {
         //This method should never be called on the base class
@@ -156,6 +160,8 @@ protected:
     // Change the status saved in StreamInfo
     void setStatus(StreamStatus status) {
         info.setStatus(status);
+        EventLog::record(EventType::STREAM_STATE, NetworkTime::now().get(),
+                         info.getKey(), static_cast<int>(status));
         // NOTE: Reset the sme and fail timeouts after state change
         resetTimeouts();
     }
@@ -194,7 +200,8 @@ class Stream : public Endpoint {
 public:
     Stream(const NetworkConfiguration& config,
            int fd, StreamInfo info) : Endpoint(config, fd, info),
-                                      panId(config.getPanId()) {
+                                      panId(config.getPanId()),
+                                      miniSlots(config.getMiniSlotPayloadSize() != 0) {
         updateRedundancy();
     }
 
@@ -209,8 +216,9 @@ public:
     int read(void* data, int maxSize) override;
 
     // Called by StreamManager, to put data to recvBuffer
+    // slot is the index of the current slot in the schedule
     // Return true at the end of each period
-    bool receivePacket(const Packet& data) override;
+    bool receivePacket(const Packet& data, unsigned int slot) override;
 
     // Called by StreamManager, when we missed an inbound packet
     // Return true if we have data to send
@@ -251,6 +259,16 @@ public:
         rxCount = 0;
     }
 
+    // Called by StreamManager after applying a new schedule, sets the first
+    // slot in which the source transmits, used to compute the latency
+    void setLatencyReference(unsigned int txOffset, unsigned int periodSlots) {
+        latencyTxOffset = txOffset;
+        latencyPeriodSlots = periodSlots;
+    }
+
+    // Called by StreamManager, returns a copy of the stream counters
+    StreamStats getStats() override;
+
     // Called by StreamManager when the Timesync desynchronizes, used to
     // close the stream system-side in certain conditions
     // Returns true if the Stream class can be deleted
@@ -258,6 +276,8 @@ public:
 
 private:
     const unsigned short panId;
+    /* True if the data slots are sized for the stream payload */
+    const bool miniSlots;
 
     Packet txPacket;
     Packet rxPacket;
@@ -276,6 +296,11 @@ private:
     bool nextTxPacketReady = false;
     Packet rxPacketShared;
     Packet nextTxPacket;
+    /* Counters, each one written by a single thread without locking */
+    StreamStats stats;
+    /* Latency reference from the schedule, latencyPeriodSlots is 0 if unknown */
+    unsigned int latencyTxOffset = 0;
+    unsigned int latencyPeriodSlots = 0;
 
     /* Thread synchronization */
 #ifdef _MIOSIX
@@ -303,6 +328,8 @@ private:
     // Used to update internal variables every stream period
     // Return true at the end of each period
     bool updateRxPacket();
+    // Called by Stream::receivePacket(), updates the latency counters
+    void updateLatency(unsigned int slot);
     // Called by Stream::sendPacket() on the first period, and
     // at the end of every period.
     // Used to update txPacket, the packet being sent
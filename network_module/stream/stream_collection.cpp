@@ -121,6 +121,7 @@ void StreamCollection::receiveSMEs(UpdatableQueue<SMEKey,
         if(sme.getType() == SMEType::RESEND_SCHEDULE)
         {
             resend_flag = true;
+            resendNodes.insert(sme.getSrc());
             if(SCHEDULER_SUMMARY_DBG)
                 print_dbg("[SC] schedule resend due to RESEND_SCHEDULE sme from (%d)\n",
                             sme.getSrc());
@@ -33,6 +33,7 @@
 #include "../scheduler/schedule_element.h"
 #include "../util/updatable_queue.h"
 #include <map>
+#include <set>
 #include <list>
 #ifdef _MIOSIX
 #include <miosix.h>
@@ -161,6 +162,20 @@ public:
      * pops a number of Info elements from the Queue
      */
     std::vector<InfoElement> dequeueInfo(unsigned int num);
+    /**
+     * @return the number of distinct nodes that sent a RESEND_SCHEDULE since
+     * the last call, used to adapt the number of schedule repetitions
+     */
+    unsigned int takeResendRequests() {
+#ifdef _MIOSIX
+        miosix::Lock<miosix::Mutex> lck(coll_mutex);
+#else
+        std::unique_lock<std::mutex> lck(coll_mutex);
+#endif
+        unsigned int result = resendNodes.size();
+        resendNodes.clear();
+        return result;
+    }
     /**
      * @return true if the stream list was modified since last time the flag was cleared 
      */
@@ -242,6 +257,8 @@ private:
     bool removed_flag = false;
     bool added_flag = false;
     bool resend_flag = false;
+    /* Nodes that sent a RESEND_SCHEDULE, cleared by takeResendRequests() */
+    std::set<unsigned char> resendNodes;
 
     /* Mutex to protect concurrect access at collection and infoQueue
      * from the TDMH thread and the scheduler thread */
@@ -32,20 +32,22 @@
 namespace mxnet {
 
 void StreamManagementElement::serialize(Packet& pkt) const {
-    pkt.put(&id, sizeof(StreamId));
-    pkt.put(&parameters, sizeof(StreamParameters));
-    pkt.put(&type, sizeof(SMEType));
+    auto w = pkt.reserve(maxSize());
+    w.put(id);
+    w.put(parameters);
+    w.put(type);
 #ifdef WITH_SME_SEQNO
-    pkt.put(&seqNo, sizeof(seqNo));
+    w.put(seqNo);
 #endif //WITH_SME_SEQNO
 }
 
 void StreamManagementElement::deserialize(Packet& pkt) {
-    pkt.get(&id, sizeof(StreamId));
-    pkt.get(&parameters, sizeof(StreamParameters));
-    pkt.get(&type, sizeof(SMEType));
+    auto r = pkt.consume(maxSize());
+    r.get(id);
+    r.get(parameters);
+    r.get(type);
 #ifdef WITH_SME_SEQNO
-    pkt.get(&seqNo, sizeof(seqNo));
+    r.get(seqNo);
 #endif //WITH_SME_SEQNO
 }
 
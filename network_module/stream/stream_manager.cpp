@@ -95,6 +95,13 @@ int StreamManager::connect(unsigned char dst, unsigned char dstPort, StreamParam
     // NOTE: Make sure that stream enqueues a CONNECT SME
     int error = stream->connect(this);
     if(error != 0) {
+        // Lock map_mutex to access the shared Stream map, the MAC may be
+        // iterating over it in desync(), that also wakes us up
+#ifdef _MIOSIX
+        miosix::Lock<miosix::FastMutex> lck(map_mutex);
+#else
+        std::unique_lock<std::mutex> lck(map_mutex);
+#endif
         removeStream(streamId);
         return -1;
     }
@@ -150,6 +157,22 @@ StreamInfo StreamManager::getInfo(int fd) {
     return endpoint->getInfo();
 }
 
+StreamStats StreamManager::getStats(int fd) {
+    REF_PTR_EP endpoint;
+    {
+        // Lock map_mutex to access the shared Stream/Server map
+#ifdef _MIOSIX
+        miosix::Lock<miosix::FastMutex> lck(map_mutex);
+#else
+        std::unique_lock<std::mutex> lck(map_mutex);
+#endif
+        auto it = fdt.find(fd);
+        if(it == fdt.end()) return StreamStats();
+        endpoint = it->second;
+    }
+    return endpoint->getStats();
+}
+
 void StreamManager::close(int fd) {
     REF_PTR_EP endpoint;
     {
@@ -205,6 +228,12 @@ int StreamManager::listen(unsigned char port, StreamParameters params) {
     // Make the server wait for an info element confirming LISTEN status
     int error = server->listen(this);
     if(error != 0) {
+        // Lock map_mutex to access the shared Server map
+#ifdef _MIOSIX
+        miosix::Lock<miosix::FastMutex> lck(map_mutex);
+#else
+        std::unique_lock<std::mutex> lck(map_mutex);
+#endif
         unsigned char port = serverId.dstPort;
         removeServer(port);
         return -1;
@@ -260,7 +289,7 @@ void StreamManager::periodicUpdate() {
     }
 }
 
-bool StreamManager::receivePacket(StreamId id, const Packet& data) {
+bool StreamManager::receivePacket(StreamId id, const Packet& data, unsigned int slot) {
     REF_PTR_STREAM stream;
     {
         // Lock map_mutex to access the shared Stream map
@@ -273,7 +302,7 @@ bool StreamManager::receivePacket(StreamId id, const Packet& data) {
         if(streamit == streams.end()) return false;
         stream = streamit->second;
     }
-    return stream->receivePacket(data);
+    return stream->receivePacket(data, slot);
 }
 
 bool StreamManager::missPacket(StreamId id) {
@@ -309,7 +338,8 @@ bool StreamManager::sendPacket(StreamId id, Packet& data) {
     return stream->sendPacket(data);
 }
 
-void StreamManager::applySchedule(const std::vector<ScheduleElement>& schedule) {
+void StreamManager::applySchedule(const std::vector<ScheduleElement>& schedule,
+                                  unsigned int slotsInTile) {
     // Lock map_mutex to access the shared Stream/Server map
 #ifdef _MIOSIX
     miosix::Lock<miosix::FastMutex> lck(map_mutex);
@@ -323,12 +353,21 @@ void StreamManager::applySchedule(const std::vector<ScheduleElement>& schedule)
     for (auto it=streams.begin(); it!=streams.end(); ++it)
         removedStreams.push_back(it->first);
 
+    // First slot of the period in which the source of each stream
+    // directed to us transmits, used as reference for the latency
+    std::map<StreamId, unsigned int> firstTxOffset;
+
     // Iterate over new schedule
     for(auto& element : schedule) {
         StreamId streamId = element.getStreamId();
         // NOTE: Ignore streams of which we are not source or destination 
         if(streamId.src != myId && streamId.dst != myId)
             continue;
+        if(streamId.dst == myId && element.getTx() == streamId.src) {
+            auto it = firstTxOffset.find(streamId);
+            if(it == firstTxOffset.end() || element.getOffset() < it->second)
+                firstTxOffset[streamId] = element.getOffset();
+        }
         auto streamit = streams.find(streamId);
         // If stream in schedule is present in map, call addedStream()
         if(streamit != streams.end()) {
@@ -372,6 +411,12 @@ void StreamManager::applySchedule(const std::vector<ScheduleElement>& schedule)
             }
         }
     }
+    for(auto& offset : firstTxOffset) {
+        auto streamit = streams.find(offset.first);
+        if(streamit == streams.end()) continue;
+        auto period = toInt(streamit->second->getInfo().getPeriod());
+        streamit->second->setLatencyReference(offset.second, period * slotsInTile);
+    }
     // If stream present in map and not in schedule, call removedStream()
     for(auto& streamId : removedStreams) {
         // If return value is true, we can delete the Stream class
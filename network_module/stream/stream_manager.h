@@ -100,6 +100,9 @@ public:
     // Returns a StreamInfo, containing stream status and parameters
     StreamInfo getInfo(int fd);
 
+    // Returns the counters of a Stream, all zero if fd is not a Stream
+    StreamStats getStats(int fd);
+
     // Closes a Stream or Server on the application side, the Stream/Server
     // is kept in the StreamManager until the master acknowlede the closing.
     // This method enqueues a CLOSED SME
@@ -121,7 +124,8 @@ public:
     void periodicUpdate();
 
     // Used by the DataPhase class to put received data in the right buffer
-    bool receivePacket(StreamId id, const Packet& data);
+    // slot is the index of the current slot in the schedule
+    bool receivePacket(StreamId id, const Packet& data, unsigned int slot);
 
     // Used by the DataPhase class when an incoming packet is missed
     bool missPacket(StreamId id);
@@ -131,7 +135,8 @@ public:
     bool sendPacket(StreamId id, Packet& data);
 
     // Used by the DataPhase to apply a received schedule
-    void applySchedule(const std::vector<ScheduleElement>& schedule);
+    void applySchedule(const std::vector<ScheduleElement>& schedule,
+                       unsigned int slotsInTile);
 
     // Used by the DataPhase to apply received info elements
     void applyInfoElements(const std::vector<InfoElement>& infos);
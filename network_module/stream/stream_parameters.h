@@ -28,6 +28,7 @@
 #pragma once
 
 #include <cstring>
+#include <cstdint>
 
 namespace mxnet {
 
@@ -270,6 +271,29 @@ protected:
     StreamStatus status;
 };
 
+/**
+ *  StreamStats contains the counters of a Stream, returned by getStats().
+ *  The counters wrap around at 2^32, compute the difference between two
+ *  calls to get the statistics of a time interval. Being updated without
+ *  locks, the counters of a single call may be off by one period
+ *  with respect to each other.
+ */
+struct StreamStats {
+    unsigned int sent = 0;          // Packets sent by the source, one per period
+    unsigned int received = 0;      // Periods in which at least a copy was received
+    unsigned int missed = 0;        // Periods in which all the copies were missed
+    unsigned int redundantUsed = 0; // Periods in which the first copy was missed
+                                    // but a redundant one was received
+    unsigned int writeBlocks = 0;   // Calls to write() that waited for the next period
+    unsigned int readUnderruns = 0; // Calls to read() that found no data
+    // End-to-end latency in slots, from the start of the first transmission
+    // at the source to the end of the slot of the first received copy
+    unsigned int latencyLast = 0;
+    unsigned int latencyMin = 0;
+    unsigned int latencyMax = 0;
+    unsigned int latencySum = 0;    // Sum over the received packets, for the average
+};
+
 /**
  *  MasterStreamInfo is used to save the status of a Stream internally to TDMH
  */
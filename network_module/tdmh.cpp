@@ -71,6 +71,13 @@ StreamInfo getInfo(int fd) {
     return streamManager->getInfo(fd);
 }
 
+StreamStats getStats(int fd) {
+    StreamManager* streamManager = getStreamManager();
+    if(streamManager == nullptr)
+        return StreamStats();
+    return streamManager->getStats(fd);
+}
+
 void close(int fd) {
     StreamManager* streamManager = getStreamManager();
     if(streamManager != nullptr)
@@ -52,6 +52,9 @@ int read(int fd, void* data, int maxSize);
 // Returns a StreamInfo, containing stream status and parameters
 StreamInfo getInfo(int fd);
 
+// Returns the packet, latency and buffer counters of a Stream
+StreamStats getStats(int fd);
+
 // Closes a Stream or Server on the application side, the Stream/Server
 // is kept in the StreamManager until the master acknowlede the closing.
 // This method enqueues a CLOSED SME
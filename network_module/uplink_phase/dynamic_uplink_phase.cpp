@@ -40,6 +40,8 @@ namespace mxnet {
 void DynamicUplinkPhase::execute(long long slotStart)
 {
     auto currentNode = getAndUpdateCurrentNode();
+    // Slot owner unknown, stay silent to avoid colliding with its transmission
+    if (currentNode == noNode) return;
     
     if (ENABLE_UPLINK_DYN_VERB_DBG)
          print_dbg("[U] N=%u NT=%lld\n", currentNode, NetworkTime::fromLocalTime(slotStart).get());
@@ -57,13 +59,14 @@ void DynamicUplinkPhase::sendMyUplink(long long slotStart)
         SendUplinkMessage message(ctx.getNetworkConfig(), ctx.getHop(),
                                   myNeighborTable.isBadAssignee(), ctx.getNetworkId(), //NOTE: why the network id?
                                   myNeighborTable.getMyTopologyElement(),
-                                  0, 0);
+                                  topologyQueue, 0, 0, 0);
         if(ENABLE_UPLINK_DYN_INFO_DBG)
             print_dbg("[U] N=%u -> @%llu\n", ctx.getNetworkId(), NetworkTime::fromLocalTime(slotStart).get());
 
         ctx.configureTransceiver(ctx.getTransceiverConfig());
         message.send(ctx,slotStart);
         ctx.transceiverIdle();
+        ctx.getMACTrace().event(MACTraceEvent::UPLINK_SEND, StreamId(), myId);
         if(ENABLE_UPLINK_DBG)
             print_dbg("[U] No predecessor\n");
     
@@ -82,7 +85,8 @@ void DynamicUplinkPhase::sendMyUplink(long long slotStart)
                                   myNeighborTable.isBadAssignee(),
                                   myNeighborTable.getBestPredecessor(),
                                   myNeighborTable.getMyTopologyElement(),
-                                  topologyQueue.size(), smeQueue.size());
+                                  topologyQueue, topologyQueue.size(), smeQueue.size(),
+                                  getSyncWindowReport());
         if(ENABLE_UPLINK_DBG) {
             if( myNeighborTable.bestPredecessorIsBad() ) {
                 print_dbg("[U] Assignee chosen is bad\n");
@@ -96,9 +100,10 @@ void DynamicUplinkPhase::sendMyUplink(long long slotStart)
             {
                 message.serializeTopologiesAndSMEs(topologyQueue,smeQueue);
                 message.send(ctx,slotStart);
-                slotStart += packetArrivalAndProcessingTime + transmissionInterval;
+                slotStart += getPacketInterval(ctx.getNetworkConfig());
             }
         ctx.transceiverIdle();
+        ctx.getMACTrace().event(MACTraceEvent::UPLINK_SEND, StreamId(), myId);
         if(ENABLE_UPLINK_DBG){
             message.printHeader();
         }
@@ -108,4 +113,13 @@ void DynamicUplinkPhase::sendMyUplink(long long slotStart)
     }
 }
 
+unsigned short DynamicUplinkPhase::getSyncWindowReport()
+{
+    if(ctx.getNetworkConfig().getAdaptiveClockSync() == false) return 0;
+    // NOTE: 0 means no report, so the window is reported as at least 1us
+    unsigned int window = ctx.getTimesync()->getReceiverWindow() / 1000;
+    window = std::max(1u, std::min<unsigned int>(window, std::numeric_limits<unsigned short>::max()));
+    return std::max<unsigned int>(window, takeSyncWindowReport());
+}
+
 } // namespace mxnet
@@ -56,6 +56,9 @@ public:
     void resync() override {
         // Base class status
         nextNode = nodesCount - 1;
+        uplinkCounter = 0;
+        liveNodesKnown = false;
+        syncWindowReport = 0;
         // Derived class status
         topologyQueue.clear();
         smeQueue.clear();
@@ -75,6 +78,12 @@ public:
     void sendMyUplink(long long slotStart);
 
 private:
+    /**
+     * \return the sync window report to send, the largest between the
+     * receiver window of this node and the ones reported by the nodes having
+     * this node as assignee, or 0 if the adaptive clock sync is disabled
+     */
+    unsigned short getSyncWindowReport();
 };
 
 } // namespace mxnet
@@ -29,7 +29,11 @@
 #include "master_uplink_phase.h"
 #include "uplink_message.h"
 #include "../util/debug_settings.h"
+#include "../util/event_log.h"
+#include "../scheduler/schedule_capture.h"
 #include <limits>
+#include <algorithm>
+#include <iterator>
 
 using namespace miosix;
 
@@ -45,12 +49,16 @@ void MasterUplinkPhase::execute(long long slotStart)
     if (currentNode == myId) sendMyUplink(slotStart);
     else receiveUplink(slotStart, currentNode);
 
+    unsigned int tile = ScheduleCapture::enabled() ? ctx.getCurrentTile(slotStart) : 0;
     // Consume elements from the topology queue
+    ScheduleCapture::topologies(tile, topologyQueue);
     topology.handleTopologies(topologyQueue);
     // Enqueue SMEs produced by the Master node itself
     streamMgr->dequeueSMEs(smeQueue);
     // Consume elements from the SME queue
+    ScheduleCapture::smes(tile, smeQueue);
     streamColl->receiveSMEs(smeQueue);
+    if(EventLog::enabled()) logTopology(slotStart);
     
     #ifndef _MIOSIX
     if(ENABLE_TOPOLOGY_INFO_DBG)
@@ -66,17 +74,52 @@ void MasterUplinkPhase::execute(long long slotStart)
     #endif
 }
 
+void MasterUplinkPhase::logTopology(long long slotStart)
+{
+    auto edges = topology.getGraph().getEdges();
+    for(auto& e : edges) if(e.first > e.second) std::swap(e.first, e.second);
+    std::sort(edges.begin(), edges.end());
+    std::vector<std::pair<unsigned char, unsigned char>> up, down;
+    std::set_difference(edges.begin(), edges.end(), loggedTopology.begin(),
+                        loggedTopology.end(), std::back_inserter(up));
+    std::set_difference(loggedTopology.begin(), loggedTopology.end(), edges.begin(),
+                        edges.end(), std::back_inserter(down));
+    long long nt = NetworkTime::fromLocalTime(slotStart).get();
+    for(auto& e : down) EventLog::record(EventType::LINK_DOWN, nt, e.first << 8 | e.second);
+    for(auto& e : up) EventLog::record(EventType::LINK_UP, nt, e.first << 8 | e.second);
+    EventLog::record(EventType::TOPOLOGY, nt, edges.size());
+    loggedTopology = std::move(edges);
+}
+
+void MasterUplinkPhase::updateLiveNodes()
+{
+    if(discoveryInterval == 0) return;
+    if(ctx.getNetworkConfig().getUplinkSpatialReuse()) {
+        // Rotate the starting node of the group assignment over time
+        std::vector<unsigned char> groups;
+        topology.getUplinkGroups(groups, maxSharedGroup, uplinkCounter);
+        std::vector<unsigned char> data(liveNodeData.size());
+        encodeUplinkGroups(groups, data);
+        setLiveNodes(data.data());
+    } else {
+        std::vector<unsigned char> data(liveNodeData.size());
+        encodeLiveNodes(topology.getLiveNodes(), data);
+        setLiveNodes(data.data());
+    }
+}
+
 void MasterUplinkPhase::sendMyUplink(long long slotStart)
 {
     SendUplinkMessage message(ctx.getNetworkConfig(), 0, false, ctx.getNetworkId(),
                               myNeighborTable.getMyTopologyElement(),
-                              0, 0);
+                              topologyQueue, 0, 0, 0);
     if(ENABLE_UPLINK_DYN_INFO_DBG)
         print_dbg("[U] N=%u -> @%llu\n", ctx.getNetworkId(), NetworkTime::fromLocalTime(slotStart).get());
 
     ctx.configureTransceiver(ctx.getTransceiverConfig());
     message.send(ctx,slotStart);
     ctx.transceiverIdle();
+    ctx.getMACTrace().event(MACTraceEvent::UPLINK_SEND, StreamId(), myId);
 
     //send my topology to myself
     TopologyElement myTopology = myNeighborTable.getMyTopologyElement();
@@ -63,6 +63,11 @@ public:
      */
     void desync() override {}
 
+    /**
+     * Advertise as present the nodes that appear in the network topology
+     */
+    void updateLiveNodes() override;
+
     /**
      * Called when it's our turn to transmit in the round-robin.
      * It sends the UplinkMessage containing our local TopologyElement and SMEs
@@ -71,8 +76,15 @@ public:
     void sendMyUplink(long long slotStart);
     
 private:
+    /**
+     * Record the changes of the topology in the EventLog
+     */
+    void logTopology(long long slotStart);
+
     StreamCollection* const streamColl;
     NetworkTopology topology;    
+    /// Sorted links of the topology last recorded in the EventLog
+    std::vector<std::pair<unsigned char, unsigned char>> loggedTopology;
 };
 
 } // namespace mxnet
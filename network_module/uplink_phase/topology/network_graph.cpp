@@ -157,4 +157,115 @@ void ImmediateRemovalNetworkGraph::clearBit(unsigned char a, unsigned char b) {
     }
 }
 
+//
+// class DenseNetworkGraph
+//
+
+#ifdef TDMH_FIXED_MAX_NODES
+const std::size_t DenseNetworkGraph::maxNodes;
+const std::size_t DenseNetworkGraph::rowWords;
+#endif
+
+bool DenseNetworkGraph::hasNode(unsigned char a) {
+    if(a >= maxNodes) return false;
+    const word_t *r = row(a);
+    for(unsigned i = 0; i < rowWords; i++)
+        if(r[i]) return true;
+    return false;
+}
+
+std::vector<std::pair<unsigned char, unsigned char>> DenseNetworkGraph::getEdges() {
+    std::vector<std::pair<unsigned char, unsigned char>> result;
+    for(unsigned a = 0; a < maxNodes; a++) {
+        const word_t *r = row(a);
+        // Search (a,b) with b >= a, starting from the word containing a
+        for(unsigned i = a / wordBits; i < rowWords; i++) {
+            word_t w = r[i];
+            if(i == a / wordBits) w &= ~(mask(a) - 1);
+            while(w) {
+                unsigned b = i * wordBits + __builtin_ctzl(w);
+                result.push_back(std::make_pair(a, b));
+                w &= w - 1;
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<unsigned char> DenseNetworkGraph::getEdges(unsigned char a) {
+    std::vector<unsigned char> result;
+    if(a >= maxNodes) return result;
+    const word_t *r = row(a);
+    for(unsigned i = 0; i < rowWords; i++) {
+        word_t w = r[i];
+        while(w) {
+            result.push_back(i * wordBits + __builtin_ctzl(w));
+            w &= w - 1;
+        }
+    }
+    return result;
+}
+
+bool DenseNetworkGraph::addEdge(unsigned char a, unsigned char b) {
+    if(a >= maxNodes || b >= maxNodes) return false;
+    if(getBit(a,b)) return false;
+    setBit(a,b);
+    setBit(b,a);
+    return true;
+}
+
+bool DenseNetworkGraph::removeEdge(unsigned char a, unsigned char b) {
+    if(getBit(a,b) == false) return false; //Already not present
+    clearBit(a,b);
+    clearBit(b,a);
+    /* Set this flag to true because removing edges may generate a graph
+        where some nodes are not connected to the master node, these nodes
+        needs to be eliminated with removeNotConnected() */
+    possiblyNotConnected_flag = true;
+    return true;
+}
+
+bool DenseNetworkGraph::removeUnreachableNodes() {
+    // Breadth first visit from the master node, the visited set is kept as a
+    // bitmask row so that it can be used to mask the adjacency rows directly
+#ifdef TDMH_FIXED_MAX_NODES
+    std::array<word_t, rowWords> reachable;
+    reachable.fill(0);
+#else
+    std::vector<word_t> reachable(rowWords, 0);
+#endif
+    std::vector<unsigned char> openSet;
+    if(maxNodes > 0) {
+        reachable[0] |= mask(0);
+        openSet.push_back(0);
+    }
+    for(unsigned k = 0; k < openSet.size(); k++) {
+        const word_t *r = row(openSet[k]);
+        for(unsigned i = 0; i < rowWords; i++) {
+            // Only children that have not yet been reached
+            word_t w = r[i] & ~reachable[i];
+            reachable[i] |= w;
+            while(w) {
+                openSet.push_back(i * wordBits + __builtin_ctzl(w));
+                w &= w - 1;
+            }
+        }
+    }
+    bool removed = false;
+    // Clear the rows of unreachable nodes and the columns of the reachable ones
+    for(unsigned a = 0; a < maxNodes; a++) {
+        word_t *r = row(a);
+        bool keep = (reachable[a / wordBits] & mask(a)) != 0;
+        for(unsigned i = 0; i < rowWords; i++) {
+            word_t w = keep ? r[i] & reachable[i] : 0;
+            if(w != r[i]) {
+                r[i] = w;
+                removed = true;
+            }
+        }
+    }
+    possiblyNotConnected_flag = false;
+    return removed;
+}
+
 } /* namespace mxnet */
@@ -28,13 +28,25 @@
 #pragma once
 
 #include "../../util/runtime_bitset.h"
+#include "../../util/network_size.h"
 #include <vector>
+#include <array>
 #include <utility>
 #include <map>
 #include <stdexcept>
 
+// The master keeps four graphs (strong and weak links, in the topology and in
+// the scheduler). A DenseNetworkGraph takes 8KByte for 256 nodes even if the
+// network is sparse, so 32KByte in total, which is too much for the MCU.
+// There it is only the default if TDMH_FIXED_MAX_NODES bounds its size.
+#ifndef GRAPH_TYPE
+#if !defined(_MIOSIX) || defined(TDMH_FIXED_MAX_NODES)
+#define GRAPH_TYPE DenseNetworkGraph
+#else
 #define GRAPH_TYPE ImmediateRemovalNetworkGraph
+#endif
 //#define GRAPH_TYPE DelayedRemovalNetworkGraph
+#endif
 
 namespace mxnet {
 
@@ -115,4 +127,114 @@ protected:
     std::map<unsigned char, RuntimeBitset> graph;
 };
 
+/**
+ * DenseNetworkGraph has the same interface and semantics of
+ * ImmediateRemovalNetworkGraph, but stores the graph as an adjacency matrix
+ * of maxNodes rows, all allocated contiguously. Each row is made of machine
+ * words, so that iterating over the neighbors of a node is done by counting
+ * trailing zeros instead of testing each bit, and the reachability walk
+ * operates on whole words.
+ * Memory usage is maxNodes*ceil(maxNodes/wordBits) words regardless of the
+ * number of edges, which is at most 8KByte for 256 nodes.
+ * If TDMH_FIXED_MAX_NODES is defined the matrix is an array in the object,
+ * of TDMH_FIXED_MAX_NODES rows whose length is a compile-time constant.
+ */
+class DenseNetworkGraph {
+public:
+#ifdef TDMH_FIXED_MAX_NODES
+    DenseNetworkGraph(unsigned short maxNodes) {
+        if(maxNodes > TDMH_FIXED_MAX_NODES) throw std::range_error("DenseNetworkGraph");
+        matrix.fill(0);
+    }
+#else
+    DenseNetworkGraph(unsigned short maxNodes) : maxNodes(maxNodes),
+        rowWords((maxNodes + wordBits - 1) / wordBits),
+        matrix(maxNodes * rowWords, 0) {}
+#endif
+
+    bool hasNode(unsigned char a);
+
+    bool hasEdge(unsigned char a, unsigned char b) {
+        return getBit(a,b);
+    }
+
+    bool hasUnreachableNodes() {
+        return possiblyNotConnected_flag;
+    }
+
+    // NOTE: The graph stores (a,b) and (b,a) for easier searching
+    // however getEdges() returns only (a,b) for shorter topology prints
+    std::vector<std::pair<unsigned char, unsigned char>> getEdges();
+
+    std::vector<unsigned char> getEdges(unsigned char a);
+
+    /**
+     * \param a one of the two nodes (order is irrelevant)
+     * \param b the other node
+     * \return true if the graph was modified, that is the edge was added to the graph
+     */
+    bool addEdge(unsigned char a, unsigned char b);
+
+    /**
+     * \param a one of the two nodes (order is irrelevant)
+     * \param b the other node
+     * \return true if the graph was modified, that is the edge was removed from the graph
+     */
+    bool removeEdge(unsigned char a, unsigned char b);
+
+    /* This method performs a walk of the graph to find all the nodes that
+       are not reachable from the node 0 (Master node), these nodes are eliminated
+       from the graph because they create problems to TDMH since we cannot have
+       a flow of information between these nodes and the master and vice-versa
+       @return true if one or more nodes has been eliminated */
+    bool removeUnreachableNodes();
+
+protected:
+    /* Native word of the target, 32 bit on the microcontroller and
+       64 bit on most hosts running the simulator */
+    typedef unsigned long word_t;
+    static const unsigned wordBits = 8 * sizeof(word_t);
+
+    /* Pointer to the first word of the adjacency row of node a */
+    word_t *row(unsigned char a) { return &matrix[a * rowWords]; }
+
+    static word_t mask(unsigned char b) { return static_cast<word_t>(1) << (b % wordBits); }
+
+    /* This method returns the value of a bit in the adjacency matrix */
+    bool getBit(unsigned char a, unsigned char b) {
+        if(a >= maxNodes || b >= maxNodes) return false;
+        return (row(a)[b / wordBits] & mask(b)) != 0;
+    }
+
+    /* This method sets a bit in the adjacency matrix to 1 */
+    void setBit(unsigned char a, unsigned char b) {
+        row(a)[b / wordBits] |= mask(b);
+    }
+
+    /* This method sets a bit in the adjacency matrix to 0 */
+    void clearBit(unsigned char a, unsigned char b) {
+        row(a)[b / wordBits] &= ~mask(b);
+    }
+
+    /* Flag that indicates that some nodes in the graph may not be connected
+       to the master node, set after removeEdge, reset after calling
+        the removeNotConnected() method */
+    bool possiblyNotConnected_flag = false;
+
+#ifdef TDMH_FIXED_MAX_NODES
+    static const std::size_t maxNodes = TDMH_FIXED_MAX_NODES;
+    static const std::size_t rowWords = (maxNodes + wordBits - 1) / wordBits;
+    std::array<word_t, maxNodes * rowWords> matrix;
+#else
+    /* Number of rows and columns of the adjacency matrix */
+    std::size_t maxNodes;
+
+    /* Number of words that make up a row of the adjacency matrix */
+    std::size_t rowWords;
+
+    /* Adjacency matrix, row-major, row a contains the neighbors of node a */
+    std::vector<word_t> matrix;
+#endif
+};
+
 } /* namespace mxnet */
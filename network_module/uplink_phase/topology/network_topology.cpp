@@ -48,6 +48,55 @@ void NetworkTopology::handleTopologies(UpdatableQueue<unsigned char,
     graph_mutex.unlock();
 }
 
+RuntimeBitset NetworkTopology::getLiveNodes()
+{
+#ifdef _MIOSIX
+    miosix::Lock<miosix::Mutex> lck(graph_mutex);
+#else
+    std::unique_lock<std::mutex> lck(graph_mutex);
+#endif
+    RuntimeBitset result(maxNodes, false);
+    for(unsigned i = 0; i < maxNodes; i++)
+        if(graph.hasNode(i)) result[i] = true;
+    return result;
+}
+
+void NetworkTopology::getUplinkGroups(std::vector<unsigned char>& groups,
+                                      unsigned char maxGroups, unsigned int first)
+{
+#ifdef _MIOSIX
+    miosix::Lock<miosix::Mutex> lck(graph_mutex);
+#else
+    std::unique_lock<std::mutex> lck(graph_mutex);
+#endif
+    std::vector<std::vector<unsigned char>> neighbors(maxNodes);
+    for(unsigned i = 0; i < maxNodes; i++)
+    {
+        neighbors[i] = graph.getEdges(i);
+        if(useWeakTopologies) {
+            auto weak = weakGraph.getEdges(i);
+            neighbors[i].insert(neighbors[i].end(), weak.begin(), weak.end());
+        }
+    }
+    groups.assign(maxNodes, 0);
+    for(unsigned k = 0; k < maxNodes; k++)
+    {
+        unsigned i = (first + k) % maxNodes;
+        // The master is always present
+        if(i != 0 && graph.hasNode(i) == false) continue;
+        // Groups used by nodes within two hops, group 0 is never used
+        unsigned int used = 0;
+        for(auto n : neighbors[i])
+        {
+            used |= 1u << groups[n];
+            for(auto m : neighbors[n]) used |= 1u << groups[m];
+        }
+        unsigned char group = 1;
+        while(group <= maxGroups && (used & (1u << group))) group++;
+        groups[i] = group;
+    }
+}
+
 void NetworkTopology::scheduleNotChanged()
 {
 #ifdef _MIOSIX
@@ -113,7 +162,11 @@ void NetworkTopology::doReceivedTopology(const TopologyElement& topology) {
             for(unsigned int i=0;i<weakBitset.bitSize();i++) s+=weakBitset[i] ? '1' : '0';
             s+=']';
         }
-        print_dbg("[U] Topo %03d: %s\n",src,s.c_str());
+        // Deferred print_dbg records hold a bounded amount of arguments, so
+        // long bitmaps are printed as several lines with the same prefix
+        const unsigned int lineSize = 48;
+        for(unsigned int i=0;i<s.size();i+=lineSize)
+            print_dbg("[U] Topo %03d: %s\n",src,s.substr(i,lineSize).c_str());
     }
 
     /* Update graph according to received topology */
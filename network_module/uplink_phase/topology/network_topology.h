@@ -58,6 +58,7 @@ inline std::pair<unsigned char,unsigned char> orderLink(unsigned char a, unsigne
 class NetworkTopology {
 public:
     NetworkTopology(const NetworkConfiguration& config) :
+        maxNodes(config.getMaxNodes()),
         channelSpatialReuse(config.getChannelSpatialReuse()),
         useWeakTopologies(config.getUseWeakTopologies()),
         graph(config.getMaxNodes()),
@@ -136,6 +137,29 @@ public:
     void scheduleChanged(std::set<std::pair<unsigned char,unsigned char>>&& usedLinks,
             std::set<std::pair<unsigned char, unsigned char>>&& newLinksCausingReschedule);
 
+    /**
+     * \return a bitmap with the nodes that have at least one link in the
+     * network graph, used to advertise the nodes present in the network
+     */
+    RuntimeBitset getLiveNodes();
+
+    /**
+     * Assign the nodes present in the network to uplink groups, so that the
+     * nodes of a group are at least three hops apart in the union of the
+     * strong and weak graph, thus they can transmit in the same uplink slot
+     * without interfering at any of their neighbors.
+     * Nodes are assigned greedily to the first group not used within two hops.
+     * \param groups filled with one value per node: 0 if the node is absent,
+     * from 1 to maxGroups its group, maxGroups+1 if the node could not be
+     * assigned to any group and needs a slot on its own
+     * \param maxGroups number of groups
+     * \param first node from which the greedy assignment starts. Changing it
+     * over time changes which nodes share a slot, so that links not yet known
+     * to the master between nodes sharing a slot are eventually discovered
+     */
+    void getUplinkGroups(std::vector<unsigned char>& groups,
+                         unsigned char maxGroups, unsigned int first);
+
 #ifndef _MIOSIX
     /**
      * Only used for DBG prints in the simulator
@@ -171,6 +195,7 @@ private:
        the forwarded topology */
     void doReceivedTopology(const TopologyElement& topology);
     
+    unsigned short maxNodes;
     bool channelSpatialReuse;
     bool useWeakTopologies;
 
@@ -36,28 +36,99 @@ namespace mxnet {
 //
     
 void TopologyElement::serialize(Packet& pkt) const {
-    pkt.put(&id, sizeof(unsigned char));
-    pkt.put(neighbors.data(), neighbors.size());
+    auto w = pkt.reserve(size());
+    w.put(id);
+    serializeBitmask(w, neighbors);
     if(weakTop) {
-        pkt.put(weakNeighbors.data(), weakNeighbors.size());
+        serializeBitmask(w, weakNeighbors);
     }
 }
 
 void TopologyElement::deserialize(Packet& pkt) {
     assert(neighbors.size()>0);
-    pkt.get(&id, sizeof(unsigned char));
-    pkt.get(neighbors.data(), neighbors.size());
+    id = pkt.consume(sizeof(unsigned char)).get();
+    deserializeBitmask(pkt, neighbors);
     if(weakTop) {
         assert(weakNeighbors.size()>0);
-        pkt.get(weakNeighbors.data(), weakNeighbors.size());
+        deserializeBitmask(pkt, weakNeighbors);
     }
 }
 
 
-bool TopologyElement::validateInPacket(Packet& packet, unsigned int offset,
-                                              unsigned short maxNodes) {
+unsigned int TopologyElement::validateInPacket(Packet& packet, unsigned int offset,
+                                               unsigned short maxNodes, bool useWeakTopologies) {
+    if(offset >= packet.size()) return 0;
     // Check that id is < maxNodes
-    return (packet[offset] < maxNodes);
+    if(packet[offset] >= maxNodes) return 0;
+    unsigned int size = sizeof(unsigned char);
+    unsigned int bitmaskSize = validateBitmask(packet, offset + size, maxNodes);
+    if(bitmaskSize == 0) return 0;
+    size += bitmaskSize;
+    if(useWeakTopologies) {
+        bitmaskSize = validateBitmask(packet, offset + size, maxNodes);
+        if(bitmaskSize == 0) return 0;
+        size += bitmaskSize;
+    }
+    return size;
+}
+
+std::size_t TopologyElement::encodedSize(const RuntimeBitset& bitmask) {
+    if(!useCompactEncoding(bitmask.size())) return bitmask.size();
+    auto count = bitmask.count();
+    if(useSparseEncoding(bitmask, count)) return sizeof(unsigned char) + count;
+    else return sizeof(unsigned char) + bitmask.size();
+}
+
+void TopologyElement::serializeBitmask(PacketWriter& w, const RuntimeBitset& bitmask) {
+    if(useCompactEncoding(bitmask.size())) {
+        auto count = bitmask.count();
+        if(useSparseEncoding(bitmask, count)) {
+            w.put(static_cast<unsigned char>(sparseFlag | count));
+            for(auto i : bitmask.setBits())
+                w.put(static_cast<unsigned char>(i));
+            return;
+        }
+        w.put(static_cast<unsigned char>(0));
+    }
+    w.put(bitmask.data(), bitmask.size());
+}
+
+void TopologyElement::deserializeBitmask(Packet& pkt, RuntimeBitset& bitmask) {
+    if(useCompactEncoding(bitmask.size())) {
+        unsigned char encoding = pkt.consume(sizeof(unsigned char)).get();
+        if(encoding & sparseFlag) {
+            bitmask.setAll(false);
+            unsigned char count = encoding & ~sparseFlag;
+            auto r = pkt.consume(count);
+            for(unsigned char i = 0; i < count; i++)
+                bitmask[r.get()] = true;
+            return;
+        }
+    }
+    pkt.consume(bitmask.size()).get(bitmask.data(), bitmask.size());
+}
+
+unsigned int TopologyElement::validateBitmask(Packet& packet, unsigned int offset,
+                                              unsigned short maxNodes) {
+    // NOTE: maxNodes is a multiple of 8, see NetworkConfiguration
+    const unsigned int bitmaskSize = maxNodes / 8;
+    if(!useCompactEncoding(bitmaskSize)) {
+        if(offset + bitmaskSize > packet.size()) return 0;
+        return bitmaskSize;
+    }
+    if(offset >= packet.size()) return 0;
+    unsigned char encoding = packet[offset];
+    if((encoding & sparseFlag) == 0) {
+        if(encoding != 0) return 0;
+        if(offset + 1 + bitmaskSize > packet.size()) return 0;
+        return 1 + bitmaskSize;
+    }
+    unsigned int count = encoding & ~sparseFlag;
+    if(count >= bitmaskSize) return 0;
+    if(offset + 1 + count > packet.size()) return 0;
+    for(unsigned int i = 0; i < count; i++)
+        if(packet[offset + 1 + i] >= maxNodes) return 0;
+    return 1 + count;
 }
 
 } /* namespace mxnet */
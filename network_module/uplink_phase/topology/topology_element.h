@@ -33,6 +33,7 @@
 namespace mxnet {
 
 class Packet;
+class PacketWriter;
 
 /**
  * TopologyElement containg a map of the neighbors of a given node on the network
@@ -85,20 +86,48 @@ public:
         if(weakTop) weakNeighbors.setAll(0);
     }
 
+    /**
+     * Bitmasks of at least this many bytes are serialized in compact form:
+     * each bitmask is preceded by an encoding byte, and is sent as a list of
+     * node ids when it is shorter than the bitmask itself, as it happens for
+     * nodes with few neighbors in large networks. Smaller bitmasks are always
+     * sent as they are, since the encoding byte would not pay off.
+     */
+    static const unsigned short compactMinBitmaskSize = 8;
+
+    static bool useCompactEncoding(unsigned short bitmaskSize) {
+        return bitmaskSize >= compactMinBitmaskSize;
+    }
+
+    /**
+     * \return the size of the largest possible encoding of a TopologyElement
+     */
     static unsigned short maxSize(unsigned short bitmaskSize, bool useWeakTopologies) {
-        if(useWeakTopologies) return sizeof(unsigned char) + 2*bitmaskSize;
-        else return sizeof(unsigned char) + bitmaskSize;
+        unsigned short bitmaskBytes = bitmaskSize;
+        if(useCompactEncoding(bitmaskSize)) bitmaskBytes += sizeof(unsigned char);
+        if(useWeakTopologies) return sizeof(unsigned char) + 2*bitmaskBytes;
+        else return sizeof(unsigned char) + bitmaskBytes;
     }
+
+    /**
+     * \return the size of the encoding of this TopologyElement, which is
+     * chosen per element and can be smaller than maxSize()
+     */
     std::size_t size() const override {
-        if(weakTop) return sizeof(unsigned char) + neighbors.size() + weakNeighbors.size();
-        else return sizeof(unsigned char) + neighbors.size();
+        if(weakTop) return sizeof(unsigned char) + encodedSize(neighbors) + encodedSize(weakNeighbors);
+        else return sizeof(unsigned char) + encodedSize(neighbors);
     }
     void serialize(Packet& pkt) const override;
 
     void deserialize(Packet& pkt) override;
 
-    static bool validateInPacket(Packet& packet, unsigned int offset,
-                                 unsigned short maxNodes);
+    /**
+     * Checks a serialized TopologyElement without deserializing it
+     * \return the size of the element starting at offset, or 0 if it is
+     * not valid
+     */
+    static unsigned int validateInPacket(Packet& packet, unsigned int offset,
+                                         unsigned short maxNodes, bool useWeakTopologies);
 
     unsigned char getId() const { return id; }
 
@@ -113,6 +142,22 @@ public:
 
 private:
 
+    /* Encoding byte of a bitmask sent as a list, the low bits are the list length */
+    static const unsigned char sparseFlag = 0x80;
+
+    static std::size_t encodedSize(const RuntimeBitset& bitmask);
+
+    static bool useSparseEncoding(const RuntimeBitset& bitmask, std::size_t count) {
+        return count < bitmask.size();
+    }
+
+    static void serializeBitmask(PacketWriter& w, const RuntimeBitset& bitmask);
+
+    static void deserializeBitmask(Packet& pkt, RuntimeBitset& bitmask);
+
+    static unsigned int validateBitmask(Packet& packet, unsigned int offset,
+                                        unsigned short maxNodes);
+
     /* Network ID of the node */
     unsigned char id;
     /* Neighbors of the node */
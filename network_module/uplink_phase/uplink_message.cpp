@@ -27,6 +27,8 @@
  ***************************************************************************/
 
 #include "uplink_message.h"
+#include <limits>
+#include <vector>
 
 namespace mxnet {
 
@@ -38,55 +40,70 @@ SendUplinkMessage::SendUplinkMessage(const NetworkConfiguration& config,
                                      unsigned char hop,
                                      bool badFlag, unsigned char assignee,
                                      const TopologyElement& myTopology,
-                                     int availableTopologies, int availableSMEs) :
+                                     const UpdatableQueue<unsigned char,TopologyElement>& topologies,
+                                     int availableTopologies, int availableSMEs,
+                                     unsigned short syncWindow) :
     weakTop(config.getUseWeakTopologies()),
-    topologySize(TopologyElement::maxSize(config.getNeighborBitmaskSize(), weakTop)),
     smeSize(StreamManagementElement::maxSize()),
     panId(config.getPanId())
 {
-    computePacketAllocation(config, availableTopologies, availableSMEs);
+    computePacketAllocation(config, topologies, availableTopologies, availableSMEs);
     packet.putPanHeader(panId);
     unsigned char hopFlag;
     if(badFlag) hopFlag = hop | 0x80;
     else hopFlag = hop & 0x7F;
     header = {hopFlag, assignee, numTopologies, numSMEs};
-    packet.put(&header, sizeof(UplinkHeader));
+    auto w = packet.reserve(getFirstUplinkHeaderSize(config));
+    w.put(header);
+    // Receivers can't tell the sender from the slot if it is shared
+    if(getUplinkSenderSize(config) != 0) w.put(myTopology.getId());
+    if(getUplinkSyncWindowSize(config) != 0) w.put(syncWindow);
     auto& neighbors = myTopology.getNeighbors();
-    packet.put(neighbors.data(), neighbors.size());
+    w.put(neighbors.data(), neighbors.size());
     if(weakTop) {
         auto& weakNeighbors = myTopology.getWeakNeighbors();
-        packet.put(weakNeighbors.data(), weakNeighbors.size());
+        w.put(weakNeighbors.data(), weakNeighbors.size());
     }
 }
 
 void SendUplinkMessage::serializeTopologiesAndSMEs(UpdatableQueue<unsigned char,TopologyElement>& topologies,
                                                   UpdatableQueue<SMEKey,StreamManagementElement>& smes) {
-    int remainingBytes = packet.available();
-    // Fit topologies in packets
-    int packetTopologies = std::min<int>(numTopologies, remainingBytes / topologySize);
-    for(int i = 0; i < packetTopologies; i++) {
+    /* Fit topologies in packet, the encoding of each of them is chosen by
+       TopologyElement::serialize(), so the space they take varies.
+       NOTE: this must pack elements exactly as computePacketAllocation() */
+    while(numTopologies > 0) {
+        if(topologies.top().size() > packet.available()) return;
         auto topology = topologies.dequeue();
         topology.serialize(packet);
+        numTopologies--;
     }
-    numTopologies -= packetTopologies;
-    // NOTE: Do not put SMEs as long as there are topologies left
-    if(numTopologies > 0)
-        return;
-
-    remainingBytes -= packetTopologies * topologySize;
-    // Fit SMEs in packets
-    int packetSMEs = std::min<int>(numSMEs, remainingBytes / smeSize);
-    for(int i = 0; i < packetSMEs; i++) {
+    // NOTE: SMEs are put only after all topologies, as we get here only
+    // when there are no topologies left
+    // Fit SMEs in packet
+    while(numSMEs > 0) {
+        if(smeSize > packet.available()) return;
         auto sme = smes.dequeue();
         sme.serialize(packet);
+        numSMEs--;
     }
-    numSMEs -= packetSMEs;
 }
 
 void SendUplinkMessage::computePacketAllocation(const NetworkConfiguration& config,
+                                                const UpdatableQueue<unsigned char,TopologyElement>& topologies,
                                                 int availableTopologies, int availableSMEs) {
     const int maxPackets = config.getNumUplinkPackets();
     const int guaranteedTopologies = config.getGuaranteedTopologies();
+    // Encoded size of the topologies that can be sent, in the order they are
+    // dequeued. Their number is limited by the UplinkHeader field size
+    std::vector<int> topologySizes;
+    availableTopologies = std::min<int>(availableTopologies, std::numeric_limits<unsigned char>::max());
+    topologies.visit([&](const TopologyElement& topology) {
+        if(static_cast<int>(topologySizes.size()) >= availableTopologies) return false;
+        topologySizes.push_back(topology.size());
+        return true;
+    });
+    availableTopologies = topologySizes.size();
+    availableSMEs = std::min<int>(availableSMEs, std::numeric_limits<unsigned char>::max());
     /* Calculate numTopologies and numSME without considering a topology or SME
        split between two packets
        Algorithm:
@@ -98,48 +115,50 @@ void SendUplinkMessage::computePacketAllocation(const NetworkConfiguration& conf
         const int totAvailableBytes = getFirstUplinkPacketCapacity(config) +
             (maxPackets - 1) * getOtherUplinkPacketCapacity();
         numTopologies = std::min(guaranteedTopologies, availableTopologies);
-        const int remainingTopologies = availableTopologies - numTopologies;
-        const int topologyBytes = numTopologies * topologySize;
-        const int maxSMEs = (totAvailableBytes - topologyBytes) / smeSize;
+        int topologyBytes = 0;
+        for(int i = 0; i < numTopologies; i++) topologyBytes += topologySizes[i];
+        const int maxSMEs = std::max(0, totAvailableBytes - topologyBytes) / smeSize;
         numSMEs = std::min(availableSMEs, maxSMEs);
-        const int unusedBytes = totAvailableBytes - topologyBytes -
+        int unusedBytes = totAvailableBytes - topologyBytes -
             (numSMEs * smeSize);
-        numTopologies += std::min<int>(unusedBytes / topologySize, remainingTopologies);
+        while(numTopologies < availableTopologies && topologySizes[numTopologies] <= unusedBytes)
+            unusedBytes -= topologySizes[numTopologies++];
     }
 
     /* Try to fit numTopologies and numSME in packet, to get the actual numbers,
-       also considering SMEs and Topologies split between two packets */
+       also considering SMEs and Topologies split between two packets.
+       Each element is put in the current packet if it fits, otherwise a new
+       packet is started */
     int remainingBytes = getFirstUplinkPacketCapacity(config);
     totPackets = 1;
     // Fit topologies in packets
-    int remainingTopologies = numTopologies;
-    for(;;) {
-        // NOTE: Do the allocation also for the last packet
-        int packetTopologies = std::min<int>(remainingTopologies, remainingBytes / topologySize);
-        remainingTopologies -= packetTopologies;
-        remainingBytes -= packetTopologies * topologySize;
-        if(remainingTopologies == 0 || totPackets >= maxPackets) break;
-        totPackets++;
-        remainingBytes = getOtherUplinkPacketCapacity();
+    int fittedTopologies = 0;
+    while(fittedTopologies < numTopologies) {
+        if(topologySizes[fittedTopologies] <= remainingBytes) {
+            remainingBytes -= topologySizes[fittedTopologies++];
+        } else if(totPackets < maxPackets) {
+            totPackets++;
+            remainingBytes = getOtherUplinkPacketCapacity();
+        } else break;
     }
     /* NOTE: Handling the corner case in which after splitting in packets, we can't
        fit all the topologies */
-    numTopologies -= remainingTopologies;
+    numTopologies = fittedTopologies;
 
-    // Fit SMEs in packets
-    int remainingSMEs = numSMEs;
-    for(;;) {
-        // NOTE: Do the allocation also for the last packet
-        int packetSMEs = std::min<int>(remainingSMEs, remainingBytes / smeSize);
-        remainingSMEs -= packetSMEs;
-        remainingBytes -= packetSMEs * smeSize;
-        if(remainingSMEs == 0 || totPackets >= maxPackets) break;
-        totPackets++;
-        remainingBytes = getOtherUplinkPacketCapacity();
+    // Fit SMEs in packets, after the topologies
+    int fittedSMEs = 0;
+    while(fittedSMEs < numSMEs) {
+        if(smeSize <= static_cast<unsigned int>(remainingBytes)) {
+            remainingBytes -= smeSize;
+            fittedSMEs++;
+        } else if(totPackets < maxPackets) {
+            totPackets++;
+            remainingBytes = getOtherUplinkPacketCapacity();
+        } else break;
     }
     /* NOTE: Handling the corner case in which after splitting in packets, we can't
        fit all the SMEs */
-    numSMEs -= remainingSMEs;
+    numSMEs = fittedSMEs;
 
     // Sanity checks
     assert(numTopologies >= 0);
@@ -162,15 +181,7 @@ bool ReceiveUplinkMessage::recv(MACContext& ctx, long long tExpected) {
     if(rcvResult.error != miosix::RecvResult::ErrorCode::OK)
         return false;
 
-    auto& config = ctx.getNetworkConfig();
-    // Validate first packet
-    if(receivedPackets == 0) {
-        if(checkFirstPacket(config) == false) return false;
-    }
-    // Validate other packets
-    else {
-        if(checkOtherPacket(config) == false) return false;
-    }
+    if(checkPacket(ctx.getNetworkConfig()) == false) return false;
     // Save rssi and timestamp of valid packet
     rssi = rcvResult.rssi;
     if(rcvResult.timestampValid)
@@ -200,20 +211,36 @@ void ReceiveUplinkMessage::deserializeTopologiesAndSMEs(UpdatableQueue<unsigned
     }
 }
 
+bool ReceiveUplinkMessage::checkPacket(const NetworkConfiguration& config) {
+    // Validate first packet
+    if(receivedPackets == 0) return checkFirstPacket(config);
+    // Validate other packets
+    else return checkOtherPacket(config);
+}
+
 bool ReceiveUplinkMessage::checkFirstPacket(const NetworkConfiguration& config) {
     const unsigned int headerSize = Packet::maxSize() - getFirstUplinkPacketCapacity(config);
     if(packet.size() < headerSize) return false;
     if(packet.checkPanHeader(panId) == false) return false;
     packet.removePanHeader();
+    // The size was checked above, can't throw
+    auto r = packet.consume(headerSize - panHeaderSize);
     UplinkHeader tempHeader;
-    packet.get(&tempHeader, sizeof(UplinkHeader));
+    r.get(tempHeader);
     if(tempHeader.getHop() > config.getMaxHops()) return false;
     if(tempHeader.assignee > config.getMaxNodes()) return false;
+    unsigned char tempSender = 0;
+    if(hasSender) {
+        r.get(tempSender);
+        if(tempSender >= config.getMaxNodes()) return false;
+    }
+    unsigned short tempSyncWindow = 0;
+    if(hasSyncWindow) r.get(tempSyncWindow);
     // Extract sender topology
     RuntimeBitset tempSenderTopology(maxNodes);
     RuntimeBitset tempSenderWeakTopology(maxNodes);
-    packet.get(tempSenderTopology.data(), bitsetSize);
-    if(weakTop) packet.get(tempSenderWeakTopology.data(), bitsetSize);
+    r.get(tempSenderTopology.data(), bitsetSize);
+    if(weakTop) r.get(tempSenderWeakTopology.data(), bitsetSize);
 
     // Check topologies and SME only if uplink packet has any of them
     if(tempHeader.numTopology != 0 || tempHeader.numSME != 0)
@@ -222,6 +249,8 @@ bool ReceiveUplinkMessage::checkFirstPacket(const NetworkConfiguration& config)
 
     // Write temporary values to class fields
     header = tempHeader;
+    sender = tempSender;
+    syncWindow = tempSyncWindow;
     topology = std::move(tempSenderTopology);
     if(weakTop) weakTopology = std::move(tempSenderWeakTopology);
     return true;
@@ -238,82 +267,54 @@ bool ReceiveUplinkMessage::checkOtherPacket(const NetworkConfiguration& config)
 
 bool ReceiveUplinkMessage::checkTopologiesAndSMEs(const NetworkConfiguration& config,
                                                   UplinkHeader tempHeader) {
-    /* Validate numTopologies and numSME in UplinkHeader
-       by trying to extract from an example packet the same number of topologies and SME */
-    const int maxPackets = config.getNumUplinkPackets();
-    int remainingBytes = getFirstUplinkPacketCapacity(config);
-    int numPackets = 1;
-    // Validate topologies in packets
-    int remainingTopologies = tempHeader.numTopology;
+    /* Validate the elements in the packet walking through it. Topologies are
+       variable in size, and the sender puts as many elements as they fit in
+       each packet, topologies first and then SMEs, so the elements in this
+       packet are the ones following those received in previous packets */
+    const unsigned int remainingTopologies = tempHeader.numTopology - receivedTopologies;
+    const unsigned int remainingSMEs = tempHeader.numSME - receivedSMEs;
+    unsigned int offset = 0;
     unsigned int topologiesInPacket = 0;
-    // If no topologies in uplinkpacket, skip check
-    if(remainingTopologies != 0) {
-        for(;;) {
-            // NOTE: Do the allocation also for the last packet
-            int topologies = std::min<int>(remainingTopologies, remainingBytes / topologySize);
-            remainingTopologies -= topologies;
-            remainingBytes -= topologies * topologySize;
-            // Validate last received packet
-            if(numPackets == receivedPackets + 1) {
-                topologiesInPacket = topologies;
-                // Check that TopologyElements in packet are valid
-                for(unsigned int i = 0; i < topologiesInPacket; i++) {
-                    // Calculate TopologyElement offset in packet
-                    unsigned int offset = topologySize * i;
-                    // Check that there is enough data in the packet
-                    if(offset + topologySize > packet.size()) return false;
-                    if(TopologyElement::validateInPacket(packet, offset, maxNodes) == false)
-                        return false;
-                }
-            }
-            if(remainingTopologies == 0) break;
-            if(++numPackets > maxPackets) return false;
-            remainingBytes = getOtherUplinkPacketCapacity();
-        } 
+    while(topologiesInPacket < remainingTopologies && offset < packet.size()) {
+        unsigned int size = TopologyElement::validateInPacket(packet, offset, maxNodes, weakTop);
+        if(size == 0) return false;
+        offset += size;
+        topologiesInPacket++;
     }
-
-    // Validate SMEs in packets
-    int remainingSMEs = tempHeader.numSME;
-    int SMEsInPacket = 0;
-    // If no SMEs in uplinkpacket, skip check
-    if(remainingSMEs != 0) {
-        for(;;) {
-            // NOTE: Do the allocation also for the last packet
-            int smes = std::min<int>(remainingSMEs, remainingBytes / smeSize);
-            remainingSMEs -= smes;
-            remainingBytes -= smes * smeSize;
-            // Validate last received packet
-            if(numPackets == receivedPackets + 1) {
-                SMEsInPacket = smes;
-                // Check that SMEs in packet are valid
-                for(int i = 0; i < SMEsInPacket; i++) {
-                    // Calculate SME offset in packet
-                    unsigned int offset = (topologySize * topologiesInPacket) + (smeSize * i);
-                    // Check that there is enough data in the packet
-                    if(offset + smeSize > packet.size()) return false;
-                    if(StreamManagementElement::validateInPacket(packet, offset, maxNodes) == false)
-                        return false;
-                }
-            }
-            if(remainingSMEs == 0) break;
-            if(++numPackets > maxPackets) return false;
-            remainingBytes = getOtherUplinkPacketCapacity();
+    unsigned int SMEsInPacket = 0;
+    // SMEs can be present only after all topologies
+    if(topologiesInPacket == remainingTopologies) {
+        while(SMEsInPacket < remainingSMEs && offset < packet.size()) {
+            if(StreamManagementElement::validateInPacket(packet, offset, maxNodes) == false)
+                return false;
+            offset += smeSize;
+            SMEsInPacket++;
         }
     }
     // Check size of data in packet
-    if((topologiesInPacket * topologySize + SMEsInPacket * smeSize) != packet.size())
-        return false;
+    if(offset != packet.size()) return false;
+    // A packet other than the last has to contain at least one element, unless
+    // the next one may not fit even in an empty packet, as the sender starts a
+    // new packet when an element does not fit in the current one. The last
+    // allowed packet has to complete the message
+    bool complete = topologiesInPacket == remainingTopologies &&
+                    SMEsInPacket == remainingSMEs;
+    if(!complete) {
+        if(topologiesInPacket == 0 && SMEsInPacket == 0) {
+            unsigned int capacity = receivedPackets == 0 ?
+                getFirstUplinkPacketCapacity(config) : getOtherUplinkPacketCapacity();
+            unsigned int nextSize = remainingTopologies > 0 ?
+                TopologyElement::maxSize(bitsetSize, weakTop) : smeSize;
+            if(nextSize <= capacity) return false;
+        }
+        if(receivedPackets + 1 >= config.getNumUplinkPackets()) return false;
+    }
 
     // Write temporary values to class fields
-    // Write totPackets only after checking first packet
-    if(totPackets == 0)
-        totPackets = numPackets;
-    else {
-        // numPackets depends only on header (first packet), so should remain constant
-        assert(totPackets == numPackets);
-    }
     packetTopologies = topologiesInPacket;
     packetSMEs = SMEsInPacket;
+    receivedTopologies += topologiesInPacket;
+    receivedSMEs += SMEsInPacket;
     return true;
 }
 
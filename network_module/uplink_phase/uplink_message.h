@@ -53,20 +53,43 @@ struct UplinkHeader {
     }
 } __attribute__((packed));
 
+/**
+ * @return the size of the sender id following the UplinkHeader, only present
+ * if uplink slots can be shared by more nodes
+ */
+inline int getUplinkSenderSize(const NetworkConfiguration& config) {
+    return config.getUplinkSpatialReuse() ? 1 : 0;
+}
+
+/**
+ * @return the size of the sync window report following the sender id, only
+ * present if the adaptive clock sync period is enabled. It is the largest
+ * receiver window in microseconds of the sender and of the nodes that chose
+ * it as assignee, and reaches the master aggregated along the uplink tree
+ */
+inline int getUplinkSyncWindowSize(const NetworkConfiguration& config) {
+    return config.getAdaptiveClockSync() ? sizeof(unsigned short) : 0;
+}
+
+/**
+ * @return the size of what follows the panHeader in the first packet of an
+ * UplinkMessage before the topologies and SMEs, which is UplinkHeader,
+ * sender id, sync window and myTopology
+ */
+inline int getFirstUplinkHeaderSize(const NetworkConfiguration& config) {
+    int bitmasks = config.getUseWeakTopologies() ? 2 : 1;
+    return sizeof(UplinkHeader) +
+           getUplinkSenderSize(config) +
+           getUplinkSyncWindowSize(config) +
+           bitmasks * config.getNeighborBitmaskSize();
+}
+
 /**
  * @return the capacity of the first packet of an UplinkMessage, which is composed of
- * panHeader, UplinkHeader and myTopology
+ * panHeader, UplinkHeader, sender id, sync window and myTopology
  */
 inline int getFirstUplinkPacketCapacity(const NetworkConfiguration& config) {
-    if(config.getUseWeakTopologies()) {
-        return Packet::maxSize() - (panHeaderSize +
-                                    sizeof(UplinkHeader) +
-                                    2*config.getNeighborBitmaskSize());
-    } else {
-        return Packet::maxSize() - (panHeaderSize +
-                                    sizeof(UplinkHeader) +
-                                    config.getNeighborBitmaskSize());
-    }
+    return Packet::maxSize() - (panHeaderSize + getFirstUplinkHeaderSize(config));
 }
 
 /**
@@ -97,10 +120,20 @@ inline int getOtherUplinkPacketCapacity() {
 
 class SendUplinkMessage {
 public:
+    /**
+     * \param topologies queue of the topologies to forward, the first
+     * availableTopologies elements are considered for sending. The encoded
+     * size of each of them is used to compute how many fit in the message,
+     * so the queue must not be modified until the message has been serialized
+     * \param syncWindow the sync window report, in microseconds, sent only
+     * if the adaptive clock sync period is enabled
+     */
     SendUplinkMessage(const NetworkConfiguration& config, unsigned char hop,
                       bool badFlag, unsigned char assignee,
                       const TopologyElement& myTopology,
-                      int availableTopologies, int availableSMEs);
+                      const UpdatableQueue<unsigned char,TopologyElement>& topologies,
+                      int availableTopologies, int availableSMEs,
+                      unsigned short syncWindow);
 
     SendUplinkMessage(const SendUplinkMessage&) = delete;
     SendUplinkMessage& operator=(const SendUplinkMessage&) = delete;
@@ -128,6 +161,18 @@ public:
         packet.putPanHeader(panId);
     }
 
+#ifdef UNITTEST
+    /**
+     * Same as send(), but returns the packet instead of sending it
+     */
+    Packet send() {
+        Packet result = packet;
+        packet.clear();
+        packet.putPanHeader(panId);
+        return result;
+    }
+#endif
+
     void printHeader();
 
     /**
@@ -148,11 +193,11 @@ public:
 private:
 
     void computePacketAllocation(const NetworkConfiguration& config,
+                                 const UpdatableQueue<unsigned char,TopologyElement>& topologies,
                                  int availableTopologies, int availableSMEs);
 
     /* Constant values used in the methods */
     bool weakTop;
-    const unsigned int topologySize;
     const unsigned int smeSize;
     const unsigned short panId;
     UplinkHeader header;
@@ -178,7 +223,8 @@ public:
         bitsetSize(config.getNeighborBitmaskSize()),
         maxNodes(config.getMaxNodes()),
         weakTop(config.getUseWeakTopologies()),
-        topologySize(TopologyElement::maxSize(bitsetSize, weakTop)),
+        hasSender(config.getUplinkSpatialReuse()),
+        hasSyncWindow(config.getAdaptiveClockSync()),
         smeSize(StreamManagementElement::maxSize()),
         panId(config.getPanId()),
         topology(RuntimeBitset(maxNodes)),
@@ -198,10 +244,25 @@ public:
      */
     bool recv(MACContext& ctx, long long tExpected);
 
+#ifdef UNITTEST
     /**
-     * @return the number of packets
+     * Same as recv(), but with a packet that was not received over the radio
      */
-    int getNumPackets() const { return totPackets; }
+    bool recv(const NetworkConfiguration& config, const Packet& pkt) {
+        packet = pkt;
+        if(checkPacket(config) == false) return false;
+        receivedPackets++;
+        return true;
+    }
+#endif
+
+    /**
+     * @return true if the packets received so far do not contain all the
+     * topologies and SMEs announced in the header
+     */
+    bool hasMorePackets() const {
+        return receivedTopologies < header.numTopology || receivedSMEs < header.numSME;
+    }
 
     /**
      * @return the TopologyElement containing the neighbors of the sender
@@ -233,6 +294,18 @@ public:
      */
     unsigned char getAssignee() const { return header.assignee; }
 
+    /**
+     * @return the node that sent the UplinkMessage, only available if uplink
+     * spatial reuse is enabled
+     */
+    unsigned char getSender() const { return sender; }
+
+    /**
+     * @return the sync window report in microseconds, only available if the
+     * adaptive clock sync period is enabled
+     */
+    unsigned short getSyncWindow() const { return syncWindow; }
+
     /**
      * @return the number of Topologies saved in current packet
      */
@@ -253,6 +326,13 @@ public:
 
 private:
 
+    /**
+     * Checks the last received packet, the first one or a following one
+     * depending on how many were already received
+     * @return true if the packet is valid, false otherwise
+     */
+    bool checkPacket(const NetworkConfiguration& config);
+
     /**
      * Checks that the values in the first packet header are valid.
      * @return true if UplinkHeader of the received packet is valid, false otherwise
@@ -276,14 +356,17 @@ private:
     const unsigned short bitsetSize;
     const unsigned short maxNodes;
     bool weakTop;
-    const unsigned int topologySize;
+    const bool hasSender;
+    const bool hasSyncWindow;
     const unsigned int smeSize;
     const unsigned short panId;
 
     /* One of the UplinkMessage packets */
     Packet packet;
-    /* Number of packets composing the UplinkMessage */
-    int totPackets = 0;
+    /* Sender id, present only if uplink spatial reuse is enabled */
+    unsigned char sender = 0;
+    /* Sync window report, present only if the adaptive clock sync period is enabled */
+    unsigned short syncWindow = 0;
     /* Number of packets received */
     int receivedPackets = 0;
     /* RSSI of the received packer */
@@ -300,6 +383,10 @@ private:
     unsigned int packetTopologies = 0;
     /* Number of SMEs contained in the current packet */
     unsigned int packetSMEs = 0;
+    /* Number of topologies contained in all the packets received so far */
+    unsigned int receivedTopologies = 0;
+    /* Number of SMEs contained in all the packets received so far */
+    unsigned int receivedSMEs = 0;
 };
 
 } /* namespace mxnet */
@@ -28,6 +28,8 @@
 
 #include "uplink_phase.h"
 #include "uplink_message.h"
+#include <cstring>
+#include <algorithm>
 
 namespace mxnet {
 
@@ -52,26 +54,94 @@ void UplinkPhase::alignToNetworkTime(NetworkTime nt)
         if(controlSuperframe.isControlUplink(i)) phase++;
     }
     nextNode = nodesCount - 1 - (phase % nodesCount);
+    uplinkCounter = phase;
 }
 
-unsigned char UplinkPhase::getAndUpdateCurrentNode()
+void UplinkPhase::setLiveNodes(const unsigned char *data)
 {
-    auto currentNode = nextNode;
-    if (nextNode == 0) nextNode = nodesCount - 1;
-    else nextNode--;
-    return currentNode;
+    memcpy(liveNodeData.data(), data, liveNodeData.size());
+    liveGroups.clear();
+    absentNodes.clear();
+    if(ctx.getNetworkConfig().getUplinkSpatialReuse())
+    {
+        std::vector<std::vector<unsigned char>> sharedGroups(maxSharedGroup);
+        std::vector<unsigned char> ownSlotNodes;
+        for(int i = nodesCount - 1; i >= 0; i--)
+        {
+            unsigned char group = (data[i / 2] >> (i % 2 == 0 ? 4 : 0)) & 0xf;
+            // The master is always present
+            if(i == 0 && group == absentGroup) group = ownSlotGroup;
+            if(group == absentGroup) absentNodes.push_back(i);
+            else if(group == ownSlotGroup) ownSlotNodes.push_back(i);
+            else sharedGroups[group - 1].push_back(i);
+        }
+        for(auto& group : sharedGroups)
+            if(!group.empty()) liveGroups.push_back(std::move(group));
+        for(auto node : ownSlotNodes)
+            liveGroups.push_back(std::vector<unsigned char>(1, node));
+    } else {
+        for(int i = nodesCount - 1; i >= 0; i--)
+        {
+            // The master is always present
+            bool live = i == 0 || isLiveNode(data, i);
+            if(live) liveGroups.push_back(std::vector<unsigned char>(1, i));
+            else absentNodes.push_back(i);
+        }
+    }
+    liveNodesKnown = true;
+}
+
+void UplinkPhase::encodeUplinkGroups(const std::vector<unsigned char>& groups,
+                                     std::vector<unsigned char>& data)
+{
+    std::fill(data.begin(), data.end(), 0);
+    for(unsigned int i = 0; i < groups.size(); i++)
+        data[i / 2] |= (groups[i] & 0xf) << (i % 2 == 0 ? 4 : 0);
 }
 
+unsigned short UplinkPhase::getAndUpdateCurrentNode()
+{
+    if(discoveryInterval == 0)
+    {
+        auto currentNode = nextNode;
+        if (nextNode == 0) nextNode = nodesCount - 1;
+        else nextNode--;
+        return currentNode;
+    }
 
-void UplinkPhase::receiveUplink(long long slotStart, unsigned char currentNode)
+    // NOTE: the slot owner only depends on the absolute uplink counter and on
+    // the live nodes, so all nodes that received the last timesync agree
+    auto counter = uplinkCounter++;
+    if(liveNodesKnown == false) return noNode;
+    if(counter % discoveryInterval == discoveryInterval - 1u && !absentNodes.empty())
+        return absentNodes[(counter / discoveryInterval) % absentNodes.size()];
+    auto& group = liveGroups[counter % liveGroups.size()];
+    if(group.size() == 1) return group.front();
+    if(std::find(group.begin(), group.end(), myId) != group.end()) return myId;
+    slotOwners = group;
+    return multipleNodes;
+}
+
+
+void UplinkPhase::receiveUplink(long long slotStart, unsigned short currentNode)
 {
     ReceiveUplinkMessage message(ctx.getNetworkConfig());
     
     ctx.configureTransceiver(ctx.getTransceiverConfig());
-    if(message.recv(ctx, slotStart))
+    const bool sharedSlot = currentNode == multipleNodes;
+    bool received = message.recv(ctx, slotStart);
+    if(received && sharedSlot)
+    {
+        // In a shared slot the sender is taken from the message, but only if
+        // it is one of the nodes the slot is assigned to
+        currentNode = message.getSender();
+        received = std::find(slotOwners.begin(), slotOwners.end(), currentNode) != slotOwners.end();
+    }
+    if(received)
     {
-        auto numPackets = message.getNumPackets();
         TopologyElement senderTopology = message.getSenderTopology(currentNode);
+        ctx.getMACTrace().event(MACTraceEvent::UPLINK_RECV, StreamId(),
+                                currentNode, message.getRssi());
         myNeighborTable.receivedMessage(message.getHop(), message.getRssi(),
                                     message.getBadAssignee(), senderTopology);
         
@@ -83,22 +153,27 @@ void UplinkPhase::receiveUplink(long long slotStart, unsigned char currentNode)
     
         if(message.getAssignee() == myId)
         {
+            syncWindowReport = std::max(syncWindowReport, message.getSyncWindow());
             topologyQueue.enqueue(currentNode, std::move(senderTopology));
             message.deserializeTopologiesAndSMEs(topologyQueue, smeQueue);
             
-            for(int i = 1; i < numPackets; i++)
+            auto maxPackets = ctx.getNetworkConfig().getNumUplinkPackets();
+            for(int i = 1; i < maxPackets && message.hasMorePackets(); i++)
             {
                 // NOTE: If we fail to receive a Packet of the UplinkMessage,
                 // do not wait for remaining packets
-                // TODO verify that packetArrivalAndProcessingTime + transmissionInterval are correct
-                slotStart += packetArrivalAndProcessingTime + transmissionInterval;
+                slotStart += getPacketInterval(ctx.getNetworkConfig());
                 if(message.recv(ctx, slotStart) == false) break;
                 message.deserializeTopologiesAndSMEs(topologyQueue, smeQueue);
             }
         }
         
+    } else if(sharedSlot) {
+        for(auto node : slotOwners) myNeighborTable.missedMessage(node);
+        ctx.getMACTrace().event(MACTraceEvent::UPLINK_MISS, StreamId(), slotOwners.front());
     } else {
         myNeighborTable.missedMessage(currentNode);
+        ctx.getMACTrace().event(MACTraceEvent::UPLINK_MISS, StreamId(), currentNode);
         
         if(ENABLE_TOPOLOGY_DYN_SHORT_SUMMARY)
             print_dbg("  %d\n",currentNode);
@@ -35,6 +35,8 @@
 #include "../util/updatable_queue.h"
 #include "topology/topology_element.h"
 #include "topology/neighbor_table.h"
+#include <vector>
+#include <algorithm>
 
 namespace mxnet {
 
@@ -46,6 +48,18 @@ namespace mxnet {
  * send its Uplink Messages, all the other nodes will listen for incoming
  * Uplink Messages constructing their neighbor tables and forwarding them to the
  * master.
+ *
+ * If NetworkConfiguration::getUplinkDiscoveryInterval() is not zero, the
+ * round-robin only visits the nodes that the master advertises as present in
+ * the network through the timesync packet, and one every
+ * getUplinkDiscoveryInterval() uplink slots is a discovery slot assigned in
+ * turn to the absent node ids, so that new nodes can join.
+ *
+ * If NetworkConfiguration::getUplinkSpatialReuse() is also enabled, the master
+ * assigns nodes that are at least three hops apart in the union of the strong
+ * and weak network graph to the same uplink group, and all the nodes of a
+ * group transmit in the same uplink slot. Since the receivers can't know which
+ * of them they are hearing, the uplink message then carries the sender id.
  */
 class UplinkPhase : public MACPhase
 {
@@ -56,9 +70,17 @@ public:
     /**
      * \return the duration in nanoseconds of an uplink slot
      */
-    static unsigned long long getDuration(unsigned char numUplinkPackets)
+    static unsigned long long getDuration(const NetworkConfiguration& config)
+    {
+        return getPacketInterval(config) * config.getNumUplinkPackets();
+    }
+
+    /**
+     * \return the time in nanoseconds between two packets of an uplink message
+     */
+    static long long getPacketInterval(const NetworkConfiguration& config)
     {
-        return (packetArrivalAndProcessingTime + transmissionInterval) * numUplinkPackets;
+        return config.getSlotTimings().getUplinkPacketProcessing() + transmissionInterval;
     }
 
     /**
@@ -72,10 +94,80 @@ public:
      * state without causing packet transmissions/receptions.
      */
     void advance(long long slotStart) override { getAndUpdateCurrentNode(); }
+
+    /**
+     * Set the nodes that are present in the network, used by the adaptive
+     * round-robin. Called every time a timesync packet is sent or received.
+     * \param data NetworkConfiguration::getLiveNodesSize() bytes, either a
+     * live node bitmap (see encodeLiveNodes()), or if uplink spatial reuse
+     * is enabled 4 bits per node, the first node in the most significant
+     * nibble, with the uplink group of the node (see encodeUplinkGroups())
+     */
+    void setLiveNodes(const unsigned char *data);
+
+    /**
+     * Called when the timesync packet carrying the live node bitmap is missed.
+     * Since the node can't know who the uplink slots belong to, it neither
+     * transmits nor listens in the uplink until the next timesync is received.
+     */
+    void liveNodesUnknown() { liveNodesKnown = false; }
+
+    /**
+     * Only meaningful in the master node, recomputes the live nodes
+     * from the collected topology and applies them with setLiveNodes()
+     */
+    virtual void updateLiveNodes() {}
+
+    /**
+     * Only meaningful with the adaptive clock sync period
+     * \return the largest sync window in microseconds reported since the last
+     * call by the nodes having this node as assignee, or 0 if none was
+     */
+    unsigned short takeSyncWindowReport() {
+        unsigned short result = syncWindowReport;
+        syncWindowReport = 0;
+        return result;
+    }
+
+    /**
+     * \return the live nodes, in the format accepted by setLiveNodes()
+     */
+    const std::vector<unsigned char>& getLiveNodes() const { return liveNodeData; }
+
+    /**
+     * Uplink group values, as returned by NetworkTopology::getUplinkGroups()
+     * and encoded in the timesync packet when uplink spatial reuse is enabled
+     */
+    static const unsigned char absentGroup = 0;   ///< The node is absent
+    static const unsigned char maxSharedGroup = 14; ///< Groups 1 to 14 share a slot
+    static const unsigned char ownSlotGroup = 15; ///< The node has its own slot
+
+    /**
+     * Pack one uplink group value per node, 4 bits each, as accepted by
+     * setLiveNodes() when uplink spatial reuse is enabled
+     */
+    static void encodeUplinkGroups(const std::vector<unsigned char>& groups,
+                                   std::vector<unsigned char>& data);
+
+    /**
+     * Pack the live node bitmap, one bit per node, the first node in the most
+     * significant bit, as accepted by setLiveNodes(). The bit order within a
+     * byte of a RuntimeBitset depends on the architecture, so its raw data
+     * can't be sent as it is
+     */
+    static void encodeLiveNodes(const RuntimeBitset& live, std::vector<unsigned char>& data) {
+        std::fill(data.begin(), data.end(), 0);
+        for(auto i : live.setBits()) data[i / 8] |= 0x80 >> (i % 8);
+    }
+
+    /**
+     * \return true if node is set in a bitmap packed by encodeLiveNodes()
+     */
+    static bool isLiveNode(const unsigned char *data, unsigned int node) {
+        return (data[node / 8] >> (7 - node % 8)) & 1;
+    }
     
-    //TODO: check the duration calculation, it is currently hardcoded
     static const int transmissionInterval = 1000000; //1ms
-    static const int packetArrivalAndProcessingTime = 5000000;//32 us * 127 B + tp = 5ms
     
 protected:
     UplinkPhase(MACContext& ctx, StreamManager* const streamMgr) :
@@ -83,30 +175,55 @@ protected:
             streamMgr(streamMgr),
             myId(ctx.getNetworkId()),
             nodesCount(ctx.getNetworkConfig().getMaxNodes()),
+            discoveryInterval(ctx.getNetworkConfig().getUplinkDiscoveryInterval()),
             nextNode(nodesCount - 1),
+            uplinkCounter(0),
+            liveNodesKnown(false),
+            syncWindowReport(0),
+            liveNodeData(ctx.getNetworkConfig().getLiveNodesSize(), 0),
             myNeighborTable(ctx.getNetworkConfig(),
                             ctx.getNetworkId(),
                             ctx.getHop()) {}
-    
+
 
     /**
      * Starts expecting a message from the node to which the slot is assigned
      * and modifies the TopologyContext as needed.
+     * \param currentNode as returned by getAndUpdateCurrentNode(), if it is
+     * multipleNodes the message is expected from one of the slotOwners
      */
-    void receiveUplink(long long slotStart, unsigned char currentNode);
+    void receiveUplink(long long slotStart, unsigned short currentNode);
 
     /**
      * Called at every execute() or advance() updates the state of the
      * round-robin scheme used for uplink.
-     * \return which node id is expected to transmit in this uplink
+     * \return which node id is expected to transmit in this uplink, myId if
+     * this node is one of the nodes sharing the slot, multipleNodes if the
+     * slot is shared by other nodes (stored in slotOwners), or noNode if the
+     * slot owner is unknown
      */
-    unsigned char getAndUpdateCurrentNode();
+    unsigned short getAndUpdateCurrentNode();
+
+    // NOTE: the values are out of the unsigned char range, as with 256 nodes
+    // all of them are valid node ids
+    /// Returned by getAndUpdateCurrentNode() when the slot owner is unknown
+    static const unsigned short noNode = 0x100;
+    /// Returned by getAndUpdateCurrentNode() when the slot is shared
+    static const unsigned short multipleNodes = 0x101;
     
     StreamManager* const streamMgr; ///< Used to get SMEs
     const unsigned char myId;       ///< Cached NetworkId of this node
-    const unsigned char nodesCount; ///< Cached NetworkConfiguration::getMaxNodes()
+    const unsigned short nodesCount; ///< Cached NetworkConfiguration::getMaxNodes()
+    const unsigned char discoveryInterval; ///< Cached NetworkConfiguration::getUplinkDiscoveryInterval()
     
     unsigned char nextNode;         ///< Next node to talk in the round-robin
+    unsigned long long uplinkCounter; ///< Uplink slots since network time 0, for the adaptive round-robin
+    bool liveNodesKnown;            ///< False if the last live nodes were missed
+    unsigned short syncWindowReport; ///< Largest sync window received, see takeSyncWindowReport()
+    std::vector<unsigned char> liveNodeData; ///< Last live nodes advertised by the master
+    std::vector<std::vector<unsigned char>> liveGroups; ///< Nodes transmitting in each slot of the round-robin
+    std::vector<unsigned char> absentNodes; ///< Absent nodes, in descending id order
+    std::vector<unsigned char> slotOwners;  ///< Nodes sharing the current slot
     // Queues used in dynamic nodes to collect and forward topologies and sme
     // and in master node to process received topologies and sme
     UpdatableQueue<unsigned char,TopologyElement> topologyQueue;
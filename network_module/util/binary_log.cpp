@@ -0,0 +1,335 @@
+/***************************************************************************
+ *   Copyright (C) 2019 by Federico Terraneo                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   As a special exception, if other files instantiate templates or use   *
+ *   macros or inline functions from this file, or you compile this file   *
+ *   and link it with other works to produce a work based on this file,    *
+ *   this file does not by itself cause the resulting work to be covered   *
+ *   by the GNU General Public License. However the source code for this   *
+ *   file must still be made available in accordance with the GNU General  *
+ *   Public License. This exception does not invalidate any other reasons  *
+ *   why a work based on this file might be covered by the GNU General     *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ ***************************************************************************/
+
+#include "binary_log.h"
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#ifdef _MIOSIX
+#include <interfaces/atomic_ops.h>
+#endif //_MIOSIX
+
+using namespace std;
+
+namespace mxnet {
+
+/**
+ * Type of the argument consumed by a conversion specifier
+ */
+enum class ArgType
+{
+    NONE, INT, LONG, LONGLONG, SIZE, DOUBLE, LONGDOUBLE, POINTER, STRING
+};
+
+/**
+ * Parse a conversion specifier
+ * \param p pointer to the character after the '%'
+ * \param stars number of '*' in the specifier, each consuming an int
+ * \return pointer to the conversion character, or nullptr if the format
+ * string ends before it
+ */
+static const char *parseSpecifier(const char *p, ArgType& type, int& stars)
+{
+    stars = 0;
+    while(*p && strchr("-+ #0", *p)) p++;
+    if(*p == '*') { stars++; p++; }
+    while(*p >= '0' && *p <= '9') p++;
+    if(*p == '.')
+    {
+        p++;
+        if(*p == '*') { stars++; p++; }
+        while(*p >= '0' && *p <= '9') p++;
+    }
+    int longs = 0;
+    bool sizeModifier = false, longDouble = false;
+    for(;;)
+    {
+        if(*p == 'l') longs++;
+        else if(*p == 'z' || *p == 'j' || *p == 't') sizeModifier = true;
+        else if(*p == 'L') longDouble = true;
+        else if(*p != 'h') break;
+        p++;
+    }
+    switch(*p)
+    {
+        case '\0':
+            return nullptr;
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+            if(sizeModifier) type = ArgType::SIZE;
+            else if(longs >= 2) type = ArgType::LONGLONG;
+            else if(longs == 1) type = ArgType::LONG;
+            else type = ArgType::INT;
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            type = longDouble ? ArgType::LONGDOUBLE : ArgType::DOUBLE;
+            break;
+        case 's':
+            type = ArgType::STRING;
+            break;
+        case 'p': case 'n':
+            type = ArgType::POINTER;
+            break;
+        default: // Includes %%
+            type = ArgType::NONE;
+            break;
+    }
+    return p;
+}
+
+static unsigned int argSize(ArgType type)
+{
+    switch(type)
+    {
+        case ArgType::INT:        return sizeof(int);
+        case ArgType::LONG:       return sizeof(long);
+        case ArgType::LONGLONG:   return sizeof(long long);
+        case ArgType::SIZE:       return sizeof(size_t);
+        case ArgType::DOUBLE:     return sizeof(double);
+        case ArgType::LONGDOUBLE: return sizeof(long double);
+        case ArgType::POINTER:    return sizeof(void*);
+        default:                  return 0;
+    }
+}
+
+//
+// class BinaryLogRecord
+//
+
+void BinaryLogRecord::encode(const char *fmt, va_list args)
+{
+    this->fmt = fmt;
+    argsSize = 0;
+    truncated = false;
+    for(const char *p = fmt; *p; p++)
+    {
+        if(*p != '%') continue;
+        ArgType type;
+        int stars;
+        p = parseSpecifier(p + 1, type, stars);
+        if(p == nullptr) break;
+        for(int i = 0; i < stars; i++)
+        {
+            int star = va_arg(args, int);
+            if(argsSize + sizeof(int) > maxArgsSize) { truncated = true; return; }
+            memcpy(&this->args[argsSize], &star, sizeof(int));
+            argsSize += sizeof(int);
+        }
+        if(type == ArgType::STRING)
+        {
+            const char *s = va_arg(args, const char*);
+            if(s == nullptr) s = "(null)";
+            if(argsSize >= maxArgsSize) { truncated = true; return; }
+            // Copy the string, truncating it if needed
+            size_t fullLen = strlen(s);
+            unsigned int len = min<size_t>(fullLen, maxArgsSize - argsSize - 1);
+            if(len < fullLen) truncated = true;
+            memcpy(&this->args[argsSize], s, len);
+            this->args[argsSize + len] = '\0';
+            argsSize += len + 1;
+            continue;
+        }
+        unsigned int size = argSize(type);
+        if(argsSize + size > maxArgsSize) { truncated = true; return; }
+        unsigned char *dst = &this->args[argsSize];
+        switch(type)
+        {
+            case ArgType::INT:        { int v = va_arg(args, int); memcpy(dst, &v, size); break; }
+            case ArgType::LONG:       { long v = va_arg(args, long); memcpy(dst, &v, size); break; }
+            case ArgType::LONGLONG:   { long long v = va_arg(args, long long); memcpy(dst, &v, size); break; }
+            case ArgType::SIZE:       { size_t v = va_arg(args, size_t); memcpy(dst, &v, size); break; }
+            case ArgType::DOUBLE:     { double v = va_arg(args, double); memcpy(dst, &v, size); break; }
+            case ArgType::LONGDOUBLE: { long double v = va_arg(args, long double); memcpy(dst, &v, size); break; }
+            case ArgType::POINTER:    { void *v = va_arg(args, void*); memcpy(dst, &v, size); break; }
+            default: break;
+        }
+        argsSize += size;
+    }
+}
+
+int BinaryLogRecord::format(char *str, int size) const
+{
+    if(size <= 0) return 0;
+    int written = 0;
+    unsigned int argPos = 0;
+    const char *p = fmt;
+    // Append the result of snprintf, which returns the untruncated length
+    auto advance = [&](int result) {
+        if(result > 0) written = min(written + result, size - 1);
+    };
+    while(*p && written < size - 1)
+    {
+        if(*p != '%')
+        {
+            str[written++] = *p++;
+            continue;
+        }
+        ArgType type;
+        int stars;
+        const char *end = parseSpecifier(p + 1, type, stars);
+        if(end == nullptr) break;
+        // Format one conversion specifier at a time
+        char spec[16];
+        unsigned int specLen = min<size_t>(end - p + 1, sizeof(spec) - 1);
+        memcpy(spec, p, specLen);
+        spec[specLen] = '\0';
+        p = end + 1;
+        int starValues[2] = {0, 0};
+        unsigned int needed = stars * sizeof(int) + argSize(type);
+        if(argPos + needed > argsSize) break; // Truncated record
+        for(int i = 0; i < stars; i++)
+        {
+            memcpy(&starValues[i], &args[argPos], sizeof(int));
+            argPos += sizeof(int);
+        }
+        char *dst = str + written;
+        int room = size - written;
+        #define FORMAT_ARG(T) { \
+            T v; memcpy(&v, &args[argPos], sizeof(T)); argPos += sizeof(T); \
+            if(stars == 2) advance(snprintf(dst, room, spec, starValues[0], starValues[1], v)); \
+            else if(stars == 1) advance(snprintf(dst, room, spec, starValues[0], v)); \
+            else advance(snprintf(dst, room, spec, v)); }
+        switch(type)
+        {
+            case ArgType::NONE:
+                advance(snprintf(dst, room, "%s", spec[specLen - 1] == '%' ? "%" : ""));
+                break;
+            case ArgType::INT:        FORMAT_ARG(int); break;
+            case ArgType::LONG:       FORMAT_ARG(long); break;
+            case ArgType::LONGLONG:   FORMAT_ARG(long long); break;
+            case ArgType::SIZE:       FORMAT_ARG(size_t); break;
+            case ArgType::DOUBLE:     FORMAT_ARG(double); break;
+            case ArgType::LONGDOUBLE: FORMAT_ARG(long double); break;
+            case ArgType::POINTER:
+            {
+                void *v;
+                memcpy(&v, &args[argPos], sizeof(void*));
+                argPos += sizeof(void*);
+                // %n must not be executed on a stored pointer
+                if(spec[specLen - 1] == 'p') advance(snprintf(dst, room, "%p", v));
+                break;
+            }
+            case ArgType::STRING:
+            {
+                const char *v = reinterpret_cast<const char*>(&args[argPos]);
+                argPos += strlen(v) + 1;
+                if(stars == 2) advance(snprintf(dst, room, spec, starValues[0], starValues[1], v));
+                else if(stars == 1) advance(snprintf(dst, room, spec, starValues[0], v));
+                else advance(snprintf(dst, room, spec, v));
+                break;
+            }
+        }
+        #undef FORMAT_ARG
+    }
+    if(truncated && written < size - 1)
+        advance(snprintf(str + written, size - written, "[truncated]\n"));
+    str[written] = '\0';
+    return written;
+}
+
+void BinaryLogRecord::dump(char *str) const
+{
+    uint32_t address = reinterpret_cast<uintptr_t>(fmt);
+    unsigned char bytes[4] = {
+        static_cast<unsigned char>(address),
+        static_cast<unsigned char>(address >> 8),
+        static_cast<unsigned char>(address >> 16),
+        static_cast<unsigned char>(address >> 24)
+    };
+    const char hex[] = "0123456789abcdef";
+    for(int i = 0; i < 4; i++)
+    {
+        *str++ = hex[bytes[i] >> 4];
+        *str++ = hex[bytes[i] & 0xf];
+    }
+    for(unsigned int i = 0; i < argsSize; i++)
+    {
+        *str++ = hex[args[i] >> 4];
+        *str++ = hex[args[i] & 0xf];
+    }
+    *str = '\0';
+}
+
+//
+// class BinaryLogQueue
+//
+
+static inline bool compareAndSwap(volatile int *p, int prev, int next)
+{
+#ifdef _MIOSIX
+    return miosix::atomicCompareAndSwap(p, prev, next) == prev;
+#else //_MIOSIX
+    return __atomic_compare_exchange_n(p, &prev, next, false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif //_MIOSIX
+}
+
+static inline void increment(volatile int *p)
+{
+#ifdef _MIOSIX
+    miosix::atomicAdd(p, 1);
+#else //_MIOSIX
+    __atomic_add_fetch(p, 1, __ATOMIC_ACQ_REL);
+#endif //_MIOSIX
+}
+
+bool BinaryLogQueue::push(const char *fmt, va_list args)
+{
+    // Claim a record, the unsigned difference works across wraparound
+    int h;
+    do {
+        h = head;
+        if(static_cast<unsigned int>(h - tail) >= queueSize)
+        {
+            increment(&dropped);
+            return false;
+        }
+    } while(compareAndSwap(&head, h, h + 1) == false);
+
+    BinaryLogRecord& record = records[static_cast<unsigned int>(h) % queueSize];
+    record.encode(fmt, args);
+    __atomic_store_n(&record.ready, 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool BinaryLogQueue::pop(BinaryLogRecord& record)
+{
+    BinaryLogRecord& next = records[static_cast<unsigned int>(tail) % queueSize];
+    if(__atomic_load_n(&next.ready, __ATOMIC_ACQUIRE) == 0) return false;
+    maxUsed = max(maxUsed, static_cast<unsigned int>(head - tail));
+    record.fmt = next.fmt;
+    record.argsSize = next.argsSize;
+    record.truncated = next.truncated;
+    memcpy(record.args, next.args, next.argsSize);
+    __atomic_store_n(&next.ready, 0, __ATOMIC_RELAXED);
+    // Release the record to the producers only after having copied it
+    __atomic_store_n(&tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+} //namespace mxnet
@@ -0,0 +1,135 @@
+/***************************************************************************
+ *   Copyright (C) 2019 by Federico Terraneo                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   As a special exception, if other files instantiate templates or use   *
+ *   macros or inline functions from this file, or you compile this file   *
+ *   and link it with other works to produce a work based on this file,    *
+ *   this file does not by itself cause the resulting work to be covered   *
+ *   by the GNU General Public License. However the source code for this   *
+ *   file must still be made available in accordance with the GNU General  *
+ *   Public License. This exception does not invalidate any other reasons  *
+ *   why a work based on this file might be covered by the GNU General     *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ ***************************************************************************/
+
+#pragma once
+
+#include <cstdarg>
+
+namespace mxnet {
+
+/**
+ * A print_dbg call stored in binary form: the format string pointer and the
+ * raw bytes of the arguments, in the order they appear in the format string.
+ * Strings are copied null-terminated, since they may not outlive the call.
+ */
+class BinaryLogRecord
+{
+public:
+    BinaryLogRecord() : fmt(""), argsSize(0), truncated(false), ready(0) {}
+
+    /**
+     * Store a print_dbg call. Only scans the format string for conversion
+     * specifiers, the actual formatting is done later by format()
+     * \param fmt format string, must be a string literal
+     * \param args arguments
+     */
+    void encode(const char *fmt, va_list args);
+
+    /**
+     * Format the record
+     * \param str output buffer
+     * \param size output buffer size
+     * \return the number of characters written, excluding the terminator
+     */
+    int format(char *str, int size) const;
+
+    /**
+     * \return the format string pointer
+     */
+    const char *getFormat() const { return fmt; }
+
+    /**
+     * \return true if arguments were dropped or a string argument was
+     * shortened because they did not fit in maxArgsSize
+     */
+    bool isTruncated() const { return truncated; }
+
+    /**
+     * Hex dump of the record to be decoded offline, with the format string
+     * pointer as a 32 bit little endian value followed by the argument bytes
+     * \param str output buffer, at least 2*(4+maxArgsSize)+1 bytes
+     */
+    void dump(char *str) const;
+
+    /// Maximum size of the arguments of a record, longer ones are truncated.
+    /// Fits the [MT] line of MACTrace::print(), the longest print_dbg with
+    /// fixed size arguments (57 bytes), long strings need to be split
+    static const unsigned int maxArgsSize = 64;
+
+private:
+    friend class BinaryLogQueue;
+
+    const char *fmt;
+    unsigned char argsSize;
+    bool truncated;
+    volatile unsigned char ready; ///< Written last by the producer
+    unsigned char args[maxArgsSize];
+};
+
+/**
+ * Lock-free queue of BinaryLogRecord, many threads can push records
+ * concurrently but only one can pop them. Records are dropped if it is full.
+ */
+class BinaryLogQueue
+{
+public:
+    BinaryLogQueue() : head(0), tail(0), dropped(0), maxUsed(0) {}
+
+    /**
+     * Enqueue a print_dbg call
+     * \return false if the queue is full
+     */
+    bool push(const char *fmt, va_list args);
+
+    /**
+     * Dequeue a record, can only be called by one thread
+     * \return false if the queue is empty
+     */
+    bool pop(BinaryLogRecord& record);
+
+    /**
+     * \return the number of records dropped because the queue was full
+     */
+    unsigned int getDropped() const { return dropped; }
+
+    /**
+     * \return the maximum number of records that were queued
+     */
+    unsigned int getMaxUsed() const { return maxUsed; }
+
+    /// Number of records, a power of two
+    static const unsigned int queueSize = 64;
+
+private:
+    volatile int head; ///< Next record to be claimed by a producer
+    volatile int tail; ///< Next record to be popped
+    volatile int dropped;
+    unsigned int maxUsed;
+    BinaryLogRecord records[queueSize];
+};
+
+} //namespace mxnet
@@ -26,12 +26,10 @@
  ***************************************************************************/
 
 #include "debug_settings.h"
+#include "binary_log.h"
 #include <cstdarg>
 #include <cstdio>
 #include <stdexcept>
-#include <queue>
-#include <list>
-#include <string>
 #ifdef _MIOSIX
 #include <miosix.h>
 #include <unistd.h>
@@ -50,15 +48,20 @@ namespace mxnet {
 /*
  * Threaded logger configuration parameters
  */
-const unsigned int maxMessageSize=128;  ///< Max size of individual debug message
-const unsigned int maxQueueSize=2*1024; ///< Max size of queued logging data
+const unsigned int maxMessageSize=160; ///< Max size of individual debug message
+const unsigned int pollPeriod=10;      ///< Milliseconds between queue polls
 
+/**
+ * The print_dbg() calls are stored in binary form in a lock-free queue, so
+ * that the calling thread, most notably the MAC thread, only pays for copying
+ * the arguments. The formatting is done here, in a separate thread
+ */
 class DebugPrinter
 {
 public:
     static DebugPrinter& instance();
     
-    void enqueue(const string& s);
+    void enqueue(const char *fmt, va_list args) { queue.push(fmt, args); }
     
 private:
     DebugPrinter(const DebugPrinter&) = delete;
@@ -71,11 +74,7 @@ private:
     static void threadLauncher(void *argv);
     
     Thread *thread;
-    FastMutex mutex;
-    ConditionVariable cv;
-    queue<string,list<string>> messages;
-    unsigned int size=0;
-    unsigned int maxSize=0;
+    BinaryLogQueue queue;
 };
 
 DebugPrinter& DebugPrinter::instance()
@@ -84,38 +83,43 @@ DebugPrinter& DebugPrinter::instance()
     return singleton;
 }
 
-void DebugPrinter::enqueue(const string& s)
-{
-    Lock<FastMutex> l(mutex);
-    if(size + s.size() > maxQueueSize) return;
-    messages.push(s);
-    size += s.size();
-    maxSize = max(maxSize,size);
-    cv.signal();
-}
-
 void DebugPrinter::run()
 {
     printStackRange("DebugPrinter");
     const int logMaxSize = 10000; //Log max size every 10000 print_dbg
     int logCounter = 0;
+    unsigned int lastDropped = 0;
+    BinaryLogRecord record;
+    char str[maxMessageSize];
+    static_assert(sizeof(str) >= 2*(4+BinaryLogRecord::maxArgsSize)+1,"");
     for(;;)
     {
-        string s;
+        // Polling, as waking up this thread would make print_dbg() block
+        while(queue.pop(record)==false) Thread::sleep(pollPeriod);
+        if(BINARY_LOG_RAW_DUMP)
+        {
+            record.dump(str);
+            printf("[BL] %s%s\n",str,record.isTruncated() ? " t" : "");
+        } else {
+            record.format(str,sizeof(str));
+            printf("%s",str);
+        }
+        // Report drops right away, they happened while the queue was full so
+        // the missing records are within queueSize of this point in the log
+        unsigned int dropped = queue.getDropped();
+        if(dropped != lastDropped)
         {
-            Lock<FastMutex> l(mutex);
-            while(messages.empty()) cv.wait(l);
-            s=messages.front();
-            messages.pop();
-            size -= s.size();
+            printf("[L] dropped %u print_dbg records\n",dropped-lastDropped);
+            lastDropped = dropped;
         }
-        printf("%s",s.c_str());
         if(++logCounter >= logMaxSize)
         {
             logCounter = 0;
             unsigned int stackSize = miosix::MemoryProfiling::getStackSize();
             unsigned int absFreeStack = miosix::MemoryProfiling::getAbsoluteFreeStack();
-            printf("[L] log max size %d, stack %d/%d\n",maxSize,stackSize-absFreeStack,stackSize);
+            printf("[L] log max size %d/%d dropped %d, stack %d/%d\n",
+                   queue.getMaxUsed(),BinaryLogQueue::queueSize,queue.getDropped(),
+                   stackSize-absFreeStack,stackSize);
         }
     }
 }
@@ -128,12 +132,9 @@ void DebugPrinter::threadLauncher(void *argv)
 void print_dbg(const char *fmt, ...)
 {
     va_list args;
-    char str[maxMessageSize];
     va_start(args, fmt);
-    vsnprintf(str, sizeof(str)-1, fmt, args);
+    DebugPrinter::instance().enqueue(fmt, args);
     va_end(args);
-    str[sizeof(str)-1]='\0';
-    DebugPrinter::instance().enqueue(str);
 }
 
 #else //DEBUG_MESSAGES_IN_SEPARATE_THREAD
@@ -0,0 +1,109 @@
+/***************************************************************************
+ *   Copyright (C) 2019 by Federico Terraneo                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   As a special exception, if other files instantiate templates or use   *
+ *   macros or inline functions from this file, or you compile this file   *
+ *   and link it with other works to produce a work based on this file,    *
+ *   this file does not by itself cause the resulting work to be covered   *
+ *   by the GNU General Public License. However the source code for this   *
+ *   file must still be made available in accordance with the GNU General  *
+ *   Public License. This exception does not invalidate any other reasons  *
+ *   why a work based on this file might be covered by the GNU General     *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ ***************************************************************************/
+
+#pragma once
+
+namespace mxnet {
+
+/**
+ * Type of an EventRecord, and meaning of its arg and value fields
+ */
+enum class EventType : unsigned char
+{
+    NODE_START,     ///< Node switched on (simulator only)
+    NODE_STOP,      ///< Node switched off (simulator only)
+    NETWORK_LINK,   ///< Link of the simulated network, arg is a<<8|b (simulator only)
+    TOPOLOGY,       ///< The master updated the topology, arg is the number of links
+    LINK_UP,        ///< Link added to the master topology, arg is a<<8|b, a<b
+    LINK_DOWN,      ///< Link removed from the master topology, arg is a<<8|b, a<b
+    TIMESYNC,       ///< Timesync packet received, value is the clock error in ns
+    SCHEDULE,       ///< Schedule activated, arg is the schedule id
+    STREAM_STATE,   ///< Stream status changed, arg is the stream key, value the StreamStatus
+    PACKET_RECV,    ///< Stream packet received, arg is the stream key, value the RSSI
+    PACKET_MISS,    ///< Stream packet missed, arg is the stream key
+    NUM_TYPES
+};
+
+/**
+ * A structured event, to compute metrics such as the topology convergence
+ * time without parsing the print_dbg output. Written in binary form in host
+ * byte order, to be read by simulator/tools/event_analyzer
+ */
+struct EventRecord
+{
+    long long time;   ///< Network time in ns
+    unsigned int arg; ///< Depends on type
+    short value;      ///< Depends on type, saturated
+    unsigned char node;
+    EventType type;
+};
+
+static_assert(sizeof(EventRecord) == 16, "EventRecord must be 16 bytes");
+
+/**
+ * The structured event stream. Events are passed to a sink set by the
+ * platform, that also fills in the node, and if no sink is set, as on the
+ * nodes, recording an event is just a test
+ */
+class EventLog
+{
+public:
+    /**
+     * Called with each event, must fill the node field and store it.
+     * Can be called concurrently by the MAC and application threads
+     */
+    typedef void (*Sink)(EventRecord& record);
+
+    /**
+     * \param s the sink, or nullptr to stop recording events
+     */
+    static void setSink(Sink s) { sink = s; }
+
+    /**
+     * \return true if events are recorded, to skip preparing them otherwise
+     */
+    static bool enabled() { return sink != nullptr; }
+
+    /**
+     * Record an event
+     * \param type event type
+     * \param time network time in ns
+     * \param arg depends on type
+     * \param value depends on type, saturated to the range of a short
+     */
+    static void record(EventType type, long long time, unsigned int arg = 0, long long value = 0)
+    {
+        if(sink) record(type, time, arg, value, sink);
+    }
+
+private:
+    static void record(EventType type, long long time, unsigned int arg, long long value, Sink s);
+
+    static Sink sink;
+};
+
+} // namespace mxnet
@@ -0,0 +1,58 @@
+/***************************************************************************
+ *   Copyright (C) 2019 by Federico Terraneo                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   As a special exception, if other files instantiate templates or use   *
+ *   macros or inline functions from this file, or you compile this file   *
+ *   and link it with other works to produce a work based on this file,    *
+ *   this file does not by itself cause the resulting work to be covered   *
+ *   by the GNU General Public License. However the source code for this   *
+ *   file must still be made available in accordance with the GNU General  *
+ *   Public License. This exception does not invalidate any other reasons  *
+ *   why a work based on this file might be covered by the GNU General     *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ ***************************************************************************/
+
+#pragma once
+
+/*
+ * The maximum number of nodes and hops are NetworkConfiguration parameters,
+ * so that the simulators can run networks of any size, and the bitsets and
+ * graphs sized on them are allocated and indexed at runtime. On the nodes the
+ * network size is fixed when building, so it can be fixed here too by
+ * defining TDMH_FIXED_MAX_NODES and TDMH_FIXED_MAX_HOPS to the maxNodes and
+ * maxHops passed to the NetworkConfiguration. Then:
+ * - RuntimeBitset keeps its bits in the object instead of the heap, so
+ *   TopologyElements, neighbor tables and uplink messages do not allocate
+ * - DenseNetworkGraph, used by NetworkTopology and the scheduler, is a fixed
+ *   size array with compile-time row stride
+ * - getMaxNodes(), getMaxHops() and the sizes derived from them are constants
+ * and constructing a NetworkConfiguration of a different size throws.
+ */
+#ifndef TDMH_FIXED_MAX_NODES
+//#define TDMH_FIXED_MAX_NODES 16
+#endif
+#ifndef TDMH_FIXED_MAX_HOPS
+//#define TDMH_FIXED_MAX_HOPS 6
+#endif
+
+#if defined(TDMH_FIXED_MAX_NODES) && \
+    (TDMH_FIXED_MAX_NODES <= 0 || TDMH_FIXED_MAX_NODES > 256 || TDMH_FIXED_MAX_NODES % 8 != 0)
+#error "TDMH_FIXED_MAX_NODES must be a multiple of 8, at most 256"
+#endif
+
+#if defined(TDMH_FIXED_MAX_HOPS) && (TDMH_FIXED_MAX_HOPS <= 0 || TDMH_FIXED_MAX_HOPS > 255)
+#error "TDMH_FIXED_MAX_HOPS must be between 1 and 255"
+#endif
@@ -69,42 +69,44 @@ void Packet::send(MACContext& ctx, long long sendTime) const {
 #endif
 }
 
-RecvResult Packet::recv(MACContext& ctx, long long tExpected, function<bool (const Packet& p, RecvResult r)> pred, Transceiver::Correct corr) {
-    RecvResult result;
-    long long timeout = infiniteTimeout;
+RecvResult Packet::recv(MACContext& ctx, long long tExpected, const function<bool (const Packet& p, RecvResult r)>& pred, Transceiver::Correct corr) {
+    return recv<const function<bool (const Packet& p, RecvResult r)>&>(ctx, tExpected, pred, corr);
+}
+
+bool Packet::recvWakeUp(MACContext& ctx, long long tExpected, long long& timeout) {
+    timeout = infiniteTimeout;
     if(tExpected != infiniteTimeout) {
         auto wakeUpTimeout = ctx.getTimesync()->getWakeupAndTimeout(tExpected);
         timeout = wakeUpTimeout.second;
         auto now = getTime();
         if(now > wakeUpTimeout.first) {
             print_dbg("Packet::recv: too late\n");
-            return result; // Returning RecvResult object with default values
+            return false;
         }
         ctx.sleepUntil(wakeUpTimeout.first);
     }
-    for(;;) {
+    return true;
+}
+
+RecvResult Packet::recvOnce(MACContext& ctx, long long timeout, Transceiver::Correct corr) {
 #ifdef _MIOSIX
-        redLed::high();
+    redLed::high();
 #endif
-        result = ctx.recv(packet.data(), maxSize(), timeout, corr);
+    auto result = ctx.recv(packet.data(), maxSize(), timeout, corr);
 #ifdef _MIOSIX
-        redLed::low();
+    redLed::low();
 #endif
-        if (ENABLE_PKT_INFO_DBG) {
-            if(result.size) {
-                print_dbg("Packet::recv: Received packet, error %d, size %d, timestampValid %d: ",
-                          result.error, result.size, result.timestampValid);
-                if (ENABLE_PKT_DUMP_DBG)
-                    memDump(packet.data(), result.size);
-            } else print_dbg("Packet::recv: No packet received, timeout reached\n");
-        }
-        if(result.error == RecvResult::ErrorCode::TIMEOUT)
-            break;
-
+    if (ENABLE_PKT_INFO_DBG) {
+        if(result.size) {
+            print_dbg("Packet::recv: Received packet, error %d, size %d, timestampValid %d: ",
+                      result.error, result.size, result.timestampValid);
+            if (ENABLE_PKT_DUMP_DBG)
+                memDump(packet.data(), result.size);
+        } else print_dbg("Packet::recv: No packet received, timeout reached\n");
+    }
+    if(result.error != RecvResult::ErrorCode::TIMEOUT) {
         dataStart = 0;
         dataSize = result.size;
-        if(result.error == RecvResult::ErrorCode::OK && pred(*this, result))
-            break;
     }
     return result;
 }
@@ -36,6 +36,8 @@
 #include <limits>
 #include <stdexcept>
 #include <functional>
+#include <type_traits>
+#include <cstring>
 
 namespace mxnet {
 
@@ -51,16 +53,77 @@ public:
     PacketUnderflowException(const std::string& err) : range_error(err) {}
 };
 
+/**
+ * Writes the fields of a message to a Packet without checking the space left
+ * for each of them, the space for the whole message is checked once by
+ * Packet::reserve()
+ */
+class PacketWriter {
+public:
+    template<typename T>
+    void put(const T& field) {
+        static_assert(std::is_trivially_copyable<T>::value, "");
+        put(&field, sizeof(T));
+    }
+
+    void put(const void* data, unsigned int size) {
+        assert(p + size <= end);
+        memcpy(p, data, size);
+        p += size;
+    }
+
+private:
+    friend class Packet;
+    PacketWriter(unsigned char *p, unsigned int size) : p(p), end(p + size) {}
+
+    unsigned char *p;
+    unsigned char *end; // Only used by asserts
+};
+
+/**
+ * Reads the fields of a message from a Packet without checking the bytes left
+ * for each of them, the bytes of the whole message are checked once by
+ * Packet::consume()
+ */
+class PacketReader {
+public:
+    template<typename T>
+    void get(T& field) {
+        static_assert(std::is_trivially_copyable<T>::value, "");
+        get(&field, sizeof(T));
+    }
+
+    void get(void* data, unsigned int size) {
+        assert(p + size <= end);
+        memcpy(data, p, size);
+        p += size;
+    }
+
+    unsigned char get() {
+        assert(p < end);
+        return *p++;
+    }
+
+private:
+    friend class Packet;
+    PacketReader(const unsigned char *p, unsigned int size) : p(p), end(p + size) {}
+
+    const unsigned char *p;
+    const unsigned char *end; // Only used by asserts
+};
+
 /** 
  * This class can be used to send a packet or receive a packet:
  * send methods:
  * - put()
+ * - reserve()
  * - available()
  * - send()
  * receive methods:
  * - recv()
  * - size()
  * - get()
+ * - consume()
  * - discard()
  */
 class Packet {
@@ -76,6 +139,32 @@ public:
 
     void get(void* data, unsigned int size);
 
+    /**
+     * Append size bytes to the packet, to be written through the returned
+     * PacketWriter. Used to serialize a message checking the space once
+     * \throws PacketOverflowException if there is not enough space
+     */
+    PacketWriter reserve(unsigned int size) {
+        if(size > available())
+            throw PacketOverflowException("Packet::reserve: Overflow!");
+        PacketWriter result(packet.data() + dataSize, size);
+        dataSize += size;
+        return result;
+    }
+
+    /**
+     * Remove size bytes from the packet, to be read through the returned
+     * PacketReader. Used to deserialize a message checking the size once
+     * \throws PacketUnderflowException if there are not enough bytes
+     */
+    PacketReader consume(unsigned int size) {
+        if(size > this->size())
+            throw PacketUnderflowException("Packet::consume: Underflow!");
+        PacketReader result(packet.data() + dataStart, size);
+        dataStart += size;
+        return result;
+    }
+
     /** 
      * When reading a packet, ignore "size" bytes
      */
@@ -113,19 +202,34 @@ public:
     void send(MACContext& ctx, long long sendTime) const;
 
     miosix::RecvResult recv(MACContext& ctx, long long tExpected) {
-        std::function<bool (const Packet& p, miosix::RecvResult r)> f;
-        f = [](const Packet&, miosix::RecvResult){ return true; };
-        return recv(ctx, tExpected, f);
+        return recv(ctx, tExpected, [](const Packet&, miosix::RecvResult){ return true; });
     }
 
     /*
      * The recv methods accepts an optional parameter, and keeps receiving packets
      * as long as the condition provided is false
      * This is useful to avoid calculating time offsets multiple times.
+     * The predicate is a template parameter so that it is called directly
+     * in the receive loop, use the std::function overload to pass it type-erased
      */
+    template<typename Pred>
+    miosix::RecvResult recv(MACContext& ctx, long long tExpected, Pred pred,
+                            miosix::Transceiver::Correct corr = miosix::Transceiver::Correct::CORR) {
+        long long timeout;
+        if(recvWakeUp(ctx, tExpected, timeout) == false)
+            return miosix::RecvResult(); // Returning RecvResult object with default values
+        for(;;) {
+            auto result = recvOnce(ctx, timeout, corr);
+            if(result.error == miosix::RecvResult::ErrorCode::TIMEOUT)
+                return result;
+            if(result.error == miosix::RecvResult::ErrorCode::OK && pred(*this, result))
+                return result;
+        }
+    }
+
     miosix::RecvResult recv(MACContext& ctx, long long tExpected,
-                            std::function<bool (const Packet& p, miosix::RecvResult r)> pred,
-                            miosix::Transceiver::Correct = miosix::Transceiver::Correct::CORR);
+                            const std::function<bool (const Packet& p, miosix::RecvResult r)>& pred,
+                            miosix::Transceiver::Correct corr = miosix::Transceiver::Correct::CORR);
 
     /*
      * The operator[] can be used to get the value of a given byte in the packet
@@ -177,6 +281,19 @@ private:
     std::array<unsigned char, MediumAccessController::maxPktSize> packet;
     // If this assert fail, increase size of dataSize and dataStart
     static_assert(MediumAccessController::maxPktSize <= std::numeric_limits<unsigned char>::max(), "");
+    /**
+     * Sleep until it is time to wake up to receive a packet expected at tExpected
+     * \param timeout set to the receive timeout
+     * \return false if it is too late to receive the packet
+     */
+    bool recvWakeUp(MACContext& ctx, long long tExpected, long long& timeout);
+
+    /**
+     * Receive a single packet, and unless the timeout is reached make it
+     * available for Packet::get()
+     */
+    miosix::RecvResult recvOnce(MACContext& ctx, long long timeout, miosix::Transceiver::Correct corr);
+
     unsigned char dataSize;
     unsigned char dataStart;
 };
@@ -30,12 +30,149 @@
 namespace mxnet {
 
 
-bool RuntimeBitset::empty() {
-    bool notEmpty = false;
-    for(unsigned int i=0; i<byteSize; i++) {
-        if(content[i]) notEmpty = true;
+/*
+ * The bulk operations access the content four bytes at a time. Loads and
+ * stores are done with memcpy since content is not guaranteed to be word
+ * aligned, the compiler turns them into single instructions. The bytes left
+ * when the size is not a multiple of four are handled one by one.
+ */
+
+static inline uint32_t loadWord(const uint8_t *p) {
+    uint32_t w;
+    memcpy(&w, p, sizeof(w));
+    return w;
+}
+
+static inline void storeWord(uint8_t *p, uint32_t w) {
+    memcpy(p, &w, sizeof(w));
+}
+
+#ifdef _ARCH_CORTEXM3_EFM32GG
+/*
+ * With bit-banding, bit i is bit i%8 of byte i/8 counted from the LSB, so the
+ * first set bit is found counting the trailing zeros
+ */
+
+static inline unsigned firstBitInByte(unsigned b) {
+    return __builtin_ctz(b);
+}
+
+static inline unsigned bitsFrom(unsigned bit) {
+    return (0xff << bit) & 0xff;
+}
+
+/*
+ * Loads a word such that bit 0 of the bitset, which is the LSB of the
+ * first byte, is the LSB of the word
+ */
+static inline uint32_t loadWordInBitOrder(const uint8_t *p) {
+    return static_cast<uint32_t>(p[3]) << 24 | static_cast<uint32_t>(p[2]) << 16
+         | static_cast<uint32_t>(p[1]) << 8  | static_cast<uint32_t>(p[0]);
+}
+
+static inline unsigned firstBitInWord(uint32_t w) {
+    return __builtin_ctz(w);
+}
+#else
+/*
+ * Bit i is bit i%8 of byte i/8 counted from the MSB, see b0, so the first
+ * set bit is found counting the leading zeros
+ */
+
+static inline unsigned firstBitInByte(unsigned b) {
+    return __builtin_clz(b) - 24;
+}
+
+static inline unsigned bitsFrom(unsigned bit) {
+    return 0xff >> bit;
+}
+
+/*
+ * Loads a word such that bit 0 of the bitset, which is the MSB of the
+ * first byte, is the MSB of the word, regardless of the endianness
+ */
+static inline uint32_t loadWordInBitOrder(const uint8_t *p) {
+    return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16
+         | static_cast<uint32_t>(p[2]) << 8  | static_cast<uint32_t>(p[3]);
+}
+
+static inline unsigned firstBitInWord(uint32_t w) {
+    return __builtin_clz(w);
+}
+#endif //_ARCH_CORTEXM3_EFM32GG
+
+bool RuntimeBitset::any() const {
+    std::size_t i = 0;
+    for(; i + 4 <= byteSize; i += 4)
+        if(loadWord(content + i)) return true;
+    for(; i < byteSize; i++)
+        if(content[i]) return true;
+    return false;
+}
+
+std::size_t RuntimeBitset::count() const {
+    std::size_t result = 0;
+    std::size_t i = 0;
+    for(; i + 4 <= byteSize; i += 4)
+        result += __builtin_popcount(loadWord(content + i));
+    for(; i < byteSize; i++)
+        result += __builtin_popcount(content[i]);
+    return result;
+}
+
+RuntimeBitset& RuntimeBitset::operator&=(const RuntimeBitset& other) {
+    if(other.bitCount != bitCount) throw std::range_error("runtime_bitset");
+    std::size_t i = 0;
+    for(; i + 4 <= byteSize; i += 4)
+        storeWord(content + i, loadWord(content + i) & loadWord(other.content + i));
+    for(; i < byteSize; i++) content[i] &= other.content[i];
+    return *this;
+}
+
+RuntimeBitset& RuntimeBitset::operator|=(const RuntimeBitset& other) {
+    if(other.bitCount != bitCount) throw std::range_error("runtime_bitset");
+    std::size_t i = 0;
+    for(; i + 4 <= byteSize; i += 4)
+        storeWord(content + i, loadWord(content + i) | loadWord(other.content + i));
+    for(; i < byteSize; i++) content[i] |= other.content[i];
+    return *this;
+}
+
+RuntimeBitset& RuntimeBitset::operator^=(const RuntimeBitset& other) {
+    if(other.bitCount != bitCount) throw std::range_error("runtime_bitset");
+    std::size_t i = 0;
+    for(; i + 4 <= byteSize; i += 4)
+        storeWord(content + i, loadWord(content + i) ^ loadWord(other.content + i));
+    for(; i < byteSize; i++) content[i] ^= other.content[i];
+    return *this;
+}
+
+RuntimeBitset& RuntimeBitset::andNot(const RuntimeBitset& other) {
+    if(other.bitCount != bitCount) throw std::range_error("runtime_bitset");
+    std::size_t i = 0;
+    for(; i + 4 <= byteSize; i += 4)
+        storeWord(content + i, loadWord(content + i) & ~loadWord(other.content + i));
+    for(; i < byteSize; i++) content[i] &= ~other.content[i];
+    return *this;
+}
+
+std::size_t RuntimeBitset::findNext(std::size_t from) const {
+    if(from >= bitCount) return bitCount;
+    std::size_t i = from >> shiftDivisor;
+    // First byte, masking the bits before from
+    unsigned b = content[i] & bitsFrom(from & 7);
+    if(b) return (i << shiftDivisor) + firstBitInByte(b);
+    i++;
+    // Align to a word boundary, then scan a word at a time
+    for(; i < byteSize && (i & 3); i++)
+        if(content[i]) return (i << shiftDivisor) + firstBitInByte(content[i]);
+    for(; i + 4 <= byteSize; i += 4) {
+        uint32_t w = loadWordInBitOrder(content + i);
+        if(w) return (i << shiftDivisor) + firstBitInWord(w);
     }
-    return !notEmpty;
+    for(; i < byteSize; i++)
+        if(content[i]) return (i << shiftDivisor) + firstBitInByte(content[i]);
+    return bitCount;
 }
 
 } /* namespace mxnet */
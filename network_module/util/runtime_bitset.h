@@ -28,6 +28,7 @@
 #pragma once
 
 #include "bitwise_ops.h"
+#include "network_size.h"
 #include <stdexcept>
 #include <limits>
 #include <cstring>
@@ -44,6 +45,8 @@ namespace mxnet {
  * So bits are ordered from 0 to n while the vector address increases.
  * In ARM the same memory, accesses by-word uses b0 as the MSB and b31 as the LSB.
  * Thus this order is respected, in order to grant cross-compatibility.
+ * If TDMH_FIXED_MAX_NODES is defined the memory is inside the object, and
+ * bitsets of more than TDMH_FIXED_MAX_NODES bits can't be created.
  */
 /**
  * Class representing a bit array of an arbitrary dimension.
@@ -72,7 +75,7 @@ public:
     explicit RuntimeBitset(std::size_t size) :
         bitCount(size),
         byteSize((size + 7) / 8),
-        content(new uint8_t[byteSize])
+        content(allocate())
 #ifdef _ARCH_CORTEXM3_EFM32GG
     , bbData(reinterpret_cast<unsigned*>(((reinterpret_cast<unsigned long>(content) - sramBase) << 5) + bitBandBase))
 #endif
@@ -95,7 +98,7 @@ public:
     RuntimeBitset(const RuntimeBitset& other) :
         bitCount(other.bitCount),
         byteSize(other.byteSize),
-        content(new uint8_t[byteSize])
+        content(allocate())
 #ifdef _ARCH_CORTEXM3_EFM32GG
         , bbData(reinterpret_cast<unsigned*>(((reinterpret_cast<unsigned long>(content) - sramBase) << 5) + bitBandBase))
 #endif
@@ -103,6 +106,7 @@ public:
         memcpy(content, other.content, byteSize);
     }
 
+#ifndef TDMH_FIXED_MAX_NODES
     RuntimeBitset(RuntimeBitset&& other) :
         bitCount(other.bitCount),
         byteSize(other.byteSize),
@@ -116,12 +120,14 @@ public:
         other.bbData = nullptr;
 #endif
     }
+#endif // TDMH_FIXED_MAX_NODES
 
     RuntimeBitset& operator=(const RuntimeBitset& other) {
+        if(this == &other) return *this;
         bitCount = other.bitCount;
         byteSize = other.byteSize;
-        delete[] content;
-        content = new uint8_t[byteSize];
+        deallocate();
+        content = allocate();
         memcpy(content, other.content, byteSize);
 #ifdef _ARCH_CORTEXM3_EFM32GG
         bbData = reinterpret_cast<unsigned*>(((reinterpret_cast<unsigned long>(content) - sramBase) << 5) + bitBandBase);
@@ -129,6 +135,7 @@ public:
         return *this;
     }
 
+#ifndef TDMH_FIXED_MAX_NODES
     RuntimeBitset& operator=(RuntimeBitset&& other) {
         bitCount = other.bitCount;
         byteSize = other.byteSize;
@@ -141,9 +148,10 @@ public:
 #endif
         return *this;
     }
+#endif // TDMH_FIXED_MAX_NODES
 
     virtual ~RuntimeBitset() {
-        delete[] content;
+        deallocate();
     }
 
     class Bit {
@@ -245,7 +253,87 @@ public:
     /**
      * @return true if the BitVector is empty
      */
-    bool empty();
+    bool empty() const { return none(); }
+
+    /**
+     * @return true if at least one bit is set
+     */
+    bool any() const;
+
+    /**
+     * @return true if no bit is set
+     */
+    bool none() const { return !any(); }
+
+    /**
+     * @return the number of bits set
+     */
+    std::size_t count() const;
+
+    /**
+     * Bitwise operations between bitsets of the same size. They operate on
+     * whole words, and since they do not depend on the position of the bits
+     * the byte/bit order is preserved.
+     * @throws std::range_error if the two bitsets differ in size
+     */
+    RuntimeBitset& operator&=(const RuntimeBitset& other);
+    RuntimeBitset& operator|=(const RuntimeBitset& other);
+    RuntimeBitset& operator^=(const RuntimeBitset& other);
+
+    /**
+     * Clears all the bits that are set in other, i.e. this &= ~other
+     * @throws std::range_error if the two bitsets differ in size
+     */
+    RuntimeBitset& andNot(const RuntimeBitset& other);
+
+    /**
+     * @param from the index from which to start searching, inclusive
+     * @return the index of the first set bit at or after from, or bitSize()
+     * if there is none
+     */
+    std::size_t findNext(std::size_t from) const;
+
+    /**
+     * @return the index of the first set bit, or bitSize() if there is none
+     */
+    std::size_t findFirst() const { return findNext(0); }
+
+    /**
+     * Forward iterator over the indices of the bits that are set, to be used
+     * as for(auto i : bitset.setBits()) {}
+     */
+    class SetBitIterator {
+    public:
+        SetBitIterator(const RuntimeBitset& bitset, std::size_t pos) :
+            bitset(bitset), pos(pos) {}
+
+        std::size_t operator*() const { return pos; }
+
+        SetBitIterator& operator++() {
+            pos = bitset.findNext(pos + 1);
+            return *this;
+        }
+
+        bool operator==(const SetBitIterator& other) const { return pos == other.pos; }
+        bool operator!=(const SetBitIterator& other) const { return pos != other.pos; }
+    private:
+        const RuntimeBitset& bitset;
+        std::size_t pos;
+    };
+
+    class SetBits {
+    public:
+        explicit SetBits(const RuntimeBitset& bitset) : bitset(bitset) {}
+        SetBitIterator begin() const { return SetBitIterator(bitset, bitset.findFirst()); }
+        SetBitIterator end() const { return SetBitIterator(bitset, bitset.bitSize()); }
+    private:
+        const RuntimeBitset& bitset;
+    };
+
+    /**
+     * @return a range over the indices of the bits that are set
+     */
+    SetBits setBits() const { return SetBits(*this); }
 
     /**
      * Accesses the memory area behind the array directly
@@ -284,11 +372,36 @@ public:
         return result;
     }
 private:
+    /**
+     * @return the memory for byteSize bytes, allocated or inside the object
+     */
+    uint8_t* allocate() {
+#ifdef TDMH_FIXED_MAX_NODES
+        if(byteSize > sizeof(storage)) throw std::range_error("runtime_bitset");
+        return storage;
+#else
+        return new uint8_t[byteSize];
+#endif
+    }
+
+    void deallocate() {
+#ifndef TDMH_FIXED_MAX_NODES
+        delete[] content;
+#endif
+    }
+
     std::size_t bitCount;
     std::size_t byteSize;
     uint8_t* content;
 #ifdef _ARCH_CORTEXM3_EFM32GG
     unsigned* bbData;
+#endif
+#ifdef TDMH_FIXED_MAX_NODES
+    /**
+     * The memory of the bits, content points here. Since it is in the object,
+     * moving a bitset is copying it, and the move operations are not declared
+     */
+    uint8_t storage[TDMH_FIXED_MAX_NODES / 8];
 #endif
     /**
      * Number of LSBs used to address the bit within the array element
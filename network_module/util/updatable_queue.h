@@ -74,7 +74,14 @@ public:
     /**
      * \return the oldest element in the queue, without removing it
      */
-    V& top() const;
+    const V& top() const;
+    
+    /**
+     * Calls f on the elements, in the same order in which they would be
+     * dequeued, without removing them.
+     * \param f function called on each element, returning false stops the visit
+     */
+    void visit(std::function<bool (const V& val)> f) const;
     
     /**
      * \return the oldest element in the queue, removing it
@@ -146,10 +153,17 @@ void UpdatableQueue<K,V>::enqueue(K key, const V& val, std::function<void (V& ol
 }
 
 template<typename K, typename V>
-V& UpdatableQueue<K,V>::top() const
+const V& UpdatableQueue<K,V>::top() const
 {
     if(data.empty()) throw std::runtime_error("no element in queue");
-    return data[queue.back()];
+    return data.find(queue.back())->second;
+}
+
+template<typename K, typename V>
+void UpdatableQueue<K,V>::visit(std::function<bool (const V& val)> f) const
+{
+    for(auto it = queue.rbegin(); it != queue.rend(); ++it)
+        if(f(data.find(*it)->second) == false) break;
 }
 
 template<typename K, typename V>
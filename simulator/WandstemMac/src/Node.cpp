@@ -68,7 +68,13 @@ try {
             -90,           //minWeakNeighborRSSI
             3,             //maxMissedTimesyncs
             true,          //channelSpatialReuse
-            useWeakTopologies //useWeakTopologies
+            useWeakTopologies, //useWeakTopologies
+            ControlSuperframeStructure(), //controlSuperframe
+            uplinkDiscoveryInterval, //uplinkDiscoveryInterval
+            uplinkSpatialReuse, //uplinkSpatialReuse
+            SlotTimings(), //slotTimings
+            miniSlotPayloadSize, //miniSlotPayloadSize
+            maxClockSyncPeriod //maxClockSyncPeriod
     );
     DynamicMediumAccessController controller(Transceiver::instance(), config);
     tdmh = &controller;
@@ -46,7 +46,11 @@ NodeBase::~NodeBase() {
 
 void NodeBase::initialize() {
     address = static_cast<unsigned char>(par("address").intValue());
-    nodes = static_cast<unsigned char>(par("nodes").intValue());
+    nodes = static_cast<unsigned short>(par("nodes").intValue());
     hops = static_cast<unsigned char>(par("hops").intValue());
     openStream = static_cast<unsigned char>(par("open_stream").boolValue());
+    uplinkDiscoveryInterval = static_cast<unsigned char>(par("uplink_discovery_interval").intValue());
+    uplinkSpatialReuse = par("uplink_spatial_reuse").boolValue();
+    miniSlotPayloadSize = static_cast<unsigned char>(par("mini_slot_payload_size").intValue());
+    maxClockSyncPeriod = par("max_clock_sync_period").intValue();
 }
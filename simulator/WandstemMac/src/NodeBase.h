@@ -48,6 +48,10 @@ protected:
     unsigned short nodes;
     unsigned short hops;
     bool openStream;
+    unsigned char uplinkDiscoveryInterval;
+    bool uplinkSpatialReuse;
+    unsigned char miniSlotPayloadSize;
+    unsigned long long maxClockSyncPeriod;
     virtual void initialize();
 
 private:
@@ -59,7 +59,13 @@ void RootNode::activity()
             -90,           //minWeakNeighborRSSI
             3,             //maxMissedTimesyncs
             true,          //channelSpatialReuse
-            useWeakTopologies //useWeakTopologies
+            useWeakTopologies, //useWeakTopologies
+            ControlSuperframeStructure(), //controlSuperframe
+            uplinkDiscoveryInterval, //uplinkDiscoveryInterval
+            uplinkSpatialReuse, //uplinkSpatialReuse
+            SlotTimings(), //slotTimings
+            miniSlotPayloadSize, //miniSlotPayloadSize
+            maxClockSyncPeriod //maxClockSyncPeriod
     );
     MasterMediumAccessController controller(Transceiver::instance(), config);
 
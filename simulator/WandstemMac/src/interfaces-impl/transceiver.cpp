@@ -175,6 +175,21 @@ RecvResult Transceiver::recv(void* pkt, int size, long long timeout, Unit unit,
     result.error = RecvResult::OK;
     result.size = cPkt->length;
     unsigned char* correlated;
+    //identical frames within the constructive interference time, as sent by
+    //the nodes of a synchronous flood, do not collide and are received as is
+    bool identical = true;
+    for (cQueue::Iterator it(interferingMsgs); !it.end(); it++) {
+        auto* tmp = dynamic_cast<RadioMessage*>(*it);
+        if (tmp && (tmp->length != cPkt->length || memcmp(tmp->data, cPkt->data, tmp->length) != 0))
+            identical = false;
+    }
+    if (!interferingMsgs.isEmpty() && identical) {
+        if (SIM_DBG)
+            EV_INFO << "Packet sent at " << result.timestamp << " and finished receiving at " <<
+            (packetDuration + result.timestamp) << " constructively interfered with other " <<
+            interferingMsgs.getLength() << " identical packets" << endl;
+        while(!interferingMsgs.isEmpty()) delete interferingMsgs.pop();
+    }
     if (!interferingMsgs.isEmpty()) {
         if (SIM_DBG)
             EV_INFO << "Packet sent at " << result.timestamp << " and finished receiving at " <<
@@ -0,0 +1,78 @@
+/***************************************************************************
+ *   Copyright (C) 2019 by Federico Terraneo                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   As a special exception, if other files instantiate templates or use   *
+ *   macros or inline functions from this file, or you compile this file   *
+ *   and link it with other works to produce a work based on this file,    *
+ *   this file does not by itself cause the resulting work to be covered   *
+ *   by the GNU General Public License. However the source code for this   *
+ *   file must still be made available in accordance with the GNU General  *
+ *   Public License. This exception does not invalidate any other reasons  *
+ *   why a work based on this file might be covered by the GNU General     *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ ***************************************************************************/
+
+#include "coroutine.h"
+#include <stdexcept>
+
+using namespace std;
+
+Coroutine *Coroutine::running = nullptr;
+
+Coroutine::Coroutine(function<void ()> body, StackPool& pool)
+    : body(body), pool(pool), stack(pool.allocate())
+{
+    if(getcontext(&context) != 0) throw runtime_error("getcontext failed");
+    context.uc_stack.ss_sp = stack;
+    context.uc_stack.ss_size = pool.getStackSize();
+    context.uc_link = &caller;
+    makecontext(&context, &Coroutine::entry, 0);
+}
+
+Coroutine::~Coroutine()
+{
+    pool.release(stack);
+}
+
+void Coroutine::resume()
+{
+    if(running != nullptr) throw logic_error("Coroutine::resume from a coroutine");
+    if(terminated) return;
+    running = this;
+    swapcontext(&caller, &context);
+    running = nullptr;
+    if(exception) rethrow_exception(exception);
+}
+
+void Coroutine::yield()
+{
+    Coroutine *self = running;
+    swapcontext(&self->context, &self->caller);
+}
+
+void Coroutine::entry()
+{
+    // makecontext() can only pass int arguments, so the coroutine is taken
+    // from running, which is set by resume() before switching context
+    Coroutine *self = running;
+    try {
+        self->body();
+    } catch(...) {
+        self->exception = current_exception();
+    }
+    self->terminated = true;
+    // Returning switches to uc_link, that is the resume() caller
+}
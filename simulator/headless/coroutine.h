@@ -0,0 +1,94 @@
+/***************************************************************************
+ *   Copyright (C) 2019 by Federico Terraneo                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   As a special exception, if other files instantiate templates or use   *
+ *   macros or inline functions from this file, or you compile this file   *
+ *   and link it with other works to produce a work based on this file,    *
+ *   this file does not by itself cause the resulting work to be covered   *
+ *   by the GNU General Public License. However the source code for this   *
+ *   file must still be made available in accordance with the GNU General  *
+ *   Public License. This exception does not invalidate any other reasons  *
+ *   why a work based on this file might be covered by the GNU General     *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ ***************************************************************************/
+
+#pragma once
+
+#include "stack_pool.h"
+#include <functional>
+#include <exception>
+#include <ucontext.h>
+
+/**
+ * A coroutine with its own stack, switched with swapcontext() on the thread
+ * that runs the simulation, the same way OMNeT++ runs activity() modules.
+ * Exceptions not caught by the coroutine body are rethrown by resume().
+ */
+class Coroutine
+{
+public:
+    /**
+     * \param body the function run by the coroutine, starting from the first
+     * resume()
+     * \param pool the stack is allocated from this pool, that must outlive
+     * the coroutine
+     */
+    Coroutine(std::function<void ()> body, StackPool& pool);
+
+    Coroutine(const Coroutine&) = delete;
+    Coroutine& operator=(const Coroutine&) = delete;
+
+    ~Coroutine();
+
+    /**
+     * Run the coroutine until it calls yield() or its body returns. Must not be
+     * called from a coroutine
+     */
+    void resume();
+
+    /**
+     * Called by the running coroutine to return to the resume() caller
+     */
+    static void yield();
+
+    /**
+     * \return the running coroutine, or nullptr if called outside coroutines
+     */
+    static Coroutine *current() { return running; }
+
+    /**
+     * \return true if the body has returned
+     */
+    bool isTerminated() const { return terminated; }
+
+    /**
+     * \return the high-water mark of the stack in bytes, with page granularity
+     */
+    unsigned int getStackUsage() const { return pool.usage(stack); }
+
+private:
+    static void entry();
+
+    std::function<void ()> body;
+    StackPool& pool;
+    char *stack;
+    ucontext_t context;
+    ucontext_t caller;
+    std::exception_ptr exception;
+    bool terminated = false;
+
+    static Coroutine *running;
+};
@@ -0,0 +1,236 @@
+/***************************************************************************
+ *   Copyright (C) 2019 by Federico Terraneo                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   As a special exception, if other files instantiate templates or use   *
+ *   macros or inline functions from this file, or you compile this file   *
+ *   and link it with other works to produce a work based on this file,    *
+ *   this file does not by itself cause the resulting work to be covered   *
+ *   by the GNU General Public License. However the source code for this   *
+ *   file must still be made available in accordance with the GNU General  *
+ *   Public License. This exception does not invalidate any other reasons  *
+ *   why a work based on this file might be covered by the GNU General     *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ ***************************************************************************/
+
+#include "transceiver.h"
+#include "../simulation.h"
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+namespace miosix {
+
+Transceiver& Transceiver::instance()
+{
+    SimNode *node = SimNode::current();
+    if(node == nullptr) throw logic_error("Transceiver::instance outside a node");
+    return node->getTransceiver();
+}
+
+void Transceiver::configure(const TransceiverConfiguration& config)
+{
+    if(config.frequency < minFrequency || config.frequency > maxFrequency)
+        throw range_error("config.frequency");
+    cfg = config;
+}
+
+void Transceiver::sendNow(const void *pkt, int size, string pktName)
+{
+    sendAt(pkt, size, Simulation::now(), pktName, Unit::NS);
+}
+
+bool Transceiver::sendCca(const void *pkt, int size)
+{
+    throw runtime_error("Unimplementable");
+}
+
+void Transceiver::sendAt(const void *pkt, int size, long long when, string pktName, Unit unit)
+{
+    if(!isOn) throw runtime_error("Cannot send with transceiver turned off!");
+    if(unit != Unit::NS) throw runtime_error("Not implemented");
+    if(when < Simulation::now()) throw runtime_error("Transceiver::sendAt too late to send");
+    int actualSize = size + (cfg.crc ? 2 : 0);
+    if(size < 0 || actualSize > RadioFrame::dataSize)
+        throw runtime_error(string("Packet too long ")+to_string(size));
+    node.sleepUntil(when);
+
+    auto frame = make_shared<RadioFrame>();
+    frame->sendTime = when;
+    frame->length = actualSize;
+    frame->src = node.getAddress();
+    memcpy(frame->data, pkt, size);
+    if(cfg.crc)
+    {
+        auto crc = computeCrc(pkt, size);
+        frame->data[size] = crc & 0xff;
+        frame->data[size + 1] = crc >> 8;
+    }
+    node.transmit(frame, cfg.txPower);
+    node.sleepUntil(when + RadioFrame::getPPDUDuration(actualSize));
+}
+
+RecvResult Transceiver::recv(void *pkt, int size, long long timeout, Unit unit, Correct c)
+{
+    if(!isOn) throw runtime_error("Cannot receive with transceiver turned off!");
+    if(unit != Unit::NS) throw runtime_error("Not implemented");
+    RecvResult result;
+    if(timeout < Simulation::now())
+    {
+        result.error = RecvResult::TIMEOUT;
+        return result;
+    }
+    auto arrival = node.receive(timeout);
+    auto frame = arrival.frame;
+    if(!frame)
+    {
+        result.error = RecvResult::TIMEOUT;
+        return result;
+    }
+    result.timestamp = frame->sendTime;
+    result.timestampValid = true;
+    Simulation& sim = node.getSimulation();
+    const RadioModel& radio = sim.getRadioModel();
+    result.rssi = radio.isPathLoss() ? lround(arrival.power) : 5;
+    auto packetDuration = RadioFrame::getPPDUDuration(frame->length);
+    auto needed = cfg.strictTimeout ? packetDuration : RadioFrame::preambleSfdTimeNs;
+    if(timeout != infiniteTimeout && result.timestamp + needed > timeout)
+    {
+        result.error = RecvResult::TIMEOUT;
+        return result; // Packet received but exceeds the timeout
+    }
+
+    double loss = radio.lossProbability(frame->src, node.getAddress(), frame->sendTime);
+    bool lost = loss > 0 && sim.uniformReal() < loss;
+    unsigned char correlated[RadioFrame::dataSize];
+    if(radio.isPathLoss())
+    {
+        node.sleepUntil(result.timestamp + packetDuration);
+        auto air = node.onAir(result.timestamp, result.timestamp + packetDuration);
+        if(lost || sim.uniformReal() >= radio.successProbability(arrival, air))
+        {
+            corrupted(pkt, size, result);
+            return result;
+        }
+        result.error = RecvResult::OK;
+        result.size = frame->length;
+        memcpy(correlated, frame->data, result.size);
+        return decode(pkt, size, correlated, result);
+    }
+
+    // Packets starting within the constructive interference time interfere,
+    // packets starting later, during the packet, collide
+    vector<shared_ptr<const RadioFrame>> interfering, colliding;
+    node.collectUntil(result.timestamp + RadioFrame::constructiveInterferenceTimeNs, interfering);
+    node.collectUntil(result.timestamp + packetDuration, colliding);
+    if(!colliding.empty() || lost)
+    {
+        corrupted(pkt, size, result);
+        return result;
+    }
+
+    result.error = RecvResult::OK;
+    result.size = frame->length;
+    // Identical frames within the constructive interference time, as sent by
+    // the nodes of a synchronous flood, do not collide and are received as is
+    bool identical = all_of(interfering.begin(), interfering.end(),
+        [&](const shared_ptr<const RadioFrame>& f) {
+            return f->length == frame->length && memcmp(f->data, frame->data, f->length) == 0;
+        });
+    if(!interfering.empty() && !identical)
+    {
+        // Correlate the interfering packets choosing each byte at random among
+        // the packets long enough, only the theoretical results of Glossy are
+        // taken into account
+        interfering.push_back(frame);
+        for(auto& f : interfering) result.size = max<short>(result.size, f->length);
+        for(int i = 0; i < result.size; i++)
+        {
+            int candidates = count_if(interfering.begin(), interfering.end(),
+                [i](const shared_ptr<const RadioFrame>& f) { return f->length > i; });
+            int chosen = sim.uniform(candidates);
+            for(auto& f : interfering)
+            {
+                if(f->length <= i || chosen-- > 0) continue;
+                correlated[i] = f->data[i];
+                break;
+            }
+        }
+    } else memcpy(correlated, frame->data, result.size);
+    return decode(pkt, size, correlated, result);
+}
+
+RecvResult Transceiver::decode(void *pkt, int size, unsigned char *correlated, RecvResult& result)
+{
+    if(cfg.crc)
+    {
+        result.size -= 2;
+        auto crc = computeCrc(correlated, result.size);
+        if((correlated[result.size] | (correlated[result.size + 1] << 8)) != crc)
+            result.error = RecvResult::CRC_FAIL;
+    }
+    if(result.size > size) result.error = RecvResult::TOO_LONG;
+    memcpy(pkt, correlated, min<int>(size, result.size));
+    if(size > result.size)
+        memset(reinterpret_cast<unsigned char*>(pkt) + result.size, 0, size - result.size);
+    return result;
+}
+
+short Transceiver::readRssi()
+{
+    const RadioModel& radio = node.getSimulation().getRadioModel();
+    if(!radio.isPathLoss()) return 5;
+    long long now = Simulation::now();
+    double power = RadioModel::toMilliwatt(radio.getParameters().noiseFloor);
+    for(auto& a : node.onAir(now, now + 1)) power += RadioModel::toMilliwatt(a.power);
+    return lround(RadioModel::toDbm(power));
+}
+
+void Transceiver::corrupted(void *pkt, int size, RecvResult& result)
+{
+    if(cfg.crc) result.error = RecvResult::CRC_FAIL;
+    else {
+        // Random bytes received successfully
+        Simulation& sim = node.getSimulation();
+        for(int i = 0; i < size; i++)
+            reinterpret_cast<unsigned char*>(pkt)[i] = sim.uniform(16);
+        result.error = RecvResult::OK;
+    }
+}
+
+uint16_t Transceiver::computeCrc(const void *data, int size)
+{
+    // CRC-CCITT, polynomial 0x1021 and initial value 0xffff
+    uint16_t crc = 0xffff;
+    auto *bytes = reinterpret_cast<const unsigned char*>(data);
+    for(int i = 0; i < size; i++)
+    {
+        crc ^= bytes[i] << 8;
+        for(int j = 0; j < 8; j++)
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+void TransceiverConfiguration::setChannel(int channel)
+{
+    if(channel<11 || channel>26) throw std::range_error("Channel not in range");
+    frequency=2405+5*(channel-11);
+}
+
+} //namespace miosix
@@ -0,0 +1,150 @@
+/***************************************************************************
+ *   Copyright (C) 2019 by Federico Terraneo                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   As a special exception, if other files instantiate templates or use   *
+ *   macros or inline functions from this file, or you compile this file   *
+ *   and link it with other works to produce a work based on this file,    *
+ *   this file does not by itself cause the resulting work to be covered   *
+ *   by the GNU General Public License. However the source code for this   *
+ *   file must still be made available in accordance with the GNU General  *
+ *   Public License. This exception does not invalidate any other reasons  *
+ *   why a work based on this file might be covered by the GNU General     *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ ***************************************************************************/
+
+#pragma once
+
+#include <string>
+#include <limits>
+#include <cstdint>
+
+class SimNode;
+
+namespace miosix {
+
+const long long infiniteTimeout=std::numeric_limits<long long>::max();
+
+/**
+ * This class is returned by the recv member function of the transceiver
+ */
+class RecvResult
+{
+public:
+    /**
+     * Possible outcomes of a receive operation
+     */
+    enum ErrorCode
+    {
+        OK,             ///< Receive succeeded
+        TIMEOUT,        ///< Receive timed out
+        TOO_LONG,       ///< Packet was too long for the given buffer
+        CRC_FAIL,       ///< Packet failed CRC check
+        UNINITIALIZED   ///< Receive returned exception
+    };
+
+    RecvResult()
+        : timestamp(0), rssi(-128), size(0), error(UNINITIALIZED), timestampValid(false) {}
+
+    long long timestamp; ///< Packet timestamp. It is the time point when the
+                         ///< first bit of the packet preamble is received
+    short rssi;          ///< RSSI of received packet (not valid if CRC disabled)
+    short size;          ///< Packet size in bytes (excluding CRC if enabled)
+    ErrorCode error;     ///< Possible outcomes of the receive operation
+    bool timestampValid; ///< True if timestamp is valid
+};
+
+class TransceiverConfiguration
+{
+public:
+    TransceiverConfiguration(int frequency=2450, int txPower=0, bool crc=true,
+                             bool strictTimeout=true)
+        : frequency(frequency), txPower(txPower), crc(crc),
+          strictTimeout(strictTimeout) {}
+
+    /**
+     * Configure the frequency field of this class from a IEEE 802.15.4
+     * channel number
+     * \param channel IEEE 802.15.4 channel number (from 11 to 26)
+     */
+    void setChannel(int channel);
+
+    int frequency;      ///< TX/RX frequency, between 2394 and 2507
+    int txPower;        ///< TX power in dBm
+    bool crc;           ///< True to add CRC during TX and check it during RX
+    bool strictTimeout; ///< Used only when receiving. If false and an SFD has
+                        ///< been received, prolong the timeout to receive the
+                        ///< packet. If true, return upon timeout even if a
+                        ///< packet is being received
+};
+
+
+/**
+ * The transceiver of a simulated node, by default with the same channel
+ * model of the OMNeT++ simulator: packets sent by a node reach all its
+ * neighbors, packets overlapping by more than the constructive interference
+ * time collide, and identical packets within it are received as is.
+ * With the path loss model the reception depends on the SINR, see RadioModel.
+ */
+class Transceiver
+{
+public:
+    enum Unit{TICK,NS};
+    enum Correct{CORR,UNCORR};
+    static const int minFrequency=2405; ///< Minimum supported frequency (MHz)
+    static const int maxFrequency=2480; ///< Maximum supported frequency (MHz)
+
+    /**
+     * \return the transceiver of the node that is running
+     */
+    static Transceiver& instance();
+
+    void turnOn() { isOn = true; }
+    void turnOff() { isOn = false; }
+    bool isTurnedOn() const { return isOn; }
+    void idle() {}
+    void configure(const TransceiverConfiguration& config);
+    void sendNow(const void *pkt, int size, std::string pktName = "sendNow");
+    bool sendCca(const void *pkt, int size);
+    void sendAt(const void *pkt, int size, long long when, std::string pktName = "sendAt", Unit = Unit::NS);
+    RecvResult recv(void *pkt, int size, long long timeout, Unit unit=Unit::NS, Correct c=Correct::CORR);
+    short readRssi();
+
+private:
+    Transceiver(SimNode& node) : node(node) {}
+    Transceiver(const Transceiver&)=delete;
+    Transceiver& operator= (const Transceiver&)=delete;
+
+    /**
+     * Check the CRC and copy a received packet
+     * \param correlated the bytes received, including the CRC if enabled
+     */
+    RecvResult decode(void *pkt, int size, unsigned char *correlated, RecvResult& result);
+
+    /**
+     * Fill the result of a packet that could not be decoded
+     */
+    void corrupted(void *pkt, int size, RecvResult& result);
+
+    static uint16_t computeCrc(const void *data, int size);
+
+    SimNode& node;
+    bool isOn = false;
+    TransceiverConfiguration cfg;
+
+    friend class ::SimNode;
+};
+
+} //namespace miosix
@@ -0,0 +1,403 @@
+/***************************************************************************
+ *   Copyright (C) 2019 by Federico Terraneo                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   As a special exception, if other files instantiate templates or use   *
+ *   macros or inline functions from this file, or you compile this file   *
+ *   and link it with other works to produce a work based on this file,    *
+ *   this file does not by itself cause the resulting work to be covered   *
+ *   by the GNU General Public License. However the source code for this   *
+ *   file must still be made available in accordance with the GNU General  *
+ *   Public License. This exception does not invalidate any other reasons  *
+ *   why a work based on this file might be covered by the GNU General     *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ ***************************************************************************/
+
+/*
+ * Headless simulator of network_module, running the same nodes as
+ * simulator/WandstemMac without OMNeT++. Usage:
+ *   tdmh_sim [--seed=<n>] [--sim-time-limit=<time>] [--**.<param>=<value>...]
+ *            [--stack-size=<bytes>] [--stack-usage] [--event-log=<file>]
+ *            [--schedule-capture=<file>] <network.ini|network.ned>
+ * The output is the print_dbg of the nodes, each line prefixed with
+ * "n<address>:" as in the OMNeT++ logs postprocessed by
+ * simulator/tools/postprocess.pl, so the same scripts can parse it.
+ * The maximum stack usage of the nodes is printed at the end, to size
+ * --stack-size, --stack-usage prints that of each node.
+ * --event-log writes the EventLog of all nodes, to be analyzed with
+ * simulator/tools/event_analyzer
+ * --schedule-capture writes the ScheduleCapture of the master, to be replayed
+ * with tests/local/scheduler/schedule_replay
+ */
+
+#include "simulation.h"
+#include "network_file.h"
+#include "network_module/master_tdmh.h"
+#include "network_module/dynamic_tdmh.h"
+#include "network_module/network_configuration.h"
+#include "network_module/util/event_log.h"
+#include "network_module/scheduler/schedule_capture.h"
+#include <miosix.h>
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+using namespace miosix;
+using namespace mxnet;
+
+struct Data
+{
+    Data() {}
+    Data(int id, unsigned int counter) : id(id), counter(counter){}
+    unsigned char id;
+    unsigned int counter;
+}__attribute__((packed));
+
+static FILE *eventLog = nullptr;
+static FILE *scheduleCapture = nullptr;
+/// Node of the application threads, the MAC runs in the node coroutines
+static thread_local unsigned char applicationNode = 0;
+
+static void eventSink(EventRecord& record)
+{
+    SimNode *node = SimNode::current();
+    record.node = node ? node->getAddress() : applicationNode;
+    fwrite(&record, sizeof(record), 1, eventLog); // Thread safe
+}
+
+static void captureSink(const unsigned char *record, unsigned int size)
+{
+    fwrite(record, 1, size, scheduleCapture);
+}
+
+// Same as in simulator/WandstemMac/src/NodeBase.h
+static int guaranteedTopologies(int maxNumNodes, bool useWeakTopologies)
+{
+    int bitmaskSize = useWeakTopologies ? maxNumNodes/4 : maxNumNodes/8;
+    const float topologySMERatio = 0.5;
+    int packetCapacity = (125 - 4 - bitmaskSize) / (1 + bitmaskSize);
+    return std::min<int>(packetCapacity * topologySMERatio, maxNumNodes - 2);
+}
+
+static NetworkConfiguration makeConfiguration(const NodeParameters& p)
+{
+    bool useWeakTopologies=true;
+    return NetworkConfiguration(
+            p.hops,        //maxHops
+            p.nodes,       //maxNodes
+            p.address,     //networkId
+            false,         //staticHop
+            6,             //panId
+            5,             //txPower
+            2450,          //baseFrequency
+            10000000000,   //clockSyncPeriod
+            guaranteedTopologies(p.nodes,useWeakTopologies), //guaranteedTopologies
+            1,             //numUplinkPackets
+            100000000,     //tileDuration
+            150000,        //maxAdmittedRcvWindow
+            3,             //maxRoundsUnavailableBecomesDead
+            16,            //maxRoundsWeakLinkBecomesDead
+            -75,           //minNeighborRSSI
+            -90,           //minWeakNeighborRSSI
+            3,             //maxMissedTimesyncs
+            p.channelSpatialReuse, //channelSpatialReuse
+            useWeakTopologies, //useWeakTopologies
+            ControlSuperframeStructure(), //controlSuperframe
+            p.uplinkDiscoveryInterval, //uplinkDiscoveryInterval
+            p.uplinkSpatialReuse, //uplinkSpatialReuse
+            SlotTimings(), //slotTimings
+            p.miniSlotPayloadSize, //miniSlotPayloadSize
+            p.maxClockSyncPeriod //maxClockSyncPeriod
+    );
+}
+
+/**
+ * The application of a node, the same of Node.cpp and RootNode.cpp: dynamic
+ * nodes open a stream to the master, that accepts them. It runs in its own
+ * thread using the StreamManager directly, and is started from the simulation
+ * thread once the MAC is ready instead of polling isReady()
+ */
+class Application
+{
+public:
+    explicit Application(const NodeParameters& p) : p(p) {}
+
+    void setContext(MACContext *ctx) { this->ctx = ctx; }
+
+    /**
+     * Called from the simulation thread each time the node waits
+     */
+    void poll()
+    {
+        if(started || !p.openStream || ctx == nullptr || !ctx->isReady()) return;
+        started = true;
+        thread t(&Application::run, this);
+        t.detach();
+    }
+
+private:
+    void run()
+    {
+        applicationNode = p.address;
+        if(p.root) openServer(1, Period::P1, Redundancy::TRIPLE_SPATIAL);
+        else sendData(0, Period::P10, Redundancy::TRIPLE_SPATIAL);
+    }
+
+    void sendData(unsigned char dest, Period period, Redundancy redundancy);
+    void openServer(unsigned char port, Period period, Redundancy redundancy);
+    static void streamThread(int stream, StreamManager *mgr, unsigned char address);
+
+    const NodeParameters p;
+    MACContext *ctx = nullptr;
+    bool started = false;
+};
+
+void Application::sendData(unsigned char dest, Period period, Redundancy redundancy)
+{
+    try {
+        StreamManager* mgr = ctx->getStreamManager();
+        auto params = StreamParameters(redundancy, period, 1, Direction::TX);
+        int stream;
+        do {
+            printf("[A] Node %d: Opening stream to node %d\n", p.address, dest);
+            stream = mgr->connect(dest, 1, params);
+            if(stream < 0) printf("[A] Stream opening failed! error=%d\n", stream);
+        } while(stream < 0);
+        StreamId id = mgr->getInfo(stream).getStreamId();
+        printf("[A] Stream (%d,%d) opened \n", id.src, id.dst);
+        unsigned int counter = 1;
+        while(mgr->getInfo(stream).getStatus() == StreamStatus::ESTABLISHED) {
+            Data data(ctx->getNetworkId(), counter);
+            mgr->write(stream, &data, sizeof(data));
+            counter++;
+        }
+        printf("[A] Stream was closed\n");
+    } catch(exception& e) {
+        cerr<<"\nException thrown: "<<e.what()<<endl;
+    }
+}
+
+void Application::openServer(unsigned char port, Period period, Redundancy redundancy)
+{
+    try {
+        StreamManager* mgr = ctx->getStreamManager();
+        auto params = StreamParameters(redundancy, period, 1, Direction::TX);
+        printf("[A] Opening server on port %d\n", port);
+        int server = mgr->listen(port, params);
+        if(server < 0) {
+            printf("[A] Server opening failed! error=%d\n", server);
+            return;
+        }
+        while(mgr->getInfo(server).getStatus() == StreamStatus::LISTEN) {
+            int stream = mgr->accept(server);
+            thread t(&Application::streamThread, stream, mgr, p.address);
+            t.detach();
+        }
+    } catch(exception& e) {
+        cerr<<"\nException thrown: "<<e.what()<<endl;
+    }
+}
+
+void Application::streamThread(int stream, StreamManager *mgr, unsigned char address)
+{
+    applicationNode = address;
+    StreamId id = mgr->getInfo(stream).getStreamId();
+    printf("[A] Master node: Stream (%d,%d) accepted\n", id.src, id.dst);
+    // Receive data until the stream is closed
+    while(mgr->getInfo(stream).getStatus() == StreamStatus::ESTABLISHED) {
+        Data data;
+        int len = mgr->read(stream, &data, sizeof(data));
+        if(len >= 0) {
+            if(len == sizeof(data))
+                printf("[A] Received data from (%d,%d): ID=%d Time=0 MinHeap=0 Heap=0 Counter=%u\n",
+                        id.src, id.dst, data.id, data.counter);
+            else
+                printf("[E] Received wrong size data from Stream (%d,%d): %d\n",
+                        id.src, id.dst, len);
+        }
+        else if(len == -1) {
+            printf("[E] No data received from Stream (%d,%d)\n", id.src, id.dst);
+        }
+    }
+    printf("[A] Stream (%d,%d) was closed\n", id.src, id.dst);
+}
+
+static void rootNode(const NodeParameters& p, Application& app)
+{
+    print_dbg("Master node\n");
+    // The MAC keeps a reference to the configuration
+    const NetworkConfiguration config = makeConfiguration(p);
+    MasterMediumAccessController controller(Transceiver::instance(), config);
+    app.setContext(controller.getMACContext());
+    try {
+        controller.run();
+    } catch(DisconnectException&) {
+        print_dbg("===> Stopping @ %lld\n", getTime());
+        EventLog::record(EventType::NODE_STOP, getTime());
+        SimNode::current()->halt();
+    }
+}
+
+static void dynamicNode(const NodeParameters& p, Application& app)
+{
+    print_dbg("Dynamic node %d\n", p.address);
+    // The MAC keeps a reference to the configuration
+    const NetworkConfiguration config = makeConfiguration(p);
+    DynamicMediumAccessController controller(Transceiver::instance(), config);
+    try {
+        if(p.connectTime > 0)
+        {
+            Thread::nanoSleepUntil(p.connectTime);
+            print_dbg("===> Starting @ %lld\n", p.connectTime);
+            EventLog::record(EventType::NODE_START, p.connectTime);
+        }
+        app.setContext(controller.getMACContext());
+        controller.run();
+    } catch(DisconnectException&) {
+        print_dbg("===> Stopping @ %lld (disconnectTime %lld)\n",getTime(),p.disconnectTime);
+        EventLog::record(EventType::NODE_STOP, getTime());
+        // The application thread may still use the controller
+        SimNode::current()->halt();
+    }
+}
+
+static void logLink(unsigned char a, unsigned char b)
+{
+    EventLog::record(EventType::NETWORK_LINK, 0, min(a, b) << 8 | max(a, b));
+}
+
+int main(int argc, char *argv[])
+{
+    string path;
+    unsigned int seed = 0;
+    unsigned int stackSize = Simulation::defaultStackSize;
+    bool stackUsage = false;
+    vector<string> options;
+    for(int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if(arg.compare(0, 7, "--seed=") == 0) seed = stoul(arg.substr(7));
+        else if(arg.compare(0, 13, "--stack-size=") == 0) stackSize = stoul(arg.substr(13));
+        else if(arg == "--stack-usage") stackUsage = true;
+        else if(arg.compare(0, 12, "--event-log=") == 0)
+        {
+            eventLog = fopen(arg.substr(12).c_str(), "wb");
+            if(eventLog == nullptr)
+            {
+                cerr<<"Can't open "<<arg.substr(12)<<endl;
+                return 1;
+            }
+            EventLog::setSink(eventSink);
+        }
+        else if(arg.compare(0, 19, "--schedule-capture=") == 0)
+        {
+            scheduleCapture = fopen(arg.substr(19).c_str(), "wb");
+            if(scheduleCapture == nullptr)
+            {
+                cerr<<"Can't open "<<arg.substr(19)<<endl;
+                return 1;
+            }
+            ScheduleCapture::setSink(captureSink);
+        }
+        else if(arg.compare(0, 2, "--") == 0) options.push_back(arg);
+        else path = arg;
+    }
+    if(path.empty())
+    {
+        cerr<<"use: "<<argv[0]<<" [--seed=<n>] [--sim-time-limit=<time>]"
+            <<" [--**.<param>=<value>...] [--stack-size=<bytes>] [--stack-usage]"
+            <<" [--event-log=<file>] [--schedule-capture=<file>]"
+            <<" <network.ini|network.ned>"<<endl;
+        return 1;
+    }
+    try {
+        NetworkDescription network(path);
+        for(auto& option : options) network.setOption(option);
+        long long simTimeLimit = network.getSimTimeLimit();
+        if(simTimeLimit <= 0) throw runtime_error("sim-time-limit not set");
+
+        RadioModel radio(network.getRadioParameters());
+        Simulation sim(seed, radio, stackSize);
+        auto params = network.getNodes();
+        vector<SimNode*> nodes;
+        for(auto& p : params)
+        {
+            auto *app = new Application(p); // Used by detached threads
+            SimNode& node = sim.addNode(p.address, [p,app]{
+                if(p.root) rootNode(p, *app);
+                else dynamicNode(p, *app);
+            });
+            node.setDisconnectTime(p.disconnectTime);
+            node.setWaitHook([app]{ app->poll(); });
+            nodes.push_back(&node);
+        }
+        if(radio.isPathLoss())
+        {
+            // The links of the .ned file are ignored, nodes hear each other
+            // according to their position
+            double shadowing = radio.getParameters().shadowing;
+            for(unsigned int i = 0; i < params.size(); i++)
+                for(unsigned int j = i + 1; j < params.size(); j++)
+                {
+                    double loss = radio.pathLoss(params[i], params[j]);
+                    if(shadowing > 0) loss += sim.normal(shadowing);
+                    if(radio.isNegligible(loss)) continue;
+                    sim.connect(*nodes[i], *nodes[j], loss);
+                    // Links able to receive at the maximum power are logged
+                    // as the links of the network
+                    if(RadioModel::maxTxPower - loss >= radio.getParameters().sensitivity)
+                        logLink(params[i].address, params[j].address);
+                }
+        } else {
+            for(auto& link : network.getLinks())
+            {
+                sim.connect(*nodes[link.first], *nodes[link.second]);
+                logLink(params[link.first].address, params[link.second].address);
+            }
+        }
+
+        auto begin = chrono::steady_clock::now();
+        sim.run(simTimeLimit);
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - begin;
+        fflush(stdout);
+        fprintf(stderr, "%s: simulated %.1fs in %.3fs, %llu events\n",
+                network.getName().c_str(), simTimeLimit / 1e9, elapsed.count(),
+                sim.getEvents());
+        unsigned int maxUsage = 0, maxNode = 0;
+        for(auto& node : sim.getNodes())
+        {
+            unsigned int usage = node->getStackUsage();
+            if(stackUsage) fprintf(stderr, "n%d: stack usage %u bytes\n", node->getAddress(), usage);
+            if(usage > maxUsage) { maxUsage = usage; maxNode = node->getAddress(); }
+        }
+        fprintf(stderr, "%s: max stack usage %u of %u bytes, by node %d\n",
+                network.getName().c_str(), maxUsage, sim.getStackSize(), maxNode);
+    } catch(exception& e) {
+        fflush(stdout);
+        cerr<<"\nException thrown: "<<e.what()<<endl;
+        _Exit(1);
+    }
+    // The application threads are blocked in the StreamManager of the nodes,
+    // whose coroutines are never unwound, so no destructor must run
+    fflush(stdout);
+    if(eventLog) fflush(eventLog);
+    if(scheduleCapture) fflush(scheduleCapture);
+    _Exit(0);
+}
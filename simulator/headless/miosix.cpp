@@ -0,0 +1,141 @@
+/***************************************************************************
+ *   Copyright (C) 2019 by Federico Terraneo                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   As a special exception, if other files instantiate templates or use   *
+ *   macros or inline functions from this file, or you compile this file   *
+ *   and link it with other works to produce a work based on this file,    *
+ *   this file does not by itself cause the resulting work to be covered   *
+ *   by the GNU General Public License. However the source code for this   *
+ *   file must still be made available in accordance with the GNU General  *
+ *   Public License. This exception does not invalidate any other reasons  *
+ *   why a work based on this file might be covered by the GNU General     *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ ***************************************************************************/
+
+#include "miosix.h"
+#include "simulation.h"
+#include "interfaces-impl/power_manager.h"
+#include "interfaces-impl/virtual_clock.h"
+#include <cstdio>
+#include <cstdarg>
+#include <stdexcept>
+#include <sched.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace mxnet {
+
+void print_dbg_(const char *fmt, ...)
+{
+    char str[1024];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(str, sizeof(str), fmt, args);
+    va_end(args);
+    // Prints from the scheduler and application threads have no node prefix
+    SimNode *node = SimNode::current();
+    if(node) node->print(str);
+    else fputs(str, stdout);
+}
+
+} //namespace mxnet
+
+namespace miosix {
+
+static SimNode& currentNode()
+{
+    SimNode *node = SimNode::current();
+    if(node == nullptr) throw logic_error("Sleeping outside a node");
+    return *node;
+}
+
+long long getTime() { return Simulation::now(); }
+
+void Thread::nanoSleep(long long delta)
+{
+    currentNode().sleepUntil(Simulation::now() + delta);
+}
+
+void Thread::nanoSleepUntil(long long when)
+{
+    currentNode().sleepUntil(when);
+}
+
+static void memPrint(const char *data, char len)
+{
+    printf("0x%08x | ",reinterpret_cast<const unsigned char*>(data)[0]);
+    for(int i=0;i<len;i++) printf("%02x ",static_cast<unsigned char>(data[i]));
+    for(int i=0;i<(16-len);i++) printf("   ");
+    printf("| ");
+    for(int i=0;i<len;i++)
+    {
+        if((data[i]>=32)&&(data[i]<127)) printf("%c",data[i]);
+        else printf(".");
+    }
+    printf("\n");
+}
+
+void memDump(const void *start, int len)
+{
+    const char *data=reinterpret_cast<const char*>(start);
+    while(len>16)
+    {
+        memPrint(data,16);
+        len-=16;
+        data+=16;
+    }
+    if(len>0) memPrint(data,len);
+}
+
+PowerManager& PowerManager::instance()
+{
+    static PowerManager pm;
+    return pm;
+}
+
+void PowerManager::deepSleep(long long delta) { Thread::nanoSleep(delta); }
+
+void PowerManager::deepSleepUntil(long long when) { Thread::nanoSleepUntil(when); }
+
+VirtualClock& VirtualClock::instance()
+{
+    static VirtualClock vc;
+    return vc;
+}
+
+} //namespace miosix
+
+/*
+ * DataPhase::execute() calls usleep(1000) at each data slot when not running
+ * on Miosix, to let the application threads write to the streams before the
+ * MAC of the OMNeT++ simulator gets to the next slot. Sleeping in real time
+ * would make the simulation slower than real time, so the nodes just give the
+ * CPU to the application threads, while usleep() still sleeps in the other
+ * threads.
+ */
+int usleep(useconds_t usec)
+{
+    if(SimNode::current())
+    {
+        sched_yield();
+        return 0;
+    }
+    struct timespec ts;
+    ts.tv_sec = usec / 1000000;
+    ts.tv_nsec = (usec % 1000000) * 1000;
+    return nanosleep(&ts, nullptr);
+}
@@ -0,0 +1,72 @@
+/***************************************************************************
+ *   Copyright (C) 2019 by Federico Terraneo                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   As a special exception, if other files instantiate templates or use   *
+ *   macros or inline functions from this file, or you compile this file   *
+ *   and link it with other works to produce a work based on this file,    *
+ *   this file does not by itself cause the resulting work to be covered   *
+ *   by the GNU General Public License. However the source code for this   *
+ *   file must still be made available in accordance with the GNU General  *
+ *   Public License. This exception does not invalidate any other reasons  *
+ *   why a work based on this file might be covered by the GNU General     *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ ***************************************************************************/
+
+#pragma once
+
+/*
+ * Shim of the Miosix API used by network_module when it runs in the headless
+ * simulator. Like the one in simulator/WandstemMac/src, time is the simulation
+ * time in nanoseconds and all the calls made by the MAC refer to the node whose
+ * coroutine is running.
+ */
+
+namespace mxnet {
+/**
+ * Print to stdout prefixing each line with "n<address>:" of the node that is
+ * running, the same prefix of the postprocessed OMNeT++ logs
+ */
+void print_dbg_(const char *fmt, ...);
+#define print_dbg print_dbg_
+}
+
+namespace miosix {
+
+/**
+ * \return the simulation time in ns, can be called from any thread
+ */
+long long getTime();
+
+void memDump(const void *start, int len);
+
+class Thread
+{
+public:
+    static void nanoSleep(long long delta);
+    static void nanoSleepUntil(long long when);
+};
+
+class greenLed
+{
+public:
+    static void high() {}
+    static void low() {}
+};
+
+inline void ledOn() {}
+inline void ledOff() {}
+
+} //namespace miosix
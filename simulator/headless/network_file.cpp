@@ -0,0 +1,226 @@
+/***************************************************************************
+ *   Copyright (C) 2019 by Federico Terraneo                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   As a special exception, if other files instantiate templates or use   *
+ *   macros or inline functions from this file, or you compile this file   *
+ *   and link it with other works to produce a work based on this file,    *
+ *   this file does not by itself cause the resulting work to be covered   *
+ *   by the GNU General Public License. However the source code for this   *
+ *   file must still be made available in accordance with the GNU General  *
+ *   Public License. This exception does not invalidate any other reasons  *
+ *   why a work based on this file might be covered by the GNU General     *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ ***************************************************************************/
+
+#include "network_file.h"
+#include <fstream>
+#include <sstream>
+#include <regex>
+#include <stdexcept>
+
+using namespace std;
+
+static string readFile(const string& path)
+{
+    ifstream in(path);
+    if(!in) throw runtime_error(string("Can't open ")+path);
+    stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+static string trim(const string& s)
+{
+    auto begin = s.find_first_not_of(" \t\r\n");
+    if(begin == string::npos) return "";
+    auto end = s.find_last_not_of(" \t\r\n");
+    return s.substr(begin, end - begin + 1);
+}
+
+/**
+ * \param s a time such as 100s or 500ms, seconds if without unit
+ * \return the time in ns
+ */
+static long long parseTime(const string& s)
+{
+    size_t pos;
+    double value = stod(s, &pos);
+    string unit = trim(s.substr(pos));
+    if(unit == "" || unit == "s") return value * 1e9;
+    if(unit == "ms") return value * 1e6;
+    if(unit == "us") return value * 1e3;
+    if(unit == "ns") return value;
+    throw runtime_error(string("Unknown time unit ")+s);
+}
+
+/**
+ * \return a string value without the quotes, that are optional
+ */
+static string unquote(const string& s)
+{
+    if(s.size() >= 2 && s.front() == '"' && s.back() == '"') return s.substr(1, s.size() - 2);
+    return s;
+}
+
+static long long parseInt(const string& s) { return stoll(s); }
+
+static bool parseBool(const string& s)
+{
+    if(s == "true") return true;
+    if(s == "false") return false;
+    throw runtime_error(string("Not a bool ")+s);
+}
+
+NetworkDescription::NetworkDescription(const string& path)
+{
+    if(path.size() > 4 && path.substr(path.size() - 4) == ".ini") readIni(path);
+    else readNed(path);
+}
+
+void NetworkDescription::setOption(const string& option)
+{
+    smatch m;
+    if(regex_match(option, m, regex(R"(--sim-time-limit=(.+))")))
+        simTimeLimit = parseTime(m[1]);
+    else if(regex_match(option, m, regex(R"(--\*\*\.(\w+)=(.+))")))
+        iniParams[m[1]] = trim(m[2]);
+    else throw runtime_error(string("Unknown option ")+option);
+}
+
+vector<NodeParameters> NetworkDescription::getNodes() const
+{
+    vector<NodeParameters> result;
+    for(auto& node : nodes)
+    {
+        auto get = [&](const string& key) -> const string* {
+            for(auto *params : {&node.params, &networkParams, &iniParams})
+            {
+                auto it = params->find(key);
+                if(it != params->end()) return &it->second;
+            }
+            return nullptr;
+        };
+        NodeParameters p;
+        p.root = node.root;
+        p.hasPosition = node.hasPosition;
+        p.x = node.x;
+        p.y = node.y;
+        if(auto *v = get("address")) p.address = parseInt(*v);
+        if(auto *v = get("nodes")) p.nodes = parseInt(*v);
+        if(auto *v = get("hops")) p.hops = parseInt(*v);
+        if(auto *v = get("connect_time")) p.connectTime = parseInt(*v);
+        if(auto *v = get("disconnect_time")) p.disconnectTime = parseInt(*v);
+        if(auto *v = get("open_stream")) p.openStream = parseBool(*v);
+        if(auto *v = get("uplink_discovery_interval")) p.uplinkDiscoveryInterval = parseInt(*v);
+        if(auto *v = get("uplink_spatial_reuse")) p.uplinkSpatialReuse = parseBool(*v);
+        if(auto *v = get("mini_slot_payload_size")) p.miniSlotPayloadSize = parseInt(*v);
+        if(auto *v = get("max_clock_sync_period")) p.maxClockSyncPeriod = parseInt(*v);
+        if(auto *v = get("channel_spatial_reuse")) p.channelSpatialReuse = parseBool(*v);
+        result.push_back(p);
+    }
+    return result;
+}
+
+RadioParameters NetworkDescription::getRadioParameters() const
+{
+    auto get = [&](const string& key) -> const string* {
+        auto it = iniParams.find(key);
+        return it != iniParams.end() ? &it->second : nullptr;
+    };
+    RadioParameters p;
+    if(auto *v = get("radio_model"))
+    {
+        string model = unquote(*v);
+        if(model == "path_loss") p.pathLoss = true;
+        else if(model != "unit_disk") throw runtime_error(string("Unknown radio_model ")+model);
+    }
+    if(auto *v = get("path_loss_exponent")) p.pathLossExponent = stod(*v);
+    if(auto *v = get("reference_loss")) p.referenceLoss = stod(*v);
+    if(auto *v = get("shadowing")) p.shadowing = stod(*v);
+    if(auto *v = get("fading")) p.fading = stod(*v);
+    if(auto *v = get("noise_floor")) p.noiseFloor = stod(*v);
+    if(auto *v = get("sensitivity")) p.sensitivity = stod(*v);
+    if(auto *v = get("meters_per_unit")) p.metersPerUnit = stod(*v);
+    if(auto *v = get("loss_trace")) p.lossTrace = unquote(*v);
+    return p;
+}
+
+void NetworkDescription::readNed(const string& path)
+{
+    string ned = readFile(path);
+    // Drop the comments
+    ned = regex_replace(ned, regex(R"(//[^\n]*)"), "");
+    smatch m;
+    if(regex_search(ned, m, regex(R"(network\s+(\w+))"))) name = m[1];
+    else throw runtime_error(path+" has no network");
+
+    regex assignment(R"((\w+)\s*=\s*([^;]+);)");
+    regex networkParam(R"(n\*\.(\w+)\s*=\s*([^;]+);)");
+    for(sregex_iterator it(ned.begin(), ned.end(), networkParam), end; it != end; ++it)
+        networkParams[(*it)[1]] = trim((*it)[2]);
+
+    map<int, int> submodules; // nK name -> index in nodes
+    regex submodule(R"(n(\d+)\s*:\s*(RootNode|Node)\s*\{([^}]*)\})");
+    regex position(R"(@display\("[^"]*\bp=([-+.\deE]+),([-+.\deE]+))");
+    for(sregex_iterator it(ned.begin(), ned.end(), submodule), end; it != end; ++it)
+    {
+        submodules[stoi((*it)[1])] = nodes.size();
+        Submodule node;
+        node.root = (*it)[2] == "RootNode";
+        string body = (*it)[3];
+        for(sregex_iterator jt(body.begin(), body.end(), assignment); jt != end; ++jt)
+            node.params[(*jt)[1]] = trim((*jt)[2]);
+        smatch p;
+        node.hasPosition = regex_search(body, p, position);
+        node.x = node.hasPosition ? stod(p[1]) : 0;
+        node.y = node.hasPosition ? stod(p[2]) : 0;
+        nodes.push_back(node);
+    }
+    if(nodes.empty()) throw runtime_error(path+" has no nodes");
+
+    // The same links read by simulator/tools/ned2python.pl
+    regex link(R"(n(\d+)\.wireless\+\+\s*<-->\s*n(\d+)\.wireless\+\+)");
+    for(sregex_iterator it(ned.begin(), ned.end(), link), end; it != end; ++it)
+    {
+        auto a = submodules.find(stoi((*it)[1]));
+        auto b = submodules.find(stoi((*it)[2]));
+        if(a == submodules.end() || b == submodules.end())
+            throw runtime_error(path+" links a missing node");
+        links.push_back(make_pair(a->second, b->second));
+    }
+}
+
+void NetworkDescription::readIni(const string& path)
+{
+    ifstream in(path);
+    if(!in) throw runtime_error(string("Can't open ")+path);
+    string line, network;
+    while(getline(in, line))
+    {
+        line = trim(line.substr(0, line.find('#')));
+        auto eq = line.find('=');
+        if(line.empty() || line[0] == '[' || eq == string::npos) continue;
+        string key = trim(line.substr(0, eq));
+        string value = trim(line.substr(eq + 1));
+        if(key == "network") network = value;
+        else if(key == "sim-time-limit") simTimeLimit = parseTime(value);
+        else if(key.compare(0, 3, "**.") == 0) iniParams[key.substr(3)] = value;
+    }
+    if(network.empty()) throw runtime_error(path+" has no network");
+    auto slash = path.rfind('/');
+    string dir = slash == string::npos ? "" : path.substr(0, slash + 1);
+    readNed(dir + network + ".ned");
+}
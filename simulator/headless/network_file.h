@@ -0,0 +1,144 @@
+/***************************************************************************
+ *   Copyright (C) 2019 by Federico Terraneo                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   As a special exception, if other files instantiate templates or use   *
+ *   macros or inline functions from this file, or you compile this file   *
+ *   and link it with other works to produce a work based on this file,    *
+ *   this file does not by itself cause the resulting work to be covered   *
+ *   by the GNU General Public License. However the source code for this   *
+ *   file must still be made available in accordance with the GNU General  *
+ *   Public License. This exception does not invalidate any other reasons  *
+ *   why a work based on this file might be covered by the GNU General     *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ ***************************************************************************/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+#include <limits>
+
+/**
+ * Parameters of a node, with the same names and defaults of Node.ned and
+ * RootNode.ned
+ */
+struct NodeParameters
+{
+    unsigned char address = 0;
+    bool root = false;
+    unsigned short nodes = 0;
+    unsigned short hops = 0;
+    long long connectTime = 0;
+    long long disconnectTime = std::numeric_limits<long long>::max();
+    bool openStream = true;
+    unsigned char uplinkDiscoveryInterval = 0;
+    bool uplinkSpatialReuse = false;
+    unsigned char miniSlotPayloadSize = 0;
+    unsigned long long maxClockSyncPeriod = 0;
+    bool channelSpatialReuse = true;
+    bool hasPosition = false; ///< Whether the node has a @display("p=x,y")
+    double x = 0;
+    double y = 0;
+};
+
+/**
+ * Parameters of the channel, set as **.name entries of the .ini file or of
+ * the command line, see RadioModel
+ */
+struct RadioParameters
+{
+    bool pathLoss = false;         ///< radio_model, unit_disk or path_loss
+    double pathLossExponent = 3.0; ///< path_loss_exponent
+    double referenceLoss = 40.0;   ///< reference_loss, dB at 1m
+    double shadowing = 4.0;        ///< shadowing, standard deviation in dB
+    double fading = 0.0;           ///< fading, standard deviation in dB
+    double noiseFloor = -100.0;    ///< noise_floor, dBm
+    double sensitivity = -95.0;    ///< sensitivity, dBm
+    double metersPerUnit = 1.0;    ///< meters_per_unit of the .ned positions
+    std::string lossTrace;         ///< loss_trace, path of the per-link losses
+};
+
+/**
+ * The network to simulate, read from the .ned and .ini files of the OMNeT++
+ * simulator, only the subset of the syntax used by simulator/WandstemMac and
+ * the networks generated by simulator/tools/nedgen_hexagon is understood.
+ *
+ * As in OMNeT++, parameters assigned in the submodule take precedence over
+ * those assigned as n*.name in the network, that take precedence over the
+ * **.name entries of the .ini file and of the command line
+ */
+class NetworkDescription
+{
+public:
+    /**
+     * Read a network
+     * \param path a .ned file, or a .ini file whose network is read from the
+     * .ned file with the same name in its directory
+     * \throws runtime_error if the file can't be read
+     */
+    explicit NetworkDescription(const std::string& path);
+
+    /**
+     * Set a parameter as a **.name entry of the .ini file would
+     * \param option a command line option, either --sim-time-limit=<time> or
+     * --**.<name>=<value>
+     * \throws runtime_error if the option is not recognized
+     */
+    void setOption(const std::string& option);
+
+    const std::string& getName() const { return name; }
+
+    /**
+     * \return the sim-time-limit in ns, 0 if not set
+     */
+    long long getSimTimeLimit() const { return simTimeLimit; }
+
+    /**
+     * \return the parameters of all nodes, in the order of the .ned file
+     */
+    std::vector<NodeParameters> getNodes() const;
+
+    /**
+     * \return the parameters of the channel
+     */
+    RadioParameters getRadioParameters() const;
+
+    /**
+     * \return the links, as pairs of indices in getNodes()
+     */
+    const std::vector<std::pair<int, int>>& getLinks() const { return links; }
+
+private:
+    void readNed(const std::string& path);
+    void readIni(const std::string& path);
+
+    std::string name;
+    long long simTimeLimit = 0;
+    std::map<std::string, std::string> iniParams;
+    std::map<std::string, std::string> networkParams;
+    struct Submodule
+    {
+        bool root;
+        std::map<std::string, std::string> params;
+        bool hasPosition;
+        double x, y;
+    };
+
+    std::vector<Submodule> nodes;
+    std::vector<std::pair<int, int>> links;
+};
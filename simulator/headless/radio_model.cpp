@@ -0,0 +1,154 @@
+/***************************************************************************
+ *   Copyright (C) 2019 by Federico Terraneo                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   As a special exception, if other files instantiate templates or use   *
+ *   macros or inline functions from this file, or you compile this file   *
+ *   and link it with other works to produce a work based on this file,    *
+ *   this file does not by itself cause the resulting work to be covered   *
+ *   by the GNU General Public License. However the source code for this   *
+ *   file must still be made available in accordance with the GNU General  *
+ *   Public License. This exception does not invalidate any other reasons  *
+ *   why a work based on this file might be covered by the GNU General     *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ ***************************************************************************/
+
+#include "radio_model.h"
+#include "simulation.h"
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+RadioModel::RadioModel(const RadioParameters& params) : params(params)
+{
+    if(!params.lossTrace.empty()) readLossTrace(params.lossTrace);
+}
+
+double RadioModel::pathLoss(const NodeParameters& a, const NodeParameters& b) const
+{
+    if(!a.hasPosition || !b.hasPosition)
+        throw runtime_error("The path loss model needs the @display position of all nodes");
+    double distance = hypot(a.x - b.x, a.y - b.y) * params.metersPerUnit;
+    // Closer than the 1m reference distance the model does not hold
+    return params.referenceLoss + 10 * params.pathLossExponent * log10(max(distance, 1.0));
+}
+
+double RadioModel::successProbability(const Arrival& packet, const vector<Arrival>& air) const
+{
+    long long begin = packet.frame->sendTime;
+    long long end = begin + RadioFrame::getPPDUDuration(packet.frame->length);
+    double signal = toMilliwatt(packet.power);
+    // Changes of the interference during the packet, as (time, delta in mW)
+    vector<pair<long long, double>> steps;
+    for(auto& a : air)
+    {
+        if(a.frame == packet.frame) continue;
+        long long aBegin = a.frame->sendTime;
+        long long aEnd = aBegin + RadioFrame::getPPDUDuration(a.frame->length);
+        if(aEnd <= begin || aBegin >= end) continue;
+        // Identical packets within the constructive interference time, as
+        // sent by the nodes of a synchronous flood, add to the signal
+        if(llabs(aBegin - begin) <= RadioFrame::constructiveInterferenceTimeNs
+            && a.frame->length == packet.frame->length
+            && equal(a.frame->data, a.frame->data + a.frame->length, packet.frame->data))
+        {
+            signal += toMilliwatt(a.power);
+            continue;
+        }
+        steps.push_back(make_pair(max(aBegin, begin), toMilliwatt(a.power)));
+        steps.push_back(make_pair(min(aEnd, end), -toMilliwatt(a.power)));
+    }
+    sort(steps.begin(), steps.end());
+
+    // Multiply the probability of decoding all bits of each interval with
+    // constant interference
+    double noise = toMilliwatt(params.noiseFloor);
+    double interference = 0;
+    double result = 1;
+    long long t = begin;
+    auto interval = [&](long long until) {
+        double bits = static_cast<double>(until - t) / bitTimeNs;
+        result *= pow(1 - bitErrorRate(signal / (noise + max(interference, 0.0))), bits);
+        t = until;
+    };
+    for(auto& step : steps)
+    {
+        interval(step.first);
+        interference += step.second;
+    }
+    interval(end);
+    return result;
+}
+
+double RadioModel::lossProbability(unsigned char src, unsigned char dst, long long time) const
+{
+    auto it = lossTrace.find(make_pair(src, dst));
+    if(it == lossTrace.end()) return 0;
+    auto& entries = it->second;
+    // The last entry not after time
+    auto next = upper_bound(entries.begin(), entries.end(), make_pair(time, 2.0));
+    return next == entries.begin() ? 0 : prev(next)->second;
+}
+
+double RadioModel::toMilliwatt(double power)
+{
+    return pow(10.0, power / 10);
+}
+
+double RadioModel::toDbm(double power)
+{
+    return 10 * log10(power);
+}
+
+double RadioModel::bitErrorRate(double sinr)
+{
+    double sum = 0;
+    double binomial = 16; // 16 choose k, starting from k=1
+    for(int k = 2; k <= 16; k++)
+    {
+        binomial = binomial * (16 - k + 1) / k;
+        sum += (k % 2 == 0 ? 1 : -1) * binomial * exp(20 * sinr * (1.0 / k - 1));
+    }
+    return min(max(8.0 / 15 / 16 * sum, 0.0), 0.5);
+}
+
+void RadioModel::readLossTrace(const string& path)
+{
+    ifstream in(path);
+    if(!in) throw runtime_error(string("Can't open ")+path);
+    string line;
+    int lineNumber = 0;
+    while(getline(in, line))
+    {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+        if(line.find_first_not_of(" \t\r") == string::npos) continue;
+        // <time in s> <src> <dst> <loss probability>
+        istringstream ss(line);
+        double time, loss;
+        int src, dst;
+        if(!(ss >> time >> src >> dst >> loss) || loss < 0 || loss > 1)
+            throw runtime_error(path+":"+to_string(lineNumber)+": wrong loss trace entry");
+        lossTrace[make_pair(src, dst)].push_back(make_pair(llround(time * 1e9), loss));
+    }
+    for(auto& link : lossTrace) stable_sort(link.second.begin(), link.second.end(),
+        [](const pair<long long, double>& a, const pair<long long, double>& b) {
+            return a.first < b.first;
+        });
+}
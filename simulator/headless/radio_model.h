@@ -0,0 +1,137 @@
+/***************************************************************************
+ *   Copyright (C) 2019 by Federico Terraneo                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   As a special exception, if other files instantiate templates or use   *
+ *   macros or inline functions from this file, or you compile this file   *
+ *   and link it with other works to produce a work based on this file,    *
+ *   this file does not by itself cause the resulting work to be covered   *
+ *   by the GNU General Public License. However the source code for this   *
+ *   file must still be made available in accordance with the GNU General  *
+ *   Public License. This exception does not invalidate any other reasons  *
+ *   why a work based on this file might be covered by the GNU General     *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ ***************************************************************************/
+
+#pragma once
+
+#include "network_file.h"
+#include <map>
+#include <vector>
+#include <memory>
+#include <utility>
+
+struct RadioFrame;
+
+/**
+ * A packet reaching a node, with its received power
+ */
+struct Arrival
+{
+    std::shared_ptr<const RadioFrame> frame;
+    double power; ///< Received power in dBm
+};
+
+/**
+ * The channel model. With the unit disk model, the default, nodes hear each
+ * other only if linked in the .ned file, and any packet overlapping another
+ * one collides, as in the OMNeT++ simulator.
+ * With the path loss model nodes hear each other according to their distance
+ * in the .ned file, with log-distance path loss and log-normal shadowing
+ * fixed per link, plus an optional log-normal fading per packet. A packet is
+ * received if it is above the sensitivity, and decoded with the probability
+ * given by the bit error rate of the IEEE 802.15.4 O-QPSK modulation at its
+ * SINR, so the strongest of overlapping packets may be captured.
+ * Both models can add the packet loss probabilities of a per-link loss trace
+ */
+class RadioModel
+{
+public:
+    /**
+     * \param params the channel parameters
+     * \throws runtime_error if the loss trace can't be read
+     */
+    explicit RadioModel(const RadioParameters& params = RadioParameters());
+
+    bool isPathLoss() const { return params.pathLoss; }
+
+    const RadioParameters& getParameters() const { return params; }
+
+    /**
+     * \param a a node
+     * \param b another node
+     * \return the mean path loss in dB between the two nodes, without shadowing
+     * \throws runtime_error if any of the two nodes has no position
+     */
+    double pathLoss(const NodeParameters& a, const NodeParameters& b) const;
+
+    /**
+     * \param loss the path loss of a link
+     * \return true if the packets sent through the link are too weak to even
+     * interfere with other ones, so that the link can be omitted
+     */
+    bool isNegligible(double loss) const
+    {
+        return maxTxPower - loss < params.noiseFloor - negligibleMargin;
+    }
+
+    /**
+     * \param packet a packet received by a node
+     * \param air all the packets on air at the node during its reception,
+     * including itself
+     * \return the probability that the packet is decoded correctly
+     */
+    double successProbability(const Arrival& packet, const std::vector<Arrival>& air) const;
+
+    /**
+     * \param src sender node
+     * \param dst receiver node
+     * \param time send time of a packet
+     * \return the probability that the packet is lost according to the loss
+     * trace, 0 if the link is not in the trace
+     */
+    double lossProbability(unsigned char src, unsigned char dst, long long time) const;
+
+    /**
+     * \param power a power in dBm
+     * \return the same power in mW
+     */
+    static double toMilliwatt(double power);
+
+    /**
+     * \param power a power in mW
+     * \return the same power in dBm
+     */
+    static double toDbm(double power);
+
+    /**
+     * \param sinr signal to interference plus noise ratio, not in dB
+     * \return the bit error rate of the IEEE 802.15.4 O-QPSK modulation at
+     * 2.4GHz, as given in annex E of the standard
+     */
+    static double bitErrorRate(double sinr);
+
+    static const int maxTxPower = 5;        ///< Of the CC2520, in dBm
+    static const int negligibleMargin = 10; ///< In dB below the noise floor
+    static const int bitTimeNs = 4000;      ///< At 250kbit/s
+
+private:
+    void readLossTrace(const std::string& path);
+
+    RadioParameters params;
+    /// (src, dst) -> (time, loss probability) sorted by time
+    std::map<std::pair<unsigned char, unsigned char>,
+             std::vector<std::pair<long long, double>>> lossTrace;
+};
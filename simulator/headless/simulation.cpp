@@ -0,0 +1,208 @@
+/***************************************************************************
+ *   Copyright (C) 2019 by Federico Terraneo                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   As a special exception, if other files instantiate templates or use   *
+ *   macros or inline functions from this file, or you compile this file   *
+ *   and link it with other works to produce a work based on this file,    *
+ *   this file does not by itself cause the resulting work to be covered   *
+ *   by the GNU General Public License. However the source code for this   *
+ *   file must still be made available in accordance with the GNU General  *
+ *   Public License. This exception does not invalidate any other reasons  *
+ *   why a work based on this file might be covered by the GNU General     *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ ***************************************************************************/
+
+#include "simulation.h"
+#include <limits>
+#include <cstdio>
+#include <algorithm>
+
+using namespace std;
+
+//
+// class SimNode
+//
+
+thread_local SimNode *SimNode::running = nullptr;
+
+SimNode::SimNode(Simulation& sim, unsigned char address, function<void ()> body)
+    : sim(sim), address(address), coroutine(body, sim.stacks),
+      transceiver(*this), disconnectTime(numeric_limits<long long>::max()) {}
+
+void SimNode::sleepUntil(long long when)
+{
+    suspend(State::SLEEPING, when);
+}
+
+Arrival SimNode::receive(long long timeout)
+{
+    suspend(State::RECEIVING, timeout);
+    auto result = received;
+    received.frame.reset();
+    return result;
+}
+
+void SimNode::collectUntil(long long when, vector<shared_ptr<const RadioFrame>>& frames)
+{
+    collected = &frames;
+    suspend(State::COLLECTING, when);
+}
+
+vector<Arrival> SimNode::onAir(long long begin, long long end) const
+{
+    vector<Arrival> result;
+    for(auto& a : air)
+    {
+        long long aEnd = a.frame->sendTime + RadioFrame::getPPDUDuration(a.frame->length);
+        if(a.frame->sendTime < end && aEnd > begin) result.push_back(a);
+    }
+    return result;
+}
+
+void SimNode::halt()
+{
+    state = State::SLEEPING;
+    generation++; // Cancel any wakeup, so the coroutine is never resumed
+    Coroutine::yield();
+}
+
+void SimNode::transmit(shared_ptr<const RadioFrame> frame, int txPower)
+{
+    double fading = sim.radio.getParameters().fading;
+    for(auto& neighbor : neighbors)
+    {
+        double power = txPower - neighbor.loss;
+        if(sim.radio.isPathLoss() && fading > 0) power += sim.normal(fading);
+        sim.schedule(frame->sendTime, neighbor.node, frame, 0, power);
+    }
+}
+
+void SimNode::print(const char *str)
+{
+    for(; *str; str++)
+    {
+        line += *str;
+        if(*str != '\n') continue;
+        printf("n%d:%s", address, line.c_str());
+        line.clear();
+    }
+}
+
+void SimNode::suspend(State newState, long long when)
+{
+    if(disconnected) throw DisconnectException();
+    when = min(when, disconnectTime);
+    state = newState;
+    generation++;
+    if(when != numeric_limits<long long>::max()) sim.schedule(when, this, nullptr, generation);
+    Coroutine::yield();
+    state = State::RUNNING;
+    collected = nullptr;
+    if(Simulation::now() >= disconnectTime)
+    {
+        disconnected = true;
+        throw DisconnectException();
+    }
+}
+
+void SimNode::wakeup(unsigned int generation)
+{
+    if(generation == this->generation) run();
+}
+
+void SimNode::frameArrived(shared_ptr<const RadioFrame> frame, double power)
+{
+    const RadioModel& radio = sim.radio;
+    if(radio.isPathLoss())
+    {
+        // Forget the packets that ended before any packet still on air began
+        long long horizon = Simulation::now() - RadioFrame::getPPDUDuration(RadioFrame::dataSize);
+        air.erase(remove_if(air.begin(), air.end(), [horizon](const Arrival& a) {
+            return a.frame->sendTime + RadioFrame::getPPDUDuration(a.frame->length) <= horizon;
+        }), air.end());
+        air.push_back({frame, power});
+        if(power < radio.getParameters().sensitivity) return; // Only interferes
+    }
+    switch(state)
+    {
+        case State::RECEIVING:
+            received = {frame, power};
+            generation++; // Cancel the timeout
+            run();
+            break;
+        case State::COLLECTING:
+            collected->push_back(frame);
+            break;
+        default: // The packet is lost
+            break;
+    }
+}
+
+void SimNode::run()
+{
+    running = this;
+    try {
+        coroutine.resume();
+    } catch(...) {
+        running = nullptr;
+        throw;
+    }
+    running = nullptr;
+    if(waitHook && !coroutine.isTerminated()) waitHook();
+}
+
+//
+// class Simulation
+//
+
+long long Simulation::currentTime = 0;
+
+Simulation::Simulation(unsigned int seed, const RadioModel& radio, unsigned int stackSize)
+    : stacks(stackSize), rng(seed), radio(radio) {}
+
+SimNode& Simulation::addNode(unsigned char address, function<void ()> body)
+{
+    nodes.emplace_back(new SimNode(*this, address, body));
+    SimNode *node = nodes.back().get();
+    schedule(0, node, nullptr, node->generation);
+    return *node;
+}
+
+void Simulation::connect(SimNode& a, SimNode& b, double loss)
+{
+    a.addNeighbor(&b, loss);
+    b.addNeighbor(&a, loss);
+}
+
+void Simulation::run(long long until)
+{
+    while(!queue.empty() && queue.top().time <= until)
+    {
+        Event e = queue.top();
+        queue.pop();
+        __atomic_store_n(&currentTime, e.time, __ATOMIC_RELAXED);
+        events++;
+        if(e.frame) e.node->frameArrived(e.frame, e.power);
+        else e.node->wakeup(e.generation);
+    }
+    __atomic_store_n(&currentTime, until, __ATOMIC_RELAXED);
+}
+
+void Simulation::schedule(long long when, SimNode *node, shared_ptr<const RadioFrame> frame,
+                          unsigned int generation, double power)
+{
+    queue.push({when, sequence++, node, frame, generation, power});
+}
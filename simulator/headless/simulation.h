@@ -0,0 +1,317 @@
+/***************************************************************************
+ *   Copyright (C) 2019 by Federico Terraneo                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   As a special exception, if other files instantiate templates or use   *
+ *   macros or inline functions from this file, or you compile this file   *
+ *   and link it with other works to produce a work based on this file,    *
+ *   this file does not by itself cause the resulting work to be covered   *
+ *   by the GNU General Public License. However the source code for this   *
+ *   file must still be made available in accordance with the GNU General  *
+ *   Public License. This exception does not invalidate any other reasons  *
+ *   why a work based on this file might be covered by the GNU General     *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ ***************************************************************************/
+
+#pragma once
+
+#include "coroutine.h"
+#include "radio_model.h"
+#include "interfaces-impl/transceiver.h"
+#include <vector>
+#include <queue>
+#include <memory>
+#include <random>
+#include <string>
+#include <functional>
+
+/**
+ * A packet on the air, the same as RadioMessage in the OMNeT++ simulator
+ */
+struct RadioFrame
+{
+    /**
+     * \param size payload size in bytes (including CRC if enabled)
+     * \return the time in ns required to send the packet
+     */
+    static long long getPPDUDuration(int size)
+    {
+        return size * 32000 + preambleSfdTimeNs + lenTimeNs;
+    }
+
+    static const int lenTimeNs = 32000;
+    static const int preambleSfdTimeNs = 160000;
+    static const int constructiveInterferenceTimeNs = 500;
+    static const int dataSize = 127;
+
+    long long sendTime; ///< Time when the first bit of the preamble is sent
+    unsigned char src;  ///< Address of the sender
+    int length;         ///< Payload size including CRC if enabled
+    unsigned char data[dataSize];
+};
+
+/**
+ * Thrown in the coroutine of a node when its disconnect time is reached.
+ * Not deriving from std::exception on purpose, otherwise it may be caught by
+ * some catch in network_module, especially in mac_context
+ */
+class DisconnectException {};
+
+class Simulation;
+
+/**
+ * A simulated node, running its body in a coroutine. While the coroutine
+ * waits, the node is either sleeping, and packets reaching it are lost,
+ * receiving, and the first packet reaching it wakes it up, or collecting, and
+ * packets reaching it are stored for the transceiver to compute interference.
+ * With the path loss model the packets reaching the node are also kept while
+ * on air whatever its state, to compute their interference, and only those
+ * above the sensitivity wake it up.
+ */
+class SimNode
+{
+public:
+    /**
+     * \param sim the simulation
+     * \param address node address
+     * \param body function run by the node coroutine
+     */
+    SimNode(Simulation& sim, unsigned char address, std::function<void ()> body);
+
+    SimNode(const SimNode&) = delete;
+    SimNode& operator=(const SimNode&) = delete;
+
+    /**
+     * \return the node whose coroutine is running, or nullptr
+     */
+    static SimNode *current() { return running; }
+
+    unsigned char getAddress() const { return address; }
+
+    /**
+     * \return the high-water mark of the coroutine stack in bytes
+     */
+    unsigned int getStackUsage() const { return coroutine.getStackUsage(); }
+
+    Simulation& getSimulation() { return sim; }
+
+    miosix::Transceiver& getTransceiver() { return transceiver; }
+
+    /**
+     * \param time time when the node stops, throwing DisconnectException
+     * from its coroutine
+     */
+    void setDisconnectTime(long long time) { disconnectTime = time; }
+
+    /**
+     * \param hook called each time the node coroutine waits, from the
+     * simulation thread. Used to start the application threads of a node
+     */
+    void setWaitHook(std::function<void ()> hook) { waitHook = hook; }
+
+    /**
+     * \param node a node hearing the packets sent by this one
+     * \param loss path loss in dB towards it, including shadowing
+     */
+    void addNeighbor(SimNode *node, double loss) { neighbors.push_back({node, loss}); }
+
+    /**
+     * Called from the node coroutine, sleep until the given time
+     */
+    void sleepUntil(long long when);
+
+    /**
+     * Called from the node coroutine, wait for a packet
+     * \param timeout absolute timeout
+     * \return the first packet reaching the node before the timeout, or one
+     * with a nullptr frame. The time when it is returned is the packet sendTime
+     */
+    Arrival receive(long long timeout);
+
+    /**
+     * Called from the node coroutine, wait collecting the packets reaching
+     * the node
+     * \param when time until which to wait
+     * \param frames the packets are appended here
+     */
+    void collectUntil(long long when, std::vector<std::shared_ptr<const RadioFrame>>& frames);
+
+    /**
+     * Only with the path loss model
+     * \param begin start of an interval
+     * \param end end of the interval
+     * \return the packets on air at the node during the interval
+     */
+    std::vector<Arrival> onAir(long long begin, long long end) const;
+
+    /**
+     * Called from the node coroutine, stop the node forever without unwinding
+     * its stack, that may still be used by the application threads
+     */
+    void halt();
+
+    /**
+     * Called from the node coroutine, send a packet to all the neighbors
+     * \param frame the packet, with sendTime equal to the current time
+     * \param txPower transmit power in dBm
+     */
+    void transmit(std::shared_ptr<const RadioFrame> frame, int txPower);
+
+    /**
+     * Print adding the node prefix at the beginning of each line
+     */
+    void print(const char *str);
+
+private:
+    enum class State { RUNNING, SLEEPING, RECEIVING, COLLECTING };
+
+    void suspend(State newState, long long when);
+    void wakeup(unsigned int generation);
+    void frameArrived(std::shared_ptr<const RadioFrame> frame, double power);
+    void run();
+
+    Simulation& sim;
+    unsigned char address;
+    Coroutine coroutine;
+    miosix::Transceiver transceiver;
+    struct Neighbor
+    {
+        SimNode *node;
+        double loss;
+    };
+
+    std::vector<Neighbor> neighbors;
+    std::function<void ()> waitHook;
+    long long disconnectTime;
+    State state = State::RUNNING;
+    unsigned int generation = 0; ///< Invalidates the pending wakeup events
+    bool disconnected = false;
+    Arrival received;
+    std::vector<Arrival> air; ///< Packets on air, only with the path loss model
+    std::vector<std::shared_ptr<const RadioFrame>> *collected = nullptr;
+    std::string line; ///< Partial line being printed
+
+    static thread_local SimNode *running; ///< nullptr in the other threads
+
+    friend class Simulation;
+};
+
+/**
+ * A discrete event simulation of a set of nodes, run by a single thread.
+ * Events at the same time are processed in the order they were scheduled
+ */
+class Simulation
+{
+public:
+    /**
+     * \param seed seed of the random number generator
+     * \param radio the channel model
+     * \param stackSize stack size of the node coroutines, only the memory
+     * actually used is committed, see StackPool
+     */
+    explicit Simulation(unsigned int seed, const RadioModel& radio = RadioModel(),
+                        unsigned int stackSize = defaultStackSize);
+
+    Simulation(const Simulation&) = delete;
+    Simulation& operator=(const Simulation&) = delete;
+
+    /**
+     * Add a node, whose coroutine will start at time 0
+     * \param address node address
+     * \param body function run by the node coroutine
+     * \return the node
+     */
+    SimNode& addNode(unsigned char address, std::function<void ()> body);
+
+    /**
+     * Make two nodes neighbors of each other
+     * \param loss path loss in dB of the link, used by the path loss model
+     */
+    void connect(SimNode& a, SimNode& b, double loss = 0);
+
+    /**
+     * Run the simulation
+     * \param until simulation time limit in ns
+     */
+    void run(long long until);
+
+    /**
+     * \return the simulation time in ns, can be called from any thread
+     */
+    static long long now() { return __atomic_load_n(&currentTime, __ATOMIC_RELAXED); }
+
+    /**
+     * \return a random integer in [0, n)
+     */
+    int uniform(int n) { return std::uniform_int_distribution<int>(0, n - 1)(rng); }
+
+    /**
+     * \return a random number in [0, 1)
+     */
+    double uniformReal() { return std::uniform_real_distribution<double>()(rng); }
+
+    /**
+     * \return a random number from a normal distribution with mean 0
+     */
+    double normal(double stddev) { return std::normal_distribution<double>(0, stddev)(rng); }
+
+    const RadioModel& getRadioModel() const { return radio; }
+
+    /**
+     * \return all the nodes, in the order they were added
+     */
+    const std::vector<std::unique_ptr<SimNode>>& getNodes() const { return nodes; }
+
+    unsigned int getStackSize() const { return stacks.getStackSize(); }
+
+    static const unsigned int defaultStackSize = 64*1024;
+
+    /**
+     * \return the number of events processed so far
+     */
+    unsigned long long getEvents() const { return events; }
+
+private:
+    struct Event
+    {
+        long long time;
+        unsigned long long sequence;
+        SimNode *node;
+        std::shared_ptr<const RadioFrame> frame; ///< nullptr for a wakeup
+        unsigned int generation;
+        double power; ///< Received power of the frame
+
+        bool operator>(const Event& other) const
+        {
+            if(time != other.time) return time > other.time;
+            return sequence > other.sequence;
+        }
+    };
+
+    void schedule(long long when, SimNode *node, std::shared_ptr<const RadioFrame> frame,
+                  unsigned int generation = 0, double power = 0);
+
+    StackPool stacks; ///< Declared before nodes, to be destroyed after them
+    std::vector<std::unique_ptr<SimNode>> nodes;
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> queue;
+    std::mt19937 rng;
+    RadioModel radio;
+    unsigned long long sequence = 0;
+    unsigned long long events = 0;
+
+    static long long currentTime;
+
+    friend class SimNode;
+};
@@ -0,0 +1,86 @@
+/***************************************************************************
+ *   Copyright (C) 2019 by Federico Terraneo                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   As a special exception, if other files instantiate templates or use   *
+ *   macros or inline functions from this file, or you compile this file   *
+ *   and link it with other works to produce a work based on this file,    *
+ *   this file does not by itself cause the resulting work to be covered   *
+ *   by the GNU General Public License. However the source code for this   *
+ *   file must still be made available in accordance with the GNU General  *
+ *   Public License. This exception does not invalidate any other reasons  *
+ *   why a work based on this file might be covered by the GNU General     *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ ***************************************************************************/
+
+#include "stack_pool.h"
+#include <new>
+#include <vector>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace std;
+
+StackPool::StackPool(unsigned int stackSize) : pageSize(sysconf(_SC_PAGESIZE))
+{
+    this->stackSize = (stackSize + pageSize - 1) / pageSize * pageSize;
+}
+
+StackPool::~StackPool()
+{
+    for(auto *slab : slabs) munmap(slab, (pageSize + stackSize) * stacksPerSlab);
+}
+
+char *StackPool::allocate()
+{
+    if(freeStacks.empty())
+    {
+        // Each stack is preceded by its guard page
+        size_t slabSize = (pageSize + stackSize) * stacksPerSlab;
+        void *p = mmap(nullptr, slabSize, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if(p == MAP_FAILED) throw bad_alloc();
+        char *slab = reinterpret_cast<char*>(p);
+        slabs.push_back(slab);
+        // Pushed in reverse so that stacks are allocated in address order
+        for(int i = stacksPerSlab - 1; i >= 0; i--)
+        {
+            char *guard = slab + i * (pageSize + stackSize);
+            if(mprotect(guard, pageSize, PROT_NONE) != 0) throw bad_alloc();
+            freeStacks.push_back(guard + pageSize);
+        }
+    }
+    char *result = freeStacks.back();
+    freeStacks.pop_back();
+    return result;
+}
+
+void StackPool::release(char *stack)
+{
+    // Give the memory back, so that a reused stack starts untouched
+    madvise(stack, stackSize, MADV_DONTNEED);
+    freeStacks.push_back(stack);
+}
+
+unsigned int StackPool::usage(const char *stack) const
+{
+    unsigned int pages = stackSize / pageSize;
+    vector<unsigned char> resident(pages);
+    if(mincore(const_cast<char*>(stack), stackSize, resident.data()) != 0) return 0;
+    // The lowest resident page is the deepest the stack has grown
+    for(unsigned int i = 0; i < pages; i++)
+        if(resident[i] & 1) return (pages - i) * pageSize;
+    return 0;
+}
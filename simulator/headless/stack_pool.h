@@ -0,0 +1,84 @@
+/***************************************************************************
+ *   Copyright (C) 2019 by Federico Terraneo                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   As a special exception, if other files instantiate templates or use   *
+ *   macros or inline functions from this file, or you compile this file   *
+ *   and link it with other works to produce a work based on this file,    *
+ *   this file does not by itself cause the resulting work to be covered   *
+ *   by the GNU General Public License. However the source code for this   *
+ *   file must still be made available in accordance with the GNU General  *
+ *   Public License. This exception does not invalidate any other reasons  *
+ *   why a work based on this file might be covered by the GNU General     *
+ *   Public License.                                                       *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ ***************************************************************************/
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+/**
+ * Allocator of coroutine stacks, all of the same size, carved out of large
+ * mmap()ed slabs. Each stack has a guard page below it, so an overflow
+ * crashes instead of corrupting the nearby stack, and its memory is committed
+ * by the kernel only when touched, so the memory footprint of a simulation is
+ * the stack actually used by its nodes rather than the stack size. This also
+ * allows to measure the stack usage from the pages touched, with no need to
+ * fill the stack with a pattern.
+ */
+class StackPool
+{
+public:
+    /**
+     * \param stackSize stack size in bytes, rounded up to a multiple of the
+     * page size
+     */
+    explicit StackPool(unsigned int stackSize);
+
+    StackPool(const StackPool&) = delete;
+    StackPool& operator=(const StackPool&) = delete;
+
+    ~StackPool();
+
+    /**
+     * \return the lowest address of a stack of getStackSize() bytes
+     * \throws bad_alloc if out of memory
+     */
+    char *allocate();
+
+    /**
+     * \param stack a stack returned by allocate(), that can be reused
+     */
+    void release(char *stack);
+
+    /**
+     * \param stack a stack returned by allocate()
+     * \return the number of bytes of the stack that have been used, with page
+     * granularity, as the stack grows downwards
+     */
+    unsigned int usage(const char *stack) const;
+
+    unsigned int getStackSize() const { return stackSize; }
+
+    /// Stacks allocated by each mmap()
+    static const int stacksPerSlab = 64;
+
+private:
+    unsigned int pageSize;
+    unsigned int stackSize;
+    std::vector<char*> slabs;
+    std::vector<char*> freeStacks;
+};
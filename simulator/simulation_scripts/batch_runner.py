@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+
+# Runs a matrix of scalability experiments with the headless simulator, in
+# parallel on all cores and with multiple seeds, and merges the results into
+# one CSV with the mean and 95% confidence interval of each scenario.
+#
+# Each line of the matrix file is a scenario:
+#   experiment topology nodes maxnodes hops simtime
+# where experiment is formation, connect or disconnect (the same experiments of
+# scalability_networkformation.sh, scalability_nodeconnect.sh and
+# scalability_nodefailure.sh), topology is hex or rhex and simtime is in
+# seconds. Fields may be comma separated lists, expanded to all combinations.
+#
+# The convergence times are computed by event_analyzer from the event log of
+# the simulator, so no particular debug_settings.h is needed. Build with:
+#   cmake -S ../headless -B ../../build-sim -DCMAKE_BUILD_TYPE=Release
+#   cmake --build ../../build-sim -j
+#   make -C ../tools
+# --keep-logs also stores the print_dbg output of each run.
+
+import argparse
+import csv
+import itertools
+import math
+import os
+import subprocess
+import sys
+from concurrent.futures import ThreadPoolExecutor
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+TOOLS = os.path.join(HERE, '..', 'tools')
+
+EXPERIMENTS = ['formation', 'connect', 'disconnect']
+TOPOLOGIES = {'hex': ('Hex', 0), 'rhex': ('RHex', 1)}
+
+# Two-sided 95% Student t quantiles for 1 to 30 degrees of freedom
+T95 = [12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+       2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+       2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042]
+
+parser = argparse.ArgumentParser(description='Run a matrix of simulations in parallel')
+parser.add_argument('matrix', help='scenario matrix file')
+parser.add_argument('--sim', default=os.path.join(HERE, '..', '..', 'build-sim', 'tdmh_sim'),
+                    help='path of the tdmh_sim executable')
+parser.add_argument('--seeds', type=int, default=5, help='runs per scenario')
+parser.add_argument('--jobs', type=int, default=os.cpu_count(), help='parallel simulations')
+parser.add_argument('--workdir', default='batch', help='directory of the runs')
+parser.add_argument('--output', default='results.csv', help='merged results')
+parser.add_argument('--keep-logs', action='store_true', help='store the simulator output')
+parser.add_argument('--sim-option', action='append', default=[],
+                    help='option passed to tdmh_sim, such as --**.uplink_discovery_interval=4')
+args = parser.parse_args()
+
+nedgen = os.path.join(TOOLS, 'nedgen_hexagon')
+analyzer = os.path.join(TOOLS, 'event_analyzer')
+for path, hint in ((args.sim, 'build it as explained in ' + sys.argv[0]),
+                   (nedgen, 'run make in ' + TOOLS), (analyzer, 'run make in ' + TOOLS)):
+    if not os.access(path, os.X_OK):
+        print("{} not found, {}".format(path, hint))
+        quit(1)
+
+scenarios = []
+with open(args.matrix, "r") as file:
+    for line in file:
+        fields = line.split('#')[0].split()
+        if not fields:
+            continue
+        if len(fields) != 6:
+            print("Wrong scenario: {}".format(line.strip()))
+            quit(1)
+        lists = [f.split(',') for f in fields]
+        for experiment, topology, n, maxn, h, simtime in itertools.product(*lists):
+            if experiment not in EXPERIMENTS or topology not in TOPOLOGIES:
+                print("Wrong scenario: {}".format(line.strip()))
+                quit(1)
+            scenarios.append((experiment, topology, int(n), int(maxn), int(h), int(simtime)))
+
+
+def run(scenario, seed):
+    """Run one simulation in its own directory, return the measured time or None"""
+    experiment, topology, n, maxn, h, simtime = scenario
+    prefix, reverse = TOPOLOGIES[topology]
+    name = "{}{}_{}".format(prefix, n, maxn)
+    rundir = os.path.join(args.workdir, "{}_{}_h{}_t{}_s{}".format(experiment, name, h, simtime, seed))
+    os.makedirs(rundir, exist_ok=True)
+    command = [nedgen, name, str(n), str(maxn), str(h), str(simtime), str(reverse)]
+    if experiment != 'formation':
+        # The same node and time as the shell scripts
+        node = n - 1 if topology == 'hex' else 1
+        command.append("{} {} {}".format(node, experiment, simtime // 2))
+    subprocess.run(command, cwd=rundir, stdout=subprocess.DEVNULL, check=True)
+    events = os.path.join(rundir, name + '.events')
+    log = open(os.path.join(rundir, name + '.log'), "w") if args.keep_logs else subprocess.DEVNULL
+    subprocess.run([os.path.abspath(args.sim), "--seed={}".format(seed),
+                    "--event-log={}".format(name + '.events')] + args.sim_option
+                   + [name + '.ini'], cwd=rundir, stdout=log, stderr=subprocess.DEVNULL)
+    if args.keep_logs:
+        log.close()
+    result = subprocess.run([analyzer, experiment, events], stdout=subprocess.PIPE,
+                            stderr=subprocess.PIPE, universal_newlines=True)
+    try:
+        value = float(result.stdout.strip())
+    except ValueError:
+        value = None
+        print("{}: {}".format(rundir, (result.stdout + result.stderr).strip()))
+    with open(os.path.join(rundir, 'result.txt'), "w") as out:
+        out.write("{}\n".format(value))
+    return value
+
+
+runs = [(s, seed) for s in scenarios for seed in range(args.seeds)]
+print("{} scenarios, {} runs on {} jobs".format(len(scenarios), len(runs), args.jobs))
+with ThreadPoolExecutor(max_workers=args.jobs) as executor:
+    values = list(executor.map(lambda r: run(*r), runs))
+
+with open(args.output, "w", newline='') as file:
+    writer = csv.writer(file)
+    writer.writerow(['experiment', 'topology', 'nodes', 'maxnodes', 'hops', 'simtime',
+                     'runs', 'converged', 'mean', 'stddev', 'ci95_low', 'ci95_high'])
+    for scenario in scenarios:
+        samples = [v for (s, _), v in zip(runs, values) if s == scenario and v is not None]
+        row = list(scenario) + [args.seeds, len(samples)]
+        if samples:
+            mean = sum(samples) / len(samples)
+            if len(samples) > 1:
+                stddev = math.sqrt(sum((x - mean) ** 2 for x in samples) / (len(samples) - 1))
+                t = T95[len(samples) - 2] if len(samples) - 1 <= len(T95) else 1.96
+                half = t * stddev / math.sqrt(len(samples))
+            else:
+                stddev = half = float('nan')
+            row += ["{:.3f}".format(x) for x in (mean, stddev, mean - half, mean + half)]
+        else:
+            row += [''] * 4
+        writer.writerow(row)
+print("Results written to {}".format(args.output))
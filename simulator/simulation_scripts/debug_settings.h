@@ -107,6 +107,18 @@ const bool ENABLE_DATA_ERROR_DBG = true;
 //prints the Stream Manager info messages
 const bool ENABLE_STREAM_MGR_INFO_DBG = true;
 
+//measures the worst-case processing times of the MAC phases and periodically
+//prints the SlotTimings to configure to shrink the slots
+const bool ENABLE_SLOT_CALIBRATION = false;
+
+//print_dbg output as hex dumps of the binary log records, to be decoded
+//offline with experiments/scripts/binlog_decoder.py (only on Miosix)
+const bool BINARY_LOG_RAW_DUMP = false;
+
+//prints the MAC trace once per control superframe, to be analyzed with
+//experiments/scripts/mac_trace_analyzer.py
+const bool ENABLE_MAC_TRACE_DBG = false;
+
 
 #ifdef _MIOSIX
 #define DEBUG_MESSAGES_IN_SEPARATE_THREAD
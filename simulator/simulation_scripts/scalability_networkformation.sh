@@ -32,6 +32,11 @@ cd ../WandstemMac || fail
 MODE=debug make || fail
 cd -
 
+# Additional simulator options, for example to measure the convergence time
+# with the adaptive uplink and uplink spatial reuse use
+# SIM_OPTIONS="--**.uplink_discovery_interval=4 --**.uplink_spatial_reuse=true"
+SIM_OPTIONS=${SIM_OPTIONS:-}
+
 # Parameters
 # $1 number of nodes
 # $2 max number of nodes
@@ -47,7 +52,7 @@ function hex_topology_experiment {
     ../../WandstemMac/out/clang-debug/src/WandstemMac_dbg -m -u Cmdenv  \
             -n .:../../WandstemMac/src "Hex$1_$2.ini"                   \
             --cmdenv-express-mode=false --cmdenv-log-prefix="%l %o %N:" \
-            > /dev/null || fail
+            $SIM_OPTIONS > /dev/null || fail
     
     perl ../../tools/postprocess.pl "results/Hex$1_$2.elog" || fail
 
@@ -71,7 +76,7 @@ function rhex_topology_experiment {
     ../../WandstemMac/out/clang-debug/src/WandstemMac_dbg -m -u Cmdenv  \
             -n .:../../WandstemMac/src "RHex$1_$2.ini"                   \
             --cmdenv-express-mode=false --cmdenv-log-prefix="%l %o %N:" \
-            > /dev/null || fail
+            $SIM_OPTIONS > /dev/null || fail
     
     perl ../../tools/postprocess.pl "results/RHex$1_$2.elog" || fail
 
@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+
+# Benchmark of the headless simulator: simulation events per second, memory
+# and coroutine stack usage against the number of nodes, on hexagon networks
+# generated by simulator/tools/nedgen_hexagon. Build tdmh_sim as explained in
+# HOWTOSIMULATE and nedgen_hexagon with make in simulator/tools.
+
+import argparse
+import os
+import re
+import subprocess
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+TOOLS = os.path.join(HERE, '..', 'tools')
+
+# Nodes and hops of the networks, as in the scalability experiments
+SIZES = [(8, 2), (16, 2), (32, 3), (64, 5), (128, 7)]
+
+parser = argparse.ArgumentParser(description='Benchmark the headless simulator')
+parser.add_argument('--sim', default=os.path.join(HERE, '..', '..', 'build-sim', 'tdmh_sim'),
+                    help='path of the tdmh_sim executable')
+parser.add_argument('--simtime', type=int, default=100, help='simulated seconds')
+parser.add_argument('--stack-size', type=int, default=0,
+                    help='coroutine stack size, 0 for the tdmh_sim default')
+parser.add_argument('--nodes', type=int, nargs='*', default=[n for n, _ in SIZES],
+                    help='node counts to benchmark')
+args = parser.parse_args()
+
+stats_re = re.compile(r'simulated [\d.]+s in (?P<wall>[\d.]+)s, (?P<events>\d+) events')
+stack_re = re.compile(r'max stack usage (?P<usage>\d+) of (?P<size>\d+) bytes')
+
+print("{:>6} {:>10} {:>8} {:>12} {:>10} {:>12}".format(
+      'nodes', 'events', 'wall s', 'events/s', 'max RSS MB', 'stack bytes'))
+with tempfile.TemporaryDirectory() as workdir:
+    for n in args.nodes:
+        hops = next((h for size, h in SIZES if size >= n), SIZES[-1][1])
+        name = "Bench{}".format(n)
+        subprocess.run([os.path.join(TOOLS, 'nedgen_hexagon'), name, str(n), str(n),
+                        str(hops), str(args.simtime), '0'],
+                       cwd=workdir, stdout=subprocess.DEVNULL, check=True)
+        command = [os.path.abspath(args.sim), name + '.ini']
+        if args.stack_size > 0:
+            command.insert(1, "--stack-size={}".format(args.stack_size))
+        process = subprocess.Popen(command, cwd=workdir, stdout=subprocess.DEVNULL,
+                                   stderr=subprocess.PIPE, universal_newlines=True)
+        output = process.stderr.read()
+        # wait4 gives the resource usage of this child only
+        _, status, usage = os.wait4(process.pid, 0)
+        stats = stats_re.search(output)
+        stack = stack_re.search(output)
+        if status != 0 or not stats or not stack:
+            print("{:>6} failed: {}".format(n, output.strip()))
+            continue
+        wall = float(stats.group('wall'))
+        events = int(stats.group('events'))
+        print("{:>6} {:>10} {:>8.2f} {:>12.0f} {:>10.1f} {:>12}".format(
+              n, events, wall, events / wall if wall > 0 else 0,
+              usage.ru_maxrss / 1024, stack.group('usage')))
@@ -0,0 +1,242 @@
+/***************************************************************************
+ *   Copyright (C) 2019 by Terraneo Federico                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ ***************************************************************************/
+
+/*
+ * Analyzer of the EventLog written by the headless simulator with
+ * --event-log, computing in one pass the same metrics of convergencetime.pl,
+ * connecttime.pl and disconnecttime.pl without depending on the print_dbg
+ * output nor on a specific debug_settings.h. The links of the network are
+ * taken from the NETWORK_LINK events, so the .ned file is not needed.
+ * Usage: event_analyzer <formation|connect|disconnect|streams> <event log>
+ */
+
+#include "network_module/util/event_log.h"
+#include "network_module/stream/stream_parameters.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <map>
+#include <string>
+#include <vector>
+#include <utility>
+#include <functional>
+
+using namespace std;
+using namespace mxnet;
+
+static const bool verbose=false; // Prints more info
+
+[[noreturn]] static void die(const char *msg)
+{
+    fprintf(stderr,"%s\n",msg);
+    exit(1);
+}
+
+/**
+ * Call f with each record of the event log, reading it in large blocks
+ */
+static void readEvents(const char *filename, function<void (const EventRecord&)> f)
+{
+    FILE *in=fopen(filename,"rb");
+    if(in==nullptr) die("can't open event log");
+    vector<EventRecord> block(65536);
+    size_t n;
+    while((n=fread(block.data(),sizeof(EventRecord),block.size(),in))>0)
+        for(size_t i=0;i<n;i++) f(block[i]);
+    fclose(in);
+}
+
+/**
+ * The topology collection convergence time, as computed by the perl scripts:
+ * from a start event to the first topology computed by the master equal to
+ * the links of the network, provided that it never differs afterwards
+ */
+class Convergence
+{
+public:
+    explicit Convergence(const string& experiment) : experiment(experiment) {}
+
+    void event(const EventRecord& e)
+    {
+        double t=e.time/1e9;
+        switch(e.type)
+        {
+            case EventType::NETWORK_LINK:
+                links.insert(e.arg);
+                break;
+            case EventType::LINK_UP:
+                topology.insert(e.arg);
+                break;
+            case EventType::LINK_DOWN:
+                topology.erase(e.arg);
+                break;
+            case EventType::TOPOLOGY:
+                topologyComputed(t);
+                break;
+            case EventType::TIMESYNC:
+                // Topology collection starts when clock synchronization error
+                // is less than the configured threshold. In the simulator clock
+                // skew/drift is not simulated so the error always becomes 0
+                // after the sync error skew is estimated the first time.
+                if(experiment=="formation" && e.node==1 && e.value==0 && flag==0) flag=1;
+                break;
+            case EventType::NODE_START:
+                if(experiment=="connect") startMark(t,e.node,"Multiple node start events");
+                break;
+            case EventType::NODE_STOP:
+                if(experiment=="disconnect") startMark(t,e.node,"Multiple node stop events");
+                break;
+            default:
+                break;
+        }
+    }
+
+    void print()
+    {
+        if(flag==0) die("wrong event log, missing events?");
+        if(verbose) printf("convergence time=");
+        if(end<0) printf("does not converge\n");
+        else printf("%.15g\n",end-start);
+    }
+
+private:
+    void topologyComputed(double t)
+    {
+        if(experiment=="formation")
+        {
+            if(flag==0) start=t; // We want the last time before clock sync is ok
+            if(flag==1)
+            {
+                flag=2;
+                if(verbose) printf("start=%.15g\n",start);
+            }
+        }
+        if(flag==2 && topology==links)
+        {
+            end=t;
+            if(verbose) printf("end=%.15g\n",end);
+            flag=3;
+        }
+        if(flag==3 && topology!=links)
+        {
+            end=-1;
+            if(verbose) printf("wrong topology after convergence @ %.15g\n",t);
+        }
+    }
+
+    void startMark(double t, unsigned char node, const char *error)
+    {
+        if(flag!=0) die(error);
+        flag=2;
+        start=t;
+        if(verbose) printf("start=%.15g\n",start);
+        if(experiment=="disconnect")
+        {
+            // The node that disconnects is no longer expected in the topology
+            for(auto it=links.begin();it!=links.end();)
+            {
+                if((*it>>8)==node || (*it&0xff)==node) it=links.erase(it);
+                else ++it;
+            }
+        }
+    }
+
+    const string experiment;
+    set<unsigned int> links;    ///< Links of the network, as a<<8|b
+    set<unsigned int> topology; ///< Links of the master topology
+    int flag=0;                 ///< 2 once started, 3 once converged
+    double start=0;
+    double end=-1;
+};
+
+/**
+ * Per stream statistics
+ */
+class Streams
+{
+public:
+    void event(const EventRecord& e)
+    {
+        switch(e.type)
+        {
+            case EventType::SCHEDULE:
+                if(e.node==0) schedules++;
+                break;
+            case EventType::STREAM_STATE:
+                if(e.value==static_cast<int>(StreamStatus::ESTABLISHED)
+                   && streams[e.arg].established<0)
+                    streams[e.arg].established=e.time;
+                break;
+            case EventType::PACKET_RECV:
+                streams[e.arg].received++;
+                streams[e.arg].rssi+=e.value;
+                break;
+            case EventType::PACKET_MISS:
+                streams[e.arg].missed++;
+                break;
+            default:
+                break;
+        }
+    }
+
+    void print()
+    {
+        printf("%u schedules activated\n",schedules);
+        for(auto& s : streams)
+        {
+            unsigned int key=s.first;
+            auto& st=s.second;
+            printf("(%u,%u,%u,%u)",key&0xff,(key>>8)&0xff,(key>>16)&0xf,(key>>20)&0xf);
+            if(st.established>=0) printf(" established=%.9f",st.established/1e9);
+            unsigned int total=st.received+st.missed;
+            if(total>0)
+                printf(" PRR=%.2f%% (%u/%u) rssi=%.1f",100.0*st.received/total,
+                       st.received,total,st.received>0 ? st.rssi/st.received : 0.0);
+            printf("\n");
+        }
+    }
+
+private:
+    struct Stats
+    {
+        long long established=-1;
+        unsigned int received=0;
+        unsigned int missed=0;
+        double rssi=0;
+    };
+
+    unsigned int schedules=0;
+    map<unsigned int,Stats> streams;
+};
+
+int main(int argc, char *argv[])
+{
+    if(argc!=3)
+        die("use: event_analyzer <formation|connect|disconnect|streams> <event log>");
+    string experiment=argv[1];
+    if(experiment=="streams")
+    {
+        Streams s;
+        readEvents(argv[2],[&](const EventRecord& e){ s.event(e); });
+        s.print();
+    } else if(experiment=="formation" || experiment=="connect" || experiment=="disconnect") {
+        Convergence c(experiment);
+        readEvents(argv[2],[&](const EventRecord& e){ c.event(e); });
+        c.print();
+    } else die("unknown experiment");
+}
@@ -0,0 +1,159 @@
+/***************************************************************************
+ *   Copyright (C) 2019 by Terraneo Federico                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ ***************************************************************************/
+
+#include "topology_generator.h"
+#include <iostream>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <cmath>
+
+using namespace std;
+
+/**
+ * The key=value options of the command line, each can be read only once
+ */
+class Options
+{
+public:
+    Options(int argc, char *argv[])
+    {
+        for(int i = 3; i < argc; i++)
+        {
+            string arg = argv[i];
+            auto eq = arg.find('=');
+            if(eq == string::npos) throw runtime_error("Wrong option "+arg);
+            options[arg.substr(0, eq)] = arg.substr(eq + 1);
+        }
+    }
+
+    string get(const string& key, const string& def)
+    {
+        auto it = options.find(key);
+        if(it == options.end()) return def;
+        string result = it->second;
+        options.erase(it);
+        return result;
+    }
+
+    double get(const string& key, double def)
+    {
+        return stod(get(key, to_string(def)));
+    }
+
+    /**
+     * \return a connect or disconnect option, <node id>,<time in s>
+     */
+    ConnectData getConnect()
+    {
+        ConnectData result;
+        for(string key : {"connect", "disconnect"})
+        {
+            string value = get(key, "");
+            if(value.empty()) continue;
+            auto comma = value.find(',');
+            if(comma == string::npos) throw runtime_error("Wrong "+key+" option");
+            result.nodeId = stoi(value.substr(0, comma));
+            result.connect = key == "connect";
+            result.time = stoll(value.substr(comma + 1));
+        }
+        return result;
+    }
+
+    /**
+     * \throws runtime_error if some option was not read
+     */
+    void checkAllUsed() const
+    {
+        if(!options.empty()) throw runtime_error("Unknown option "+options.begin()->first);
+    }
+
+private:
+    map<string, string> options;
+};
+
+int main(int argc, char *argv[])
+{
+    if(argc < 3)
+    {
+        cerr<<"use: ./topogen type n [key=value...]"<<endl
+            <<" type = line, rline, star, grid, hex, rhex, rgg (random geometric),"<<endl
+            <<"        cluster, building"<<endl
+            <<" n    = number of nodes"<<endl
+            <<"Writes name.ned, name.ini, name.edges and name.loss if some links are lossy"<<endl
+            <<"Options, with their default:"<<endl
+            <<" seed=0 name=<type><n> simtime=100 maxn=<n rounded up to 8> hops=<max hops>"<<endl
+            <<" open_stream=1 connect=<node>,<time in s> disconnect=<node>,<time in s>"<<endl
+            <<" cols=<about sqrt(n)> (grid) clusters=4 spread=<range/3> side (rgg, cluster)"<<endl
+            <<" floors=3 width=<4*range> depth=<range> (building)"<<endl
+            <<"Link model, distances in units of the @display positions/100:"<<endl
+            <<" loss=0 (regular topologies) range=1 reliable=0.5 max_loss=0.3"<<endl
+            <<" floor_loss=0.2 jitter=0 meters_per_unit=10"<<endl;
+        return 1;
+    }
+    try {
+        string type = argv[1];
+        int n = stoi(argv[2]);
+        Options options(argc, argv);
+        unsigned int seed = options.get("seed", 0.0);
+        LinkModel model;
+        model.loss = options.get("loss", model.loss);
+        model.range = options.get("range", model.range);
+        model.reliable = options.get("reliable", model.reliable);
+        model.maxLoss = options.get("max_loss", model.maxLoss);
+        model.floorLoss = options.get("floor_loss", model.floorLoss);
+        model.jitter = options.get("jitter", model.jitter);
+        TopologyGenerator generator(seed, model);
+
+        Topology t;
+        if(type == "line" || type == "rline") t = generator.line(n, type == "rline");
+        else if(type == "star") t = generator.star(n);
+        else if(type == "hex" || type == "rhex") t = generator.hexagon(n, type == "rhex");
+        else if(type == "rgg") t = generator.randomGeometric(n, options.get("side", 0.0));
+        else if(type == "grid")
+        {
+            int cols = sqrt(n);
+            while(cols > 1 && n % cols != 0) cols--;
+            cols = options.get("cols", cols);
+            if(cols <= 0 || n % cols != 0) throw runtime_error("cols does not divide n");
+            t = generator.grid(n / cols, cols);
+        } else if(type == "cluster") {
+            int clusters = options.get("clusters", 4);
+            double spread = options.get("spread", 0.0);
+            t = generator.clustered(n, clusters, spread, options.get("side", 0.0));
+        } else if(type == "building") {
+            int floors = options.get("floors", 3);
+            double width = options.get("width", 0.0);
+            t = generator.building(n, floors, width, options.get("depth", 0.0));
+        } else throw runtime_error("Unknown topology "+type);
+
+        t.name = options.get("name", t.name);
+        t.simTime = options.get("simtime", t.simTime);
+        t.maxNodes = options.get("maxn", t.maxNodes);
+        t.maxHops = options.get("hops", t.maxHops);
+        t.openStream = options.get("open_stream", 1) != 0;
+        t.metersPerUnit = options.get("meters_per_unit", t.metersPerUnit);
+        t.connect = options.getConnect();
+        options.checkAllUsed();
+        t.write();
+        cout<<t.name<<": "<<t.nodes.size()<<" nodes, "<<t.links.size()
+            <<" links, "<<t.hops()<<" hops"<<endl;
+    } catch(exception& e) {
+        cerr<<e.what()<<endl;
+        return 1;
+    }
+}
@@ -0,0 +1,395 @@
+/***************************************************************************
+ *   Copyright (C) 2019 by Terraneo Federico                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ ***************************************************************************/
+
+#include "topology_generator.h"
+#include <fstream>
+#include <queue>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+
+using namespace std;
+
+/// Pixels per unit of the @display positions
+static const double displayScale = 100;
+
+static double distance(const TopologyNode& a, const TopologyNode& b)
+{
+    return sqrt((a.x-b.x)*(a.x-b.x)+(a.y-b.y)*(a.y-b.y));
+}
+
+//
+// class Topology
+//
+
+int Topology::hops() const
+{
+    vector<vector<int>> neighbors(nodes.size());
+    for(auto& l : links)
+    {
+        neighbors[l.a].push_back(l.b);
+        neighbors[l.b].push_back(l.a);
+    }
+    vector<int> hop(nodes.size(), -1);
+    queue<int> q;
+    hop[0] = 0;
+    q.push(0);
+    int result = 0;
+    while(!q.empty())
+    {
+        int i = q.front();
+        q.pop();
+        result = max(result, hop[i]);
+        for(int j : neighbors[i])
+        {
+            if(hop[j] >= 0) continue;
+            hop[j] = hop[i] + 1;
+            q.push(j);
+        }
+    }
+    if(find(hop.begin(), hop.end(), -1) != hop.end()) return -1;
+    return result;
+}
+
+bool Topology::lossy() const
+{
+    for(auto& l : links) if(l.loss > 0) return true;
+    return false;
+}
+
+void Topology::writeNed(ostream& os) const
+{
+    int n = nodes.size();
+    int maxn = maxNodes > 0 ? maxNodes : (n + 7) / 8 * 8;
+    int h = maxHops > 0 ? maxHops : max(hops(), 1);
+    os<<"import wandstemmac.Node;\n"
+      <<"import wandstemmac.RootNode;\n\n"
+      <<"// Generated with seed "<<seed<<"\n"
+      <<"network "<<name<<"\n"
+      <<"{\n"
+      <<"    parameters:\n"
+      <<"        n*.nodes = "<<maxn<<";\n"
+      <<"        n*.hops = "<<h<<";\n";
+    if(openStream == false) os<<"        n*.open_stream = false;\n";
+    os<<"    submodules:\n";
+    // Positions are shifted so that all nodes are visible in OMNeT++
+    double minX = 0, minY = 0;
+    for(auto& node : nodes)
+    {
+        minX = min(minX, node.x);
+        minY = min(minY, node.y);
+    }
+    for(int i = 0; i < n; i++)
+    {
+        os<<"        n"<<i<<": "<<(i == 0 ? "RootNode" : "Node")<<" {\n"
+          <<"            address = "<<i<<";\n";
+        if(i == connect.nodeId)
+        {
+            if(connect.connect) os<<"            connect_time = ";
+            else                os<<"            disconnect_time = ";
+            os<<connect.time*1000000000LL<<";\n";
+        }
+        os<<"            @display(\"p="<<(nodes[i].x - minX + 0.5)*displayScale<<","
+          <<(nodes[i].y - minY + 0.5)*displayScale<<"\");\n"
+          <<"        }\n";
+    }
+    os<<"    connections:\n";
+    for(auto& l : links)
+        os<<"        n"<<l.a<<".wireless++ <--> n"<<l.b<<".wireless++;\n";
+    os<<"}\n";
+}
+
+void Topology::writeIni(ostream& os) const
+{
+    os<<"[General]\n"
+      <<"network = "<<name<<"\n"
+      <<"eventlog-file = ${resultdir}/"<<name<<".elog\n"
+      <<"experiment-label = "<<name<<"\n"
+      <<"sim-time-limit = "<<simTime<<"s\n"
+      <<"record-eventlog = true\n"
+      <<"**.meters_per_unit = "<<metersPerUnit/displayScale<<"\n";
+    if(lossy()) os<<"**.loss_trace = \""<<name<<".loss\"\n";
+}
+
+void Topology::writeLossTrace(ostream& os) const
+{
+    os<<"# "<<name<<", generated with seed "<<seed<<"\n"
+      <<"# <time in s> <src> <dst> <loss probability>\n";
+    for(auto& l : links)
+    {
+        if(l.loss <= 0) continue;
+        os<<"0 "<<l.a<<" "<<l.b<<" "<<l.loss<<"\n"
+          <<"0 "<<l.b<<" "<<l.a<<" "<<l.loss<<"\n";
+    }
+}
+
+void Topology::writeEdges(ostream& os) const
+{
+    os<<"# "<<name<<", generated with seed "<<seed<<"\n"
+      <<"# <node> <node> <loss probability>\n";
+    for(auto& l : links) os<<l.a<<" "<<l.b<<" "<<l.loss<<"\n";
+}
+
+void Topology::write() const
+{
+    auto writeFile = [this](const string& extension, void (Topology::*f)(ostream&) const) {
+        ofstream out(name + extension);
+        (this->*f)(out);
+        if(!out) throw runtime_error(string("Can't write ") + name + extension);
+    };
+    writeFile(".ned", &Topology::writeNed);
+    writeFile(".ini", &Topology::writeIni);
+    writeFile(".edges", &Topology::writeEdges);
+    if(lossy()) writeFile(".loss", &Topology::writeLossTrace);
+}
+
+//
+// class TopologyGenerator
+//
+
+Topology TopologyGenerator::line(int n, bool reverse)
+{
+    Topology t = make(reverse ? "RLine" : "Line", n);
+    // Node 0 at one end, followed by 1,2,...,n-1 or n-1,n-2,...,1
+    auto position = [=](int i) { return i == 0 || reverse == false ? i : n - i; };
+    for(int i = 0; i < n; i++) t.nodes[i].x = position(i);
+    for(int p = 0; p < n - 1; p++)
+    {
+        int a = reverse && p > 0 ? n - p : p;
+        int b = reverse ? n - p - 1 : p + 1;
+        addLink(t, a, b, model.loss);
+    }
+    return t;
+}
+
+Topology TopologyGenerator::star(int n)
+{
+    Topology t = make("Star", n);
+    for(int i = 1; i < n; i++)
+    {
+        t.nodes[i].x = cos(2 * M_PI * i / (n - 1));
+        t.nodes[i].y = sin(2 * M_PI * i / (n - 1));
+        addLink(t, 0, i, model.loss);
+    }
+    return t;
+}
+
+Topology TopologyGenerator::grid(int rows, int cols)
+{
+    Topology t = make("Grid", rows * cols);
+    t.name = "Grid" + to_string(rows) + "x" + to_string(cols);
+    for(int r = 0; r < rows; r++)
+    {
+        for(int c = 0; c < cols; c++)
+        {
+            int i = r * cols + c;
+            t.nodes[i].x = c;
+            t.nodes[i].y = r;
+            if(c > 0) addLink(t, i - 1, i, model.loss);
+            if(r > 0) addLink(t, i - cols, i, model.loss);
+        }
+    }
+    return t;
+}
+
+Topology TopologyGenerator::hexagon(int n, bool reverse, function<void (int, const TopologyNode&)> callback)
+{
+    Topology t = make(reverse ? "RHex" : "Hex", n);
+    if(n <= 0) return t;
+    vector<pair<TopologyNode, int>> points;
+
+    auto exists = [&](const TopologyNode& p) {
+        for(auto& q : points) if(distance(p, q.first) < 0.05) return &q;
+        return static_cast<pair<TopologyNode, int>*>(nullptr);
+    };
+
+    auto move = [](TopologyNode p, int direction) {
+        // Move in a hexagon
+        // 0=right, 1=lower right, 2=lower left, 3=left, 4=upper left 5=upper right
+        p.x += cos(-M_PI / 3 * direction);
+        p.y += sin(-M_PI / 3 * direction);
+        return p;
+    };
+
+    auto add = [&](TopologyNode p, int id) {
+        t.nodes[id] = p;
+        if(callback) callback(id, p);
+        for(int i = 0; i < 6; i++)
+            if(auto *q = exists(move(p, i))) addLink(t, id, q->second, model.loss);
+        points.push_back(make_pair(p, id));
+    };
+
+    TopologyNode p;
+    add(p, 0); // Add the first point
+    int id = reverse ? n - 1 : 1;
+    int count = 0;
+    if(++count >= n) return t;
+    for(int radius = 1;; radius++)
+    {
+        p = move(p, 0); // Gone full circle, move right
+        add(p, reverse ? id-- : id++);
+        if(++count >= n) return t;
+        int direction = 2; // Start by moving down, left
+        do {
+            for(int i = 0; i < radius; i++)
+            {
+                p = move(p, direction);
+                if(exists(p)) continue; // Happens the last time in a circle
+                add(p, id);
+                reverse ? id-- : id++;
+                if(++count >= n) return t;
+            }
+            direction = (direction + 1) % 6;
+        } while(direction != 2);
+    }
+}
+
+Topology TopologyGenerator::randomGeometric(int n, double side)
+{
+    // n nodes in side^2 have pi*range^2*n/side^2 neighbors on average
+    if(side <= 0) side = model.range * sqrt(M_PI * n / 8);
+    return connected([=]{
+        Topology t = make("Rgg", n);
+        for(auto& node : t.nodes)
+        {
+            node.x = uniform() * side;
+            node.y = uniform() * side;
+        }
+        linkInRange(t, 0, n);
+        return t;
+    });
+}
+
+Topology TopologyGenerator::clustered(int n, int clusters, double spread, double side)
+{
+    if(clusters <= 0 || clusters > n) throw runtime_error("clusters must be between 1 and n");
+    if(spread <= 0) spread = model.range / 3;
+    if(side <= 0) side = 2 * model.range * sqrt(clusters);
+    return connected([=]{
+        Topology t = make("Cluster", n);
+        t.name += "_" + to_string(clusters);
+        vector<TopologyNode> centers(clusters);
+        for(auto& c : centers)
+        {
+            c.x = uniform() * side;
+            c.y = uniform() * side;
+        }
+        // The root is at the center of the first cluster, the other nodes
+        // are assigned to the clusters in turn
+        t.nodes[0] = centers[0];
+        for(int i = 1; i < n; i++)
+        {
+            t.nodes[i].x = centers[i % clusters].x + normal() * spread;
+            t.nodes[i].y = centers[i % clusters].y + normal() * spread;
+        }
+        linkInRange(t, 0, n);
+        return t;
+    });
+}
+
+Topology TopologyGenerator::building(int n, int floors, double width, double depth)
+{
+    if(floors <= 0 || floors > n) throw runtime_error("floors must be between 1 and n");
+    if(width <= 0) width = 4 * model.range;
+    if(depth <= 0) depth = model.range;
+    return connected([=]{
+        Topology t = make("Building", n);
+        t.name += "_" + to_string(floors);
+        // Position within the floor and floor of each node, the nodes are
+        // assigned to the floors in turn starting from the root at floor 0
+        vector<TopologyNode> plan(n);
+        vector<int> floor(n);
+        for(int i = 0; i < n; i++)
+        {
+            plan[i].x = uniform() * width;
+            plan[i].y = uniform() * depth;
+            floor[i] = i % floors;
+            t.nodes[i].x = plan[i].x;
+            t.nodes[i].y = plan[i].y + (floors - 1 - floor[i]) * (depth + model.range);
+        }
+        for(int i = 0; i < n; i++)
+        {
+            for(int j = i + 1; j < n; j++)
+            {
+                double d = distance(plan[i], plan[j]);
+                if(floor[i] == floor[j] && d <= model.range)
+                    addLink(t, i, j, linkLoss(d));
+                else if(abs(floor[i] - floor[j]) == 1 && d <= model.range / 2)
+                    addLink(t, i, j, linkLoss(d) + model.floorLoss);
+            }
+        }
+        return t;
+    });
+}
+
+Topology TopologyGenerator::make(const string& name, int n)
+{
+    if(n <= 0 || n > 256) throw runtime_error("the number of nodes must be between 1 and 256");
+    Topology t(name + to_string(n));
+    t.seed = seed;
+    t.nodes.resize(n);
+    return t;
+}
+
+void TopologyGenerator::addLink(Topology& t, int a, int b, double loss)
+{
+    if(model.jitter > 0) loss += (2 * uniform() - 1) * model.jitter;
+    t.links.push_back({a, b, min(max(loss, 0.0), 1.0)});
+}
+
+void TopologyGenerator::linkInRange(Topology& t, int first, int last)
+{
+    for(int i = first; i < last; i++)
+    {
+        for(int j = i + 1; j < last; j++)
+        {
+            double d = distance(t.nodes[i], t.nodes[j]);
+            if(d <= model.range) addLink(t, i, j, linkLoss(d));
+        }
+    }
+}
+
+Topology TopologyGenerator::connected(function<Topology ()> generate)
+{
+    for(int i = 0; i < maxAttempts; i++)
+    {
+        Topology t = generate();
+        if(t.hops() >= 0) return t;
+    }
+    throw runtime_error("can't generate a connected topology, increase the range");
+}
+
+double TopologyGenerator::linkLoss(double distance) const
+{
+    // Lossless up to reliable*range, then the transitional region of low
+    // power radios, approximated as a linear increase
+    double reliableRange = model.reliable * model.range;
+    if(distance <= reliableRange) return 0;
+    return model.maxLoss * (distance - reliableRange) / (model.range - reliableRange);
+}
+
+double TopologyGenerator::uniform()
+{
+    return rng() / (static_cast<double>(rng.max()) + 1);
+}
+
+double TopologyGenerator::normal()
+{
+    // Box-Muller, uniform() can return 0 but not 1
+    double u = 1 - uniform();
+    return sqrt(-2 * log(u)) * cos(2 * M_PI * uniform());
+}
@@ -0,0 +1,202 @@
+/***************************************************************************
+ *   Copyright (C) 2019 by Terraneo Federico                               *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
+ ***************************************************************************/
+
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include <limits>
+#include <random>
+#include <functional>
+
+/**
+ * A node of a generated topology, positions are in units of the radio range
+ * of the regular topologies
+ */
+struct TopologyNode
+{
+    double x = 0, y = 0;
+};
+
+/**
+ * A bidirectional link of a generated topology
+ */
+struct TopologyLink
+{
+    int a, b;    ///< Node ids
+    double loss; ///< Packet loss probability
+};
+
+/**
+ * A node to connect or disconnect during the simulation, as the connstr of
+ * nedgen_hexagon
+ */
+struct ConnectData
+{
+    int nodeId = -1;
+    bool connect = true;
+    long long time = 0; ///< In seconds
+};
+
+/**
+ * A generated topology, written in the formats of all the tools so that they
+ * run on the same network:
+ * - name.ned and name.ini for the OMNeT++ and headless simulators, node n0
+ *   is the RootNode and the nodes have @display positions
+ * - name.loss, the loss_trace of the headless simulator with the loss
+ *   probability of the links, only written if some link is lossy
+ * - name.edges, the "a b loss" edge list read by the scheduler test
+ */
+class Topology
+{
+public:
+    explicit Topology(const std::string& name="") : name(name) {}
+
+    /**
+     * \return the maximum number of hops from node 0, or -1 if some node
+     * can't reach it
+     */
+    int hops() const;
+
+    /**
+     * \return true if any link loses packets
+     */
+    bool lossy() const;
+
+    void writeNed(std::ostream& os) const;
+    void writeIni(std::ostream& os) const;
+    void writeLossTrace(std::ostream& os) const;
+    void writeEdges(std::ostream& os) const;
+
+    /**
+     * Write all the files, in the current directory
+     * \throws runtime_error if a file can't be written
+     */
+    void write() const;
+
+    std::string name;
+    unsigned int seed = 0;
+    std::vector<TopologyNode> nodes; ///< Indexed by node id
+    std::vector<TopologyLink> links;
+
+    // Parameters of the simulation, written in the .ned and .ini
+    int maxNodes = 0;      ///< n*.nodes, if 0 the node count rounded up to 8
+    int maxHops = 0;       ///< n*.hops, if 0 hops()
+    bool openStream = true;
+    int simTime = 100;     ///< sim-time-limit in seconds
+    double metersPerUnit = 10; ///< **.meters_per_unit for --**.radio_model=path_loss
+    ConnectData connect;
+};
+
+/**
+ * How the link quality is derived by TopologyGenerator
+ */
+struct LinkModel
+{
+    /// Loss of the links of the regular topologies (line, star, grid, hexagon)
+    double loss = 0;
+    /// Maximum distance of the links of the geometric topologies
+    double range = 1;
+    /// Fraction of the range up to which links of the geometric topologies
+    /// are lossless, then the loss grows linearly up to maxLoss at the range
+    double reliable = 0.5;
+    double maxLoss = 0.3;
+    /// Additional loss of links crossing a floor
+    double floorLoss = 0.2;
+    /// Uniformly distributed random variation of the loss of every link
+    double jitter = 0;
+};
+
+/**
+ * Generates the topologies used by the simulators and the scheduler test.
+ * All the random choices are made with a generator seeded with the given
+ * seed, so a topology can be generated again from its parameters and seed.
+ * Node 0 is the root in all topologies.
+ */
+class TopologyGenerator
+{
+public:
+    TopologyGenerator(unsigned int seed, const LinkModel& model = LinkModel())
+        : seed(seed), rng(seed), model(model) {}
+
+    /**
+     * \param reverse if true node 1 is at the end of the line
+     */
+    Topology line(int n, bool reverse);
+
+    Topology star(int n);
+
+    /**
+     * A grid of 4-connected nodes, numbered by row from a corner
+     */
+    Topology grid(int rows, int cols);
+
+    /**
+     * Nodes on a hexagonal lattice, filled in rings around the root as
+     * nedgen_hexagon always did
+     * \param reverse if true the node ids are assigned from the outermost
+     * node inwards
+     * \param callback called when a node is placed, with its id and position
+     */
+    Topology hexagon(int n, bool reverse,
+                     std::function<void (int, const TopologyNode&)> callback = nullptr);
+
+    /**
+     * Nodes uniformly placed in a square, linked if within range
+     * \param side side of the square, if 0 chosen for an average of about
+     * eight neighbors
+     */
+    Topology randomGeometric(int n, double side = 0);
+
+    /**
+     * Clusters of nodes normally distributed around centers uniformly placed
+     * in a square
+     * \param spread standard deviation of the distance from the center, if 0
+     * a third of the range
+     * \param side side of the square, if 0 chosen so that the clusters are
+     * about two ranges apart
+     */
+    Topology clustered(int n, int clusters, double spread = 0, double side = 0);
+
+    /**
+     * A building with nodes uniformly placed in floors of width x depth,
+     * linked if within range on the same floor, and if less than half the
+     * range apart horizontally on adjacent floors, with model.floorLoss
+     * additional loss. The floors are displayed one above the other.
+     * \param width width of the floors, if 0 four ranges
+     * \param depth depth of the floors, if 0 one range
+     */
+    Topology building(int n, int floors, double width = 0, double depth = 0);
+
+    /// Attempts at generating a connected random topology before giving up
+    static const int maxAttempts = 1000;
+
+private:
+    Topology make(const std::string& name, int n);
+    void addLink(Topology& t, int a, int b, double loss);
+    void linkInRange(Topology& t, int first, int last);
+    Topology connected(std::function<Topology ()> generate);
+    double linkLoss(double distance) const;
+    double uniform();
+    double normal();
+
+    unsigned int seed;
+    /// mt19937 is specified by the standard, unlike the distributions
+    std::mt19937 rng;
+    LinkModel model;
+};
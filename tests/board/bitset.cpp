@@ -25,13 +25,18 @@
  *   along with this program; if not, see <http://www.gnu.org/licenses/>   *
  ***************************************************************************/
 
-#include "../../network_module/uplink/topology/runtime_bitset.h"
+#include "../../network_module/util/runtime_bitset.h"
 #include <miosix.h>
 #include <cstdio>
 #include <cstdlib>
 
 using namespace mxnet;
 
+// The tests use bitsets of up to 256 bits
+#if defined(TDMH_FIXED_MAX_NODES) && TDMH_FIXED_MAX_NODES < 256
+#error "Build with TDMH_FIXED_MAX_NODES undefined or 256"
+#endif
+
 void test_result(const char* text, bool result) {
     iprintf("Test: ");
     iprintf(text);
@@ -118,9 +123,14 @@ void correct_move() {
         vals[i] = a[i];
     }
     RuntimeBitset b(std::move(a));
+#ifndef TDMH_FIXED_MAX_NODES
     bool safe = a.data() == nullptr;
+#else
+    // The bits are in the object, moving is copying
+    bool safe = a.data() != b.data();
+#endif
     for (int i = 0; i < 256; i++)
-        safe = vals[i] == b[i];
+        safe &= vals[i] == b[i];
     test_result("move constructor", safe);
 
     RuntimeBitset c(256);
@@ -128,22 +138,143 @@ void correct_move() {
         c[i] = rand() % 2;
         vals[i] = c[i];
     }
-    RuntimeBitset d = std::move(c);
+    RuntimeBitset d(256);
+    d = std::move(c);
+#ifndef TDMH_FIXED_MAX_NODES
     safe = c.data() == nullptr;
+#else
+    safe = c.data() != d.data();
+#endif
     for (int i = 0; i < 256; i++)
-        safe = vals[i] == d[i];
+        safe &= vals[i] == d[i];
     test_result("move assignment", safe);
 }
 
+void correct_bulk_ops() {
+    bool a[256], b[256];
+    RuntimeBitset x(256, false), y(256, false);
+    for (int i = 0; i < 256; i++) {
+        x[i] = a[i] = rand() % 2;
+        y[i] = b[i] = rand() % 3 == 0;
+    }
+    RuntimeBitset r = x;
+    r &= y;
+    bool safe = true;
+    for (int i = 0; i < 256; i++)
+        safe &= r[i] == (a[i] && b[i]);
+    test_result("and", safe);
+    r = x;
+    r |= y;
+    safe = true;
+    for (int i = 0; i < 256; i++)
+        safe &= r[i] == (a[i] || b[i]);
+    test_result("or", safe);
+    r = x;
+    r ^= y;
+    safe = true;
+    for (int i = 0; i < 256; i++)
+        safe &= r[i] == (a[i] != b[i]);
+    test_result("xor", safe);
+    r = x;
+    r.andNot(y);
+    safe = true;
+    for (int i = 0; i < 256; i++)
+        safe &= r[i] == (a[i] && !b[i]);
+    test_result("and not", safe);
+    safe = false;
+    try {
+        RuntimeBitset z(248, false);
+        r &= z;
+    } catch(std::range_error&) {
+        safe = true;
+    }
+    test_result("size mismatch is detected", safe);
+}
+
+void correct_count() {
+    // 24 bits so that the non word-sized tail is also tested
+    RuntimeBitset r(24, false);
+    bool safe = r.count() == 0 && r.none() && !r.any() && r.empty();
+    std::size_t expected = 0;
+    for (int i = 0; i < 24; i += 5) {
+        r[i] = true;
+        expected++;
+    }
+    safe &= r.count() == expected && r.any() && !r.none();
+    RuntimeBitset full(256, true);
+    safe &= full.count() == 256;
+    test_result("count, any, none", safe);
+}
+
+void correct_comparisons() {
+    RuntimeBitset a(64, false), b(64, false);
+    bool safe = a == b;
+    a[63] = true;
+    safe &= a != b;
+    b[63] = true;
+    safe &= a == b;
+    test_result("equality", safe);
+}
+
+void correct_find() {
+    bool safe = true;
+    // Single bits, in every position, on a size that is not a multiple of 32
+    for (int i = 0; i < 72; i++) {
+        RuntimeBitset r(72, false);
+        r[i] = true;
+        safe &= r.findFirst() == static_cast<std::size_t>(i);
+        safe &= r.findNext(i) == static_cast<std::size_t>(i);
+        safe &= r.findNext(i + 1) == r.bitSize();
+    }
+    test_result("find next set bit", safe);
+    bool vals[256];
+    RuntimeBitset r(256, false);
+    for (int i = 0; i < 256; i++)
+        r[i] = vals[i] = rand() % 4 == 0;
+    safe = true;
+    int prev = -1;
+    for (auto i : r.setBits()) {
+        for (int j = prev + 1; j < static_cast<int>(i); j++)
+            safe &= !vals[j];
+        safe &= vals[i];
+        prev = i;
+    }
+    for (int j = prev + 1; j < 256; j++)
+        safe &= !vals[j];
+    test_result("set bit iterator", safe);
+    // The bit order within a byte depends on the architecture, so the search
+    // is checked against operator[] and not against raw bytes
+    RuntimeBitset w(80, false);
+    for (int i : {3, 10, 31, 32, 45, 79})
+        w[i] = true;
+    safe = true;
+    for (int from = 0; from <= 80; from++) {
+        int expected = from;
+        while (expected < 80 && !w[expected])
+            expected++;
+        safe &= w.findNext(from) == static_cast<std::size_t>(expected);
+    }
+    int expected = 0;
+    for (auto i : w.setBits()) {
+        while (!w[expected])
+            expected++;
+        safe &= i == static_cast<std::size_t>(expected++);
+    }
+    test_result("find agrees with operator[]", safe);
+}
+
 int main() {
     mem_read();
     mem_write();
     correct_values();
     correct_copy();
     correct_move();
+    correct_bulk_ops();
+    correct_count();
+    correct_comparisons();
+    correct_find();
     /* TODO
      * correct_cast();
      * correct_full_init();
-     * correct_comparisons();
      */
 }
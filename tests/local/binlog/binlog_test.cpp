@@ -0,0 +1,94 @@
+#include <iostream>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <cassert>
+#include "util/binary_log.h"
+
+using namespace std;
+using namespace mxnet;
+
+// Same size as the buffer of DebugPrinter
+const int maxMessageSize = 160;
+
+BinaryLogRecord encode(const char *fmt, ...)
+{
+    BinaryLogRecord record;
+    va_list args;
+    va_start(args, fmt);
+    record.encode(fmt, args);
+    va_end(args);
+    return record;
+}
+
+string expected(const char *fmt, ...)
+{
+    char str[maxMessageSize];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(str, sizeof(str), fmt, args);
+    va_end(args);
+    return str;
+}
+
+string format(const BinaryLogRecord& record)
+{
+    char str[maxMessageSize];
+    record.format(str, sizeof(str));
+    return str;
+}
+
+/*
+ * The [MT] line of MACTrace::print() with the longest event name and values
+ */
+void testMACTrace()
+{
+    const char *fmt = "[MT] n=%d t=%lld p=%d e=%s sl=%d s=%d,%d,%d,%d nd=%d r=%d err=%d\n";
+    BinaryLogRecord record = encode(fmt, 255, -1234567890123456789LL, 2, "dbufmiss",
+                                    -2147483647, 255, 255, 15, 15, 255, -128, -2147483647);
+    assert(record.isTruncated() == false);
+    assert(format(record) == expected(fmt, 255, -1234567890123456789LL, 2, "dbufmiss",
+                                      -2147483647, 255, 255, 15, 15, 255, -128, -2147483647));
+}
+
+/*
+ * The [U] Topo lines of NetworkTopology::doReceivedTopology(), with the
+ * bitmaps of 256 nodes and weak topologies split in lines of 48 characters
+ */
+void testTopology()
+{
+    const char *fmt = "[U] Topo %03d: %s\n";
+    string s = "[";
+    for(int i = 0; i < 256; i++) s += i % 3 ? '1' : '0';
+    s += "][";
+    for(int i = 0; i < 256; i++) s += i % 2 ? '1' : '0';
+    s += ']';
+
+    const unsigned int lineSize = 48;
+    string joined;
+    for(unsigned int i = 0; i < s.size(); i += lineSize)
+    {
+        string line = s.substr(i, lineSize);
+        BinaryLogRecord record = encode(fmt, 254, line.c_str());
+        assert(record.isTruncated() == false);
+        assert(format(record) == expected(fmt, 254, line.c_str()));
+        joined += line;
+    }
+    assert(joined == s);
+
+    // The whole bitmap does not fit, it must be reported as truncated
+    BinaryLogRecord record = encode(fmt, 254, s.c_str());
+    assert(record.isTruncated());
+    string result = format(record);
+    assert(result.find("[truncated]") != string::npos);
+    assert(result.compare(0, 14, "[U] Topo 254: ") == 0);
+}
+
+int main()
+{
+    testMACTrace();
+    testTopology();
+
+    cout<<"ok"<<endl;
+    return 0;
+}
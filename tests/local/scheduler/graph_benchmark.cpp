@@ -0,0 +1,62 @@
+
+#include <cstdio>
+#include <chrono>
+#include "uplink_phase/topology/network_graph.h"
+
+using namespace std;
+using namespace std::chrono;
+using namespace mxnet;
+
+/*
+ * Time the graph operations used by the scheduler on a network of
+ * benchNodes nodes, to compare the available network graph implementations
+ */
+template<typename Graph>
+long long benchmarkGraph(const char *name)
+{
+#ifdef TDMH_FIXED_MAX_NODES
+    // Graphs can't be larger than the network in this build
+    const int benchNodes = TDMH_FIXED_MAX_NODES;
+#else
+    const int benchNodes = 256;
+#endif
+    const int iterations = 100;
+    auto start = steady_clock::now();
+    unsigned checksum = 0;
+    for(int k = 0; k < iterations; k++)
+    {
+        Graph graph(benchNodes);
+        // Each node is connected to the nodes at distance 1, 2 and 16,
+        // that is a grid 16 nodes wide with some extra neighbors
+        for(int i = 0; i < benchNodes; i++)
+            for(int d : {1, 2, 16})
+                if(i + d < benchNodes) graph.addEdge(i, i + d);
+        // Cut a node off to force a walk
+        for(int d : {1, 2, 16})
+        {
+            graph.removeEdge(benchNodes - 1, benchNodes - 1 - d);
+        }
+        graph.removeUnreachableNodes();
+        for(int i = 0; i < benchNodes; i++)
+        {
+            if(!graph.hasNode(i)) continue;
+            for(auto j : graph.getEdges(i)) checksum += graph.hasEdge(j, i);
+        }
+        checksum += graph.getEdges().size();
+    }
+    auto elapsed = duration_cast<microseconds>(steady_clock::now() - start).count();
+    printf("[B] %s: %lldus for %d iterations (checksum %u)\n",
+           name, static_cast<long long>(elapsed), iterations, checksum);
+    return elapsed;
+}
+
+/*
+ * Usage: graph_benchmark
+ * Kept out of scheduler_test, which only checks the scheduler
+ */
+int main()
+{
+    benchmarkGraph<ImmediateRemovalNetworkGraph>("ImmediateRemovalNetworkGraph");
+    benchmarkGraph<DenseNetworkGraph>("DenseNetworkGraph");
+    return 0;
+}
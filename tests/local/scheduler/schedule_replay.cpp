@@ -0,0 +1,252 @@
+
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <vector>
+#include <stdexcept>
+#include "scheduler/schedule_computation.h"
+#include "scheduler/schedule_capture.h"
+#include "util/packet.h"
+
+using namespace std;
+using namespace std::chrono;
+using namespace mxnet;
+
+struct CaptureRecord
+{
+    CaptureType type;
+    unsigned int tile;
+    vector<unsigned char> payload;
+};
+
+/*
+ * Read a capture written by the master with a ScheduleCapture sink, such as
+ * the one of the headless simulator --schedule-capture option
+ */
+vector<CaptureRecord> readCapture(const char *path)
+{
+    ifstream in(path, ios::binary);
+    if(!in) throw runtime_error(string("Can't open ")+path);
+    vector<CaptureRecord> records;
+    for(;;)
+    {
+        unsigned char header[ScheduleCapture::headerSize];
+        if(!in.read(reinterpret_cast<char*>(header), sizeof(header))) break;
+        CaptureRecord r;
+        r.type = static_cast<CaptureType>(header[0]);
+        r.tile = header[1] | header[2] << 8 | header[3] << 16 | header[4] << 24;
+        r.payload.resize(header[5] | header[6] << 8);
+        if(!in.read(reinterpret_cast<char*>(r.payload.data()), r.payload.size()))
+            throw runtime_error("Truncated capture");
+        records.push_back(move(r));
+    }
+    return records;
+}
+
+/*
+ * Reads the little endian fields of a CONFIGURATION record
+ */
+class ConfigurationReader
+{
+public:
+    explicit ConfigurationReader(const vector<unsigned char>& payload) : payload(payload) {}
+
+    unsigned long long get(unsigned int bytes)
+    {
+        if(pos + bytes > payload.size()) throw runtime_error("Truncated configuration");
+        unsigned long long result = 0;
+        for(unsigned int i = 0; i < bytes; i++)
+            result |= static_cast<unsigned long long>(payload[pos++]) << (8 * i);
+        return result;
+    }
+
+    short getShort() { return static_cast<short>(get(2)); }
+
+private:
+    const vector<unsigned char>& payload;
+    unsigned int pos = 0;
+};
+
+/*
+ * The configuration of the captured master, with the same parameters
+ * passed to the ScheduleComputation by the MasterMACContext
+ */
+struct ReplayConfiguration
+{
+    unsigned char maxHops, staticHop, guaranteedTopologies, numUplinkPackets;
+    unsigned char maxMissedTimesyncs, uplinkDiscoveryInterval, miniSlotPayloadSize;
+    unsigned short maxNodes, networkId, panId;
+    unsigned short maxRoundsUnavailableBecomesDead, maxRoundsWeakLinkBecomesDead;
+    short txPower, minNeighborRSSI, minWeakNeighborRSSI;
+    unsigned int baseFrequency, superframeBitmask;
+    int superframeSize, dataProcessing, uplinkPacketProcessing, downlinkRebroadcastProcessing;
+    unsigned long long clockSyncPeriod, tileDuration, maxAdmittedRcvWindow, maxClockSyncPeriod;
+    bool channelSpatialReuse, useWeakTopologies, uplinkSpatialReuse;
+    unsigned slotsPerTile, dataslotsPerDownlinkTile, dataslotsPerUplinkTile;
+
+    /*
+     * The fields in the order of ScheduleCapture::configuration()
+     */
+    explicit ReplayConfiguration(ConfigurationReader r)
+    {
+        maxHops = r.get(1);
+        maxNodes = r.get(2);
+        networkId = r.get(2);
+        staticHop = r.get(1);
+        panId = r.get(2);
+        txPower = r.getShort();
+        baseFrequency = r.get(4);
+        clockSyncPeriod = r.get(8);
+        guaranteedTopologies = r.get(1);
+        numUplinkPackets = r.get(1);
+        tileDuration = r.get(8);
+        maxAdmittedRcvWindow = r.get(8);
+        maxRoundsUnavailableBecomesDead = r.get(2);
+        maxRoundsWeakLinkBecomesDead = r.get(2);
+        minNeighborRSSI = r.getShort();
+        minWeakNeighborRSSI = r.getShort();
+        maxMissedTimesyncs = r.get(1);
+        channelSpatialReuse = r.get(1);
+        useWeakTopologies = r.get(1);
+        superframeBitmask = r.get(4);
+        superframeSize = r.get(1);
+        uplinkDiscoveryInterval = r.get(1);
+        uplinkSpatialReuse = r.get(1);
+        dataProcessing = r.get(4);
+        uplinkPacketProcessing = r.get(4);
+        downlinkRebroadcastProcessing = r.get(4);
+        miniSlotPayloadSize = r.get(1);
+        maxClockSyncPeriod = r.get(8);
+        slotsPerTile = r.get(4);
+        dataslotsPerDownlinkTile = r.get(4);
+        dataslotsPerUplinkTile = r.get(4);
+    }
+
+    NetworkConfiguration get() const
+    {
+        return NetworkConfiguration(maxHops, maxNodes, networkId, staticHop, panId,
+            txPower, baseFrequency, clockSyncPeriod, guaranteedTopologies,
+            numUplinkPackets, tileDuration, maxAdmittedRcvWindow,
+            maxRoundsUnavailableBecomesDead, maxRoundsWeakLinkBecomesDead,
+            minNeighborRSSI, minWeakNeighborRSSI, maxMissedTimesyncs,
+            channelSpatialReuse, useWeakTopologies,
+            ControlSuperframeStructure(superframeBitmask, superframeSize),
+            uplinkDiscoveryInterval, uplinkSpatialReuse,
+            SlotTimings(dataProcessing, uplinkPacketProcessing, downlinkRebroadcastProcessing),
+            miniSlotPayloadSize, maxClockSyncPeriod);
+    }
+};
+
+/*
+ * Usage: schedule_replay <capture>
+ * Feeds the captured topologies and SMEs to a ScheduleComputation in the
+ * same order and runs the scheduler in the same tiles as the master did,
+ * timing every reschedule. The scheduler runs in this thread, so unlike on
+ * the master a reschedule always completes in the tile it begins, and the
+ * replay is deterministic.
+ */
+int main(int argc, char *argv[])
+{
+    if(argc != 2)
+    {
+        cerr<<"use: schedule_replay <capture>"<<endl;
+        return 1;
+    }
+    try {
+        auto records = readCapture(argv[1]);
+        if(records.empty() || records.front().type != CaptureType::CONFIGURATION)
+            throw runtime_error("The capture does not begin with the configuration");
+        ReplayConfiguration rc(ConfigurationReader(records.front().payload));
+        const NetworkConfiguration config = rc.get();
+
+        ScheduleComputation scheduler(config, rc.slotsPerTile,
+            rc.dataslotsPerDownlinkTile, rc.dataslotsPerUplinkTile);
+        auto& streamCollection = *scheduler.getStreamCollection();
+        NetworkTopology topology(config);
+        scheduler.setTopology(&topology);
+
+        UpdatableQueue<unsigned char, TopologyElement> topologies;
+        UpdatableQueue<SMEKey, StreamManagementElement> smes;
+        // The master passes all the topologies received in an uplink slot
+        // at once, then all the SMEs
+        auto flushTopologies = [&]{ topology.handleTopologies(topologies); };
+        auto flushSMEs = [&]{ streamCollection.receiveSMEs(smes); };
+
+        int reschedules = 0, skipped = 0;
+        long long total = 0, slowest = 0;
+        unsigned int slowestTile = 0;
+        for(auto& r : records)
+        {
+            Packet pkt;
+            if(!r.payload.empty()) pkt.put(r.payload.data(), r.payload.size());
+            switch(r.type)
+            {
+                case CaptureType::CONFIGURATION:
+                    break;
+                case CaptureType::TOPOLOGY:
+                {
+                    flushSMEs();
+                    TopologyElement t(config.getMaxNodes(), config.getUseWeakTopologies());
+                    t.deserialize(pkt);
+                    topologies.enqueue(t.getId(), move(t));
+                    break;
+                }
+                case CaptureType::SME:
+                {
+                    flushTopologies();
+                    StreamManagementElement sme;
+                    sme.deserialize(pkt);
+                    smes.enqueue(sme.getKey(), sme);
+                    break;
+                }
+                case CaptureType::BEGIN_SCHEDULING:
+                {
+                    flushTopologies();
+                    flushSMEs();
+                    // The scheduler thread does not wake up until the
+                    // last schedule has been applied
+                    if(scheduler.needToSendSchedule())
+                    {
+                        skipped++;
+                        break;
+                    }
+                    auto start = steady_clock::now();
+                    bool rescheduled = scheduler.step();
+                    auto elapsed = duration_cast<microseconds>(steady_clock::now() - start).count();
+                    if(rescheduled == false) break;
+                    vector<ScheduleElement> schedule;
+                    unsigned long id;
+                    unsigned int tiles;
+                    scheduler.getSchedule(schedule, id, tiles);
+                    printf("[R] tile=%u time=%lldus links=%d streams=%d id=%lu elements=%d tiles=%u\n",
+                           r.tile, static_cast<long long>(elapsed),
+                           static_cast<int>(topology.getGraph().getEdges().size()),
+                           static_cast<int>(streamCollection.getStreams().size()),
+                           id, static_cast<int>(schedule.size()), tiles);
+                    reschedules++;
+                    total += elapsed;
+                    if(elapsed > slowest)
+                    {
+                        slowest = elapsed;
+                        slowestTile = r.tile;
+                    }
+                    break;
+                }
+                case CaptureType::SCHEDULE_APPLIED:
+                    flushTopologies();
+                    flushSMEs();
+                    scheduler.scheduleSentAndApplied();
+                    break;
+                default:
+                    throw runtime_error("Unknown record type");
+            }
+        }
+        printf("[R] %d reschedules in %d tiles, total %lldus, average %lldus, "
+               "slowest %lldus at tile %u, %d wakeups while a schedule was pending\n",
+               reschedules, records.back().tile + 1, total,
+               reschedules > 0 ? total / reschedules : 0, slowest, slowestTile, skipped);
+    } catch(exception& e) {
+        cerr<<e.what()<<endl;
+        return 1;
+    }
+}
@@ -3,6 +3,12 @@
 #include <thread>
 #include <chrono>
 #include "scheduler/schedule_computation.h"
+#include "scheduler/schedule_element.h"
+#include "util/packet.h"
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <sstream>
 
 using namespace std;
 using namespace std::chrono;
@@ -24,10 +30,151 @@ inline int maxForwardedTopologiesFromMaxNumNodes(int maxNumNodes)
     return std::min<int>(packetCapacity * topologySMERatio, maxNumNodes - 2);
 }
 
-int main()
+static bool sameElement(const ScheduleElement& a, const ScheduleElement& b)
 {
-    const int maxNodes = 16;
-    const int maxHops = 6;
+    StreamParameters pa = a.getParams(), pb = b.getParams();
+    return a.getKey() == b.getKey() && a.getTx() == b.getTx() &&
+           a.getRx() == b.getRx() && a.getOffset() == b.getOffset() &&
+           memcmp(&pa, &pb, sizeof(StreamParameters)) == 0;
+}
+
+/*
+ * Serialize a schedule in as many packets as needed with the fixed size or
+ * compact encoding, parse it back and check it is unchanged
+ * \return the number of packets
+ */
+int roundTripSchedule(const vector<ScheduleElement>& schedule, bool compact)
+{
+    vector<ScheduleElement> parsed;
+    unsigned int i = 0;
+    int packets = 0;
+    do {
+        SchedulePacket spkt(6);
+        ScheduleHeader header(1,0,1,0,0,0,0,0,compact);
+        // Only delta headers carry the base schedule and removed streams
+        assert(header.size() == ScheduleHeader::maxSize(false));
+        spkt.setHeader(header);
+        for(; i < schedule.size(); i++)
+        {
+            ScheduleElement e = schedule[i];
+            spkt.putElement(e);
+            if(spkt.size() > MediumAccessController::maxControlPktSize)
+            {
+                spkt.popElements(1);
+                break;
+            }
+        }
+        Packet pkt;
+        spkt.serialize(pkt);
+        assert(pkt.size() == spkt.size());
+        SchedulePacket rx(6);
+        rx.deserialize(pkt);
+        assert(rx.getHeader().isCompact() == compact);
+        auto elements = rx.getElements();
+        parsed.insert(parsed.end(), elements.begin(), elements.end());
+        packets++;
+    } while(i < schedule.size());
+    assert(parsed.size() == schedule.size());
+    for(unsigned int j = 0; j < parsed.size(); j++) assert(sameElement(parsed[j], schedule[j]));
+    return packets;
+}
+
+/*
+ * Check the removed streams and info elements of a delta schedule packet
+ */
+void testDeltaSchedulePacket(const vector<ScheduleElement>& schedule, bool compact)
+{
+    SchedulePacket spkt(6);
+    ScheduleHeader header(1,0,2,0,0,0,1,1,compact);
+    spkt.setHeader(header);
+    ScheduleElement removed = schedule.at(0);
+    ScheduleElement added = schedule.at(1);
+    InfoElement info(StreamId(3,0,0,1), InfoType::STREAM_REJECT);
+    spkt.putRemovedStream(removed);
+    spkt.putElement(added);
+    spkt.putInfoElement(info);
+    Packet pkt;
+    spkt.serialize(pkt);
+    assert(pkt.size() == spkt.size());
+    SchedulePacket rx(6);
+    rx.deserialize(pkt);
+    assert(rx.getHeader().isDelta() && rx.getHeader().getBaseScheduleID() == 1);
+    assert(rx.getHeader().getRemovedStreams() == 1);
+    assert(rx.getRemovedStreams().size() == 1);
+    assert(rx.getRemovedStreams()[0].getStreamId() == removed.getStreamId());
+    auto elements = rx.getElements();
+    assert(elements.size() == 2 && sameElement(elements[0], added));
+    assert(InfoElement(elements[1]).getType() == InfoType::STREAM_REJECT);
+    assert(elements[1].getStreamId() == info.getStreamId());
+}
+
+/*
+ * Read an edge list written by simulator/tools/topogen, one
+ * "<node> <node> <loss probability>" line per link. The loss is ignored, the
+ * scheduler works on the links reported by the nodes whatever their quality
+ */
+vector<pair<int,int>> readEdges(const char *path)
+{
+    ifstream in(path);
+    if(!in)
+    {
+        fprintf(stderr, "Can't open %s\n", path);
+        exit(1);
+    }
+    vector<pair<int,int>> edges;
+    string line;
+    while(getline(in, line))
+    {
+        line = line.substr(0, line.find('#'));
+        istringstream ss(line);
+        int a, b;
+        if(ss >> a >> b) edges.push_back(make_pair(a, b));
+    }
+    return edges;
+}
+
+/*
+ * Usage: scheduler_test [edges]
+ * Without arguments schedules a fixed 15 node network, otherwise the network
+ * of the edge list, in which all nodes open a stream to the master
+ */
+int main(int argc, char *argv[])
+{
+    vector<pair<int,int>> edges;
+    vector<int> sources;
+    int maxNodes = 16;
+    int maxHops = 6;
+    if(argc > 1)
+    {
+        edges = readEdges(argv[1]);
+        int nodes = 0;
+        for(auto& e : edges) nodes = max(nodes, max(e.first, e.second) + 1);
+        for(int i = 1; i < nodes; i++) sources.push_back(i);
+        maxNodes = max(maxNodes, (nodes + 7) / 8 * 8);
+        maxHops = max(maxHops, min(nodes - 1, 255));
+#ifdef TDMH_FIXED_MAX_NODES
+        if(maxNodes > TDMH_FIXED_MAX_NODES)
+        {
+            fprintf(stderr, "%s has more than TDMH_FIXED_MAX_NODES nodes\n", argv[1]);
+            exit(1);
+        }
+#endif
+    } else {
+        // Fake network topology
+        edges = {{0,1},{0,3},{0,5},{0,13},{0,14},{1,3},{1,5},{1,13},{1,14},
+                 {2,4},{2,6},{2,8},{3,5},{4,6},{4,8},{4,9},{4,14},{5,13},
+                 {5,14},{8,14},{9,10},{9,11},{9,14},{10,11},{10,14},{11,12},
+                 {12,13}};
+        sources = {1,3,4,5,8,9,10,11,12,13,14};
+    }
+    // The configuration must have the size the build was fixed to, see
+    // util/network_size.h
+#ifdef TDMH_FIXED_MAX_NODES
+    maxNodes = TDMH_FIXED_MAX_NODES;
+#endif
+#ifdef TDMH_FIXED_MAX_HOPS
+    maxHops = TDMH_FIXED_MAX_HOPS;
+#endif
     const NetworkConfiguration config(
         maxHops,       //maxHops
         maxNodes,      //maxNodes
@@ -61,84 +208,47 @@ int main()
     auto& streamCollection=*scheduler.getStreamCollection();
     NetworkTopology topology(config);
     scheduler.setTopology(&topology);
-    // Populate fake network topology
-    topology.addEdge(0,1);
-    topology.addEdge(0,3);
-    topology.addEdge(0,5);
-    topology.addEdge(0,13);
-    topology.addEdge(0,14);
-    topology.addEdge(1,3);
-    topology.addEdge(1,5);
-    topology.addEdge(1,13);
-    topology.addEdge(1,14);
-    topology.addEdge(2,4);
-    topology.addEdge(2,6);
-    topology.addEdge(2,8);
-    topology.addEdge(3,5);
-    topology.addEdge(4,6);
-    topology.addEdge(4,8);
-    topology.addEdge(4,9);
-    topology.addEdge(4,14);
-    topology.addEdge(5,13);
-    topology.addEdge(5,14);
-    topology.addEdge(8,14);
-    topology.addEdge(9,10);
-    topology.addEdge(9,11);
-    topology.addEdge(9,14);
-    topology.addEdge(10,11);
-    topology.addEdge(10,14);
-    topology.addEdge(11,12);
-    topology.addEdge(12,13);
+    for(auto& e : edges) topology.addEdge(e.first, e.second);
     // Populate fake servers and streams
     {
         UpdatableQueue<SMEKey, StreamManagementElement> smes;
         StreamParameters params = StreamParameters(4,4,10,0);
-        StreamStatus conn = StreamStatus::CONNECTING;
-        StreamManagementElement sme(
+        StreamManagementElement listen(
             StreamInfo(StreamId(0,0,0,1), params, StreamStatus::LISTEN_WAIT),
             SMEType::LISTEN
         );
-        StreamManagementElement sme2(StreamInfo(StreamId(1,0,0,1), params, conn),
-                                     SMEType::CONNECT);
-        StreamManagementElement sme3(StreamInfo(StreamId(3,0,0,1), params, conn),
-                                     SMEType::CONNECT);
-        StreamManagementElement sme4(StreamInfo(StreamId(4,0,0,1), params, conn),
-                                     SMEType::CONNECT);
-        StreamManagementElement sme5(StreamInfo(StreamId(5,0,0,1), params, conn),
-                                     SMEType::CONNECT);
-        StreamManagementElement sme6(StreamInfo(StreamId(8,0,0,1), params, conn),
-                                     SMEType::CONNECT);
-        StreamManagementElement sme7(StreamInfo(StreamId(9,0,0,1), params, conn),
-                                     SMEType::CONNECT);
-        StreamManagementElement sme8(StreamInfo(StreamId(10,0,0,1), params, conn),
-                                     SMEType::CONNECT);
-        StreamManagementElement sme9(StreamInfo(StreamId(11,0,0,1), params, conn),
-                                     SMEType::CONNECT);
-        StreamManagementElement sme10(StreamInfo(StreamId(12,0,0,1), params, conn),
-                                     SMEType::CONNECT);
-        StreamManagementElement sme11(StreamInfo(StreamId(13,0,0,1), params, conn),
-                                     SMEType::CONNECT);
-        StreamManagementElement sme12(StreamInfo(StreamId(14,0,0,1), params, conn),
-                                     SMEType::CONNECT);
-
-        smes.enqueue(sme.getKey(),sme);
-        smes.enqueue(sme2.getKey(),sme2);
-        smes.enqueue(sme3.getKey(),sme3);
-        smes.enqueue(sme4.getKey(),sme4);
-        smes.enqueue(sme5.getKey(),sme5);
-        smes.enqueue(sme6.getKey(),sme6);
-        smes.enqueue(sme7.getKey(),sme7);
-        smes.enqueue(sme8.getKey(),sme8);
-        smes.enqueue(sme9.getKey(),sme9);
-        smes.enqueue(sme10.getKey(),sme10);
-        smes.enqueue(sme11.getKey(),sme11);
-        smes.enqueue(sme12.getKey(),sme12);
+        smes.enqueue(listen.getKey(),listen);
+        for(int src : sources)
+        {
+            StreamManagementElement sme(
+                StreamInfo(StreamId(src,0,0,1), params, StreamStatus::CONNECTING),
+                SMEType::CONNECT
+            );
+            smes.enqueue(sme.getKey(),sme);
+        }
         streamCollection.receiveSMEs(smes);
     }
     scheduler.startThread();
     scheduler.sync();   
+    auto start = steady_clock::now();
     scheduler.beginScheduling();
     scheduler.sync();
+    auto elapsed = duration_cast<microseconds>(steady_clock::now() - start).count();
+    printf("[B] Scheduling took %lldus\n", static_cast<long long>(elapsed));
+
+    vector<ScheduleElement> schedule;
+    unsigned long id;
+    unsigned int tiles;
+    scheduler.getSchedule(schedule, id, tiles);
+    int fixedPackets = roundTripSchedule(schedule, false);
+    int compactPackets = roundTripSchedule(schedule, true);
+    printf("[B] Schedule of %d elements: %d packets, %d compact\n",
+           static_cast<int>(schedule.size()), fixedPackets, compactPackets);
+    if(schedule.size() >= 2)
+    {
+        testDeltaSchedulePacket(schedule, false);
+        testDeltaSchedulePacket(schedule, true);
+    }
     
     exit(1);
 }
@@ -0,0 +1,172 @@
+
+#include <iostream>
+#include <vector>
+#include <cassert>
+#include "uplink_phase/topology/topology_element.h"
+#include "uplink_phase/uplink_phase.h"
+#include "uplink_phase/uplink_message.h"
+#include "util/packet.h"
+
+using namespace std;
+using namespace mxnet;
+
+/*
+ * Serialize a TopologyElement, validate it in the packet as the receiver of an
+ * UplinkMessage does, deserialize it and compare every bit with operator[]
+ */
+void roundTrip(const TopologyElement& e, unsigned short maxNodes, bool weakTop)
+{
+    Packet pkt;
+    e.serialize(pkt);
+    assert(pkt.size() == e.size());
+    assert(TopologyElement::validateInPacket(pkt, 0, maxNodes, weakTop) == e.size());
+
+    TopologyElement d(maxNodes, weakTop);
+    d.deserialize(pkt);
+    assert(pkt.empty());
+    assert(d.getId() == e.getId());
+    for(unsigned i = 0; i < maxNodes; i++)
+    {
+        assert(d.getNeighbors()[i] == e.getNeighbors()[i]);
+        if(weakTop) assert(d.getWeakNeighbors()[i] == e.getWeakNeighbors()[i]);
+    }
+}
+
+void testTopologyElement(unsigned short maxNodes, bool weakTop)
+{
+    const unsigned bitmaskSize = maxNodes / 8;
+    const unsigned encodingSize = TopologyElement::useCompactEncoding(bitmaskSize) ? 1 : 0;
+
+    // A few neighbors spread over all the bytes, sent as a list of ids if
+    // the bitmask is large enough
+    TopologyElement sparse(5, maxNodes, weakTop);
+    for(unsigned i : {1u, 9u, maxNodes / 2u, maxNodes - 1u})
+    {
+        sparse.addNode(i);
+        if(weakTop) sparse.weakAddNode(maxNodes - 1 - i);
+    }
+    if(encodingSize != 0)
+        assert(sparse.size() == 1 + (weakTop ? 2 : 1) * (encodingSize + 4));
+    roundTrip(sparse, maxNodes, weakTop);
+
+    // Too many neighbors for a list, always sent as a bitmask
+    TopologyElement dense(maxNodes - 1, maxNodes, weakTop);
+    for(unsigned i = 0; i < maxNodes; i++)
+    {
+        if(i % 3 != 0) dense.addNode(i);
+        if(weakTop && i % 2 == 0) dense.weakAddNode(i);
+    }
+    assert(dense.size() == 1 + (weakTop ? 2 : 1) * (encodingSize + bitmaskSize));
+    roundTrip(dense, maxNodes, weakTop);
+}
+
+/*
+ * The live node bitmap sent by the master in the timesync packet has to be
+ * decoded by the other nodes to the same nodes, see UplinkPhase::setLiveNodes()
+ */
+void testLiveNodes(unsigned short maxNodes)
+{
+    RuntimeBitset live(maxNodes, false);
+    for(unsigned i = 0; i < maxNodes; i++)
+        if(i % 5 == 0 || i % 7 == 3) live[i] = true;
+    std::vector<unsigned char> data(maxNodes / 8);
+    UplinkPhase::encodeLiveNodes(live, data);
+    for(unsigned i = 0; i < maxNodes; i++)
+        assert(UplinkPhase::isLiveNode(data.data(), i) == live[i]);
+}
+
+/*
+ * Send an UplinkMessage with dense topologies through SendUplinkMessage and
+ * ReceiveUplinkMessage. With 256 nodes and weak topologies a dense element
+ * does not fit in the first packet, which is sent with the sender topology only
+ */
+void testUplinkMessage(unsigned short maxNodes, bool weakTop)
+{
+    const NetworkConfiguration config(
+        6,             //maxHops
+        maxNodes,      //maxNodes
+        0,             //networkId
+        false,         //staticHop
+        6,             //panId
+        5,             //txPower
+        2450,          //baseFrequency
+        10000000000,   //clockSyncPeriod
+        2,             //guaranteedTopologies
+        4,             //numUplinkPackets
+        100000000,     //tileDuration
+        150000,        //maxAdmittedRcvWindow
+        3,             //maxRoundsUnavailableBecomesDead
+        16,            //maxRoundsWeakLinkBecomesDead
+        -90,           //minNeighborRSSI
+        -100,          //minWeakNeighborRSSI
+        3,             //maxMissedTimesyncs
+        true,          //channelSpatialReuse
+        weakTop        //useWeakTopologies
+    );
+
+    TopologyElement myTopology(5, maxNodes, weakTop);
+    myTopology.addNode(4);
+    myTopology.addNode(maxNodes - 1);
+    UpdatableQueue<unsigned char,TopologyElement> topologies;
+    std::vector<TopologyElement> sent;
+    for(unsigned char id : {7, 9})
+    {
+        TopologyElement dense(id, maxNodes, weakTop);
+        for(unsigned i = 0; i < maxNodes; i++)
+        {
+            if(i % 3 != 0) dense.addNode(i);
+            if(weakTop && i % 2 == 0) dense.weakAddNode(i);
+        }
+        sent.push_back(dense);
+        topologies.enqueue(id, std::move(dense));
+    }
+    const bool firstEmpty = static_cast<int>(sent[0].size()) > getFirstUplinkPacketCapacity(config);
+    UpdatableQueue<SMEKey,StreamManagementElement> smes;
+
+    SendUplinkMessage tx(config, 1, false, 0, myTopology, topologies, 2, 0, 0);
+    ReceiveUplinkMessage rx(config);
+    UpdatableQueue<unsigned char,TopologyElement> received;
+    UpdatableQueue<SMEKey,StreamManagementElement> receivedSMEs;
+    for(int i = 0; i < tx.getNumPackets(); i++)
+    {
+        tx.serializeTopologiesAndSMEs(topologies, smes);
+        assert(rx.recv(config, tx.send()));
+        if(i == 0) assert((rx.getNumPacketTopologies() == 0) == firstEmpty);
+        rx.deserializeTopologiesAndSMEs(received, receivedSMEs);
+    }
+    assert(rx.hasMorePackets() == false);
+    assert(topologies.size() == 0);
+
+    TopologyElement sender = rx.getSenderTopology(5);
+    for(unsigned i = 0; i < maxNodes; i++)
+        assert(sender.getNeighbors()[i] == myTopology.getNeighbors()[i]);
+    assert(received.size() == sent.size());
+    for(auto& e : sent)
+    {
+        TopologyElement d = received.dequeue();
+        assert(d.getId() == e.getId());
+        for(unsigned i = 0; i < maxNodes; i++)
+        {
+            assert(d.getNeighbors()[i] == e.getNeighbors()[i]);
+            if(weakTop) assert(d.getWeakNeighbors()[i] == e.getWeakNeighbors()[i]);
+        }
+    }
+}
+
+int main()
+{
+    for(bool weakTop : {false, true})
+    {
+        testTopologyElement(16, weakTop);
+        testTopologyElement(128, weakTop);
+        testTopologyElement(256, weakTop);
+    }
+    testLiveNodes(16);
+    testLiveNodes(256);
+    testUplinkMessage(16, true);
+    testUplinkMessage(256, false);
+    testUplinkMessage(256, true);
+
+    cout<<"ok"<<endl;
+    return 0;
+}